@@ -0,0 +1,134 @@
+/*
+ * confluent-kafka-javascript - Node.js wrapper  for RdKafka C/C++ library
+ *
+ * Copyright (c) 2024 Confluent, Inc.
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE.txt file for details.
+ */
+
+/*
+ * Record consumer traffic once, then replay it offline as often as needed.
+ *
+ *   node bench/consumer-replay.js record <host> <topic> <file> [messages]
+ *   node bench/consumer-replay.js replay <file> [speed] [mode]
+ *
+ * speed is 0 (as fast as possible, the default) or a multiple of the
+ * original pace. mode is "batch" (consume(n), the default) or "loop"
+ * (consume() with 'data' events).
+ */
+
+var Kafka = require('../');
+
+var command = process.argv[2];
+
+if (command === 'record') {
+  record(process.argv[3] || 'localhost:9092', process.argv[4] || 'test',
+    process.argv[5] || 'consumer.capture', parseInt(process.argv[6], 10) || 100000);
+} else if (command === 'replay') {
+  replay(process.argv[3] || 'consumer.capture', parseFloat(process.argv[4]) || 0,
+    process.argv[5] || 'batch');
+} else {
+  console.error('Usage: consumer-replay.js record <host> <topic> <file> [messages]');
+  console.error('       consumer-replay.js replay <file> [speed] [batch|loop]');
+  process.exit(1);
+}
+
+function record(host, topic, file, messages) {
+  var received = 0;
+  var consumer = new Kafka.KafkaConsumer({
+    'metadata.broker.list': host,
+    'group.id': 'confluent-kafka-javascript-bench-capture',
+    'enable.auto.commit': false
+  }, {
+    'auto.offset.reset': 'earliest'
+  });
+
+  consumer.connect()
+    .once('ready', function() {
+      consumer.startCapture(file);
+      consumer.subscribe([topic]);
+      consumer.consume();
+    })
+    .on('data', function() {
+      received += 1;
+      if (received === messages) {
+        consumer.stopCapture();
+        console.log('Recorded %d messages to %s', received, file);
+        consumer.disconnect();
+      }
+    });
+}
+
+function replay(file, speed, mode) {
+  var received = 0;
+  var bytes = 0;
+  var start;
+  var end;
+
+  // Connect to an in-process mock cluster so that no broker is needed.
+  var consumer = new Kafka.KafkaConsumer({
+    'test.mock.num.brokers': 1,
+    'group.id': 'confluent-kafka-javascript-bench-replay',
+    'log_level': 0
+  }, {});
+
+  function done() {
+    var seconds = Number(end - start) / 1e9;
+    console.log('Replayed %d messages (%s MB) in %s s: %d messages per second',
+      received, (bytes / (1024 * 1024)).toFixed(2), seconds.toFixed(3),
+      Math.round(received / seconds));
+    consumer.stopReplay();
+    consumer.disconnect();
+  }
+
+  consumer.connect()
+    .once('ready', function() {
+      // Once the capture is exhausted consume times out, so keep that short
+      // unless the replay is paced.
+      consumer.setDefaultConsumeTimeout(speed > 0 ? 1000 : 10);
+      consumer.startReplay(file, { speed: speed });
+      start = process.hrtime.bigint();
+
+      if (mode === 'loop') {
+        consumer.on('data', function(message) {
+          received += 1;
+          bytes += message.size;
+        });
+        // The capture is exhausted once nothing arrived for 100ms.
+        var last = 0;
+        var idle = 0;
+        var interval = setInterval(function() {
+          if (received !== last) {
+            last = received;
+            idle = 0;
+            end = process.hrtime.bigint();
+          } else if (received > 0 && ++idle >= 10) {
+            clearInterval(interval);
+            done();
+          }
+        }, 10);
+        consumer.consume();
+        return;
+      }
+
+      (function next() {
+        consumer.consume(1000, function(err, messages) {
+          if (err) {
+            console.error(err);
+            return;
+          }
+          if (messages.length === 0) {
+            done();
+            return;
+          }
+          for (var i = 0; i < messages.length; i++) {
+            bytes += messages[i].size;
+          }
+          received += messages.length;
+          end = process.hrtime.bigint();
+          setImmediate(next);
+        });
+      })();
+    });
+}
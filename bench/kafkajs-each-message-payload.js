@@ -0,0 +1,129 @@
+/*
+ * confluent-kafka-javascript - Node.js wrapper  for RdKafka C/C++ library
+ *
+ * Copyright (c) 2024 Confluent, Inc.
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE.txt file for details.
+ */
+
+/*
+ * Compares the allocation cost of KafkaJS eachMessage payloads built the
+ * previous way (eager object literals and closures per message) against the
+ * current lazily converted payloads, reporting throughput and the number and
+ * total duration of garbage collections.
+ *
+ *   node bench/kafkajs-each-message-payload.js [messages]
+ */
+
+var PerformanceObserver = require('perf_hooks').PerformanceObserver;
+var payloads = require('../lib/kafkajs/_consumer_payload');
+
+var count = parseInt(process.argv[2], 10) || 5000000;
+
+var messages = [];
+for (var i = 0; i < 1024; i++) {
+  messages.push({
+    topic: 'bench',
+    partition: i % 8,
+    key: Buffer.from('key-' + i),
+    value: Buffer.alloc(64, 'v'),
+    offset: i,
+    timestamp: 1700000000000 + i,
+    size: 64,
+    leaderEpoch: 0,
+    headers: i % 4 === 0 ? [{ trace: Buffer.from('id-' + i) }] : undefined,
+  });
+}
+
+function pause() {}
+var pauses = [];
+for (var p = 0; p < 8; p++) {
+  pauses.push(pause.bind(null, [{ topic: 'bench', partitions: [p] }]));
+}
+
+// The eachMessage payload as it was built before lazy conversion.
+function legacyPayload(message) {
+  var key = message.key;
+  if (typeof key === 'string') {
+    key = Buffer.from(key);
+  }
+  return {
+    topic: message.topic,
+    partition: message.partition,
+    message: {
+      key: key,
+      value: message.value,
+      timestamp: message.timestamp ? String(message.timestamp) : '',
+      attributes: 0,
+      offset: String(message.offset),
+      size: message.size,
+      leaderEpoch: message.leaderEpoch,
+      headers: payloads.createHeaders(message.headers),
+    },
+    heartbeat: async function() { /* no op */ },
+    pause: pause.bind(null, [{ topic: message.topic, partitions: [message.partition] }]),
+  };
+}
+
+function currentPayload(message) {
+  return payloads.createEachMessagePayload(message, pauses[message.partition]);
+}
+
+var handlers = {
+  'value only': function(payload) {
+    return payload.message.value.length;
+  },
+  'offset and headers': function(payload) {
+    return payload.message.value.length + payload.message.offset.length +
+      (payload.message.headers ? 1 : 0);
+  },
+};
+
+var gcs = [];
+var observer = new PerformanceObserver(function(list) {
+  gcs.push.apply(gcs, list.getEntries());
+});
+observer.observe({ entryTypes: ['gc'] });
+
+// Handlers commonly hand the payload to async code; keep the last few alive
+// so that the optimizer can't elide their allocation.
+var retained = new Array(64);
+
+function run(build, handler) {
+  var sink = 0;
+  gcs.length = 0;
+  var start = process.hrtime.bigint();
+  for (var n = 0; n < count; n++) {
+    var payload = build(messages[n & 1023]);
+    retained[n & 63] = payload;
+    sink += handler(payload);
+  }
+  var seconds = Number(process.hrtime.bigint() - start) / 1e9;
+  return { seconds: seconds, sink: sink };
+}
+
+function report(label, result) {
+  // GC entries are delivered asynchronously, give them time to arrive.
+  return new Promise(function(resolve) {
+    setTimeout(function() {
+      var gcMs = gcs.reduce(function(total, entry) { return total + entry.duration; }, 0);
+      console.log('%s: %d payloads/s, %d GCs, %s ms in GC', label,
+        Math.round(count / result.seconds), gcs.length, gcMs.toFixed(1));
+      resolve();
+    }, 100);
+  });
+}
+
+(async function() {
+  for (var name in handlers) {
+    // Warm up both builders before measuring.
+    run(legacyPayload, handlers[name]);
+    run(currentPayload, handlers[name]);
+    await new Promise(function(resolve) { setTimeout(resolve, 100); });
+
+    await report('legacy  (' + name + ')', run(legacyPayload, handlers[name]));
+    await report('current (' + name + ')', run(currentPayload, handlers[name]));
+  }
+  observer.disconnect();
+})();
@@ -0,0 +1,137 @@
+/*
+ * confluent-kafka-javascript - Node.js wrapper  for RdKafka C/C++ library
+ *
+ * Copyright (c) 2024 Confluent, Inc.
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE.txt file for details.
+ */
+
+/*
+ * Self-contained benchmark suite running against librdkafka's in-process
+ * mock cluster, so that no broker is needed and numbers are comparable
+ * between machines.
+ *
+ * Usage:
+ *   node bench/mock-cluster [--scenarios=produce,consume,...] [--messages=N]
+ *                           [--size=BYTES] [--partitions=N] [--brokers=N]
+ *                           [--output=results.json]
+ *
+ * Scenarios: produce, produce-slow-broker, consume, round-trip,
+ *            kafkajs-each-message, kafkajs-each-batch, admin. All are run
+ *            by default.
+ *
+ * Results are written as JSON with, per scenario, throughput, p50/p99
+ * latency, CPU time, RSS and event-loop lag.
+ */
+
+const fs = require('fs');
+const os = require('os');
+const Kafka = require('../../');
+const mockCluster = require('./mock-cluster');
+const scenarios = require('./scenarios');
+const { ResourceMonitor } = require('./stats');
+
+function parseArgs(argv) {
+  const args = {};
+  for (const arg of argv) {
+    const match = /^--([^=]+)=(.*)$/.exec(arg);
+    if (match) {
+      args[match[1]] = match[2];
+    }
+  }
+
+  return {
+    scenarios: args.scenarios ? args.scenarios.split(',') : Object.keys(scenarios),
+    messages: parseInt(args.messages ?? '100000', 10),
+    messageSize: parseInt(args.size ?? '256', 10),
+    partitions: parseInt(args.partitions ?? '3', 10),
+    brokers: parseInt(args.brokers ?? '3', 10),
+    output: args.output ?? 'mock-cluster-results.json',
+  };
+}
+
+async function runScenario(name, options, cluster) {
+  const bootstrapServers = cluster.bootstrapServers;
+  const topic = `bench-${name}-${Date.now()}`;
+  await mockCluster.createTopic(bootstrapServers, topic, options.partitions);
+
+  const ctx = {
+    bootstrapServers,
+    cluster: cluster.cluster,
+    topic,
+    messages: options.messages,
+    messageSize: options.messageSize,
+    partitions: options.partitions,
+  };
+
+  const scenario = scenarios[name];
+  if (scenario.setup) {
+    await scenario.setup(ctx);
+  }
+
+  const monitor = new ResourceMonitor();
+  monitor.start();
+  const result = await scenario(ctx);
+  const resources = monitor.stop();
+
+  const seconds = resources.wallMs / 1000;
+  return {
+    scenario: name,
+    messages: result.messages,
+    bytes: result.bytes,
+    throughput: {
+      messagesPerSecond: Math.round(result.messages / seconds),
+      megabytesPerSecond: Math.round((result.bytes / (1024 * 1024) / seconds) * 100) / 100,
+    },
+    latency: result.latency ? result.latency.summary() : null,
+    ...resources,
+  };
+}
+
+async function main() {
+  const options = parseArgs(process.argv.slice(2));
+  for (const name of options.scenarios) {
+    if (!scenarios[name]) {
+      throw new Error(`Unknown scenario "${name}". Known: ${Object.keys(scenarios).join(', ')}`);
+    }
+  }
+
+  const cluster = await mockCluster.start(options.brokers);
+  const results = [];
+
+  try {
+    for (const name of options.scenarios) {
+      console.log(`Running ${name}...`);
+      const result = await runScenario(name, options, cluster);
+      const latency = result.latency ? `, p50 ${result.latency.p50Ms} ms, p99 ${result.latency.p99Ms} ms` : '';
+      console.log(`  ${result.throughput.messagesPerSecond} msgs/s${latency}, ` +
+                  `cpu ${result.cpu.percent}%, peak rss ${Math.round(result.rss.peakBytes / (1024 * 1024))} MB, ` +
+                  `event loop p99 ${result.eventLoopLag.p99Ms} ms`);
+      results.push(result);
+    }
+  } finally {
+    await cluster.stop();
+  }
+
+  const report = {
+    timestamp: new Date().toISOString(),
+    environment: {
+      node: process.version,
+      librdkafka: Kafka.librdkafkaVersion,
+      platform: `${os.platform()} ${os.release()} ${os.arch()}`,
+      cpu: os.cpus()[0]?.model,
+      cpuCount: os.cpus().length,
+    },
+    options,
+    results,
+  };
+
+  fs.writeFileSync(options.output, JSON.stringify(report, null, 2));
+  console.log(`Results written to ${options.output}`);
+}
+
+main().catch(err => {
+  console.error(err);
+  process.exit(1);
+});
@@ -0,0 +1,61 @@
+/*
+ * confluent-kafka-javascript - Node.js wrapper  for RdKafka C/C++ library
+ *
+ * Copyright (c) 2024 Confluent, Inc.
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE.txt file for details.
+ */
+
+const Kafka = require('../../');
+
+/**
+ * Start an in-process librdkafka mock cluster.
+ *
+ * The cluster is owned by a dedicated producer handle created with
+ * `test.mock.num.brokers`; every benchmark client then connects to the
+ * cluster through its bootstrap servers like it would to a real one.
+ *
+ * @param {number} brokerCount - Number of mock brokers.
+ * @returns {Promise<{bootstrapServers: string, cluster: Kafka.MockCluster, stop: function(): Promise<void>}>}
+ */
+function start(brokerCount) {
+  return new Promise((resolve, reject) => {
+    const owner = new Kafka.Producer({
+      'test.mock.num.brokers': brokerCount,
+      'client.id': 'mock-cluster-owner',
+    });
+
+    owner.connect({}, err => {
+      if (err) {
+        reject(err);
+        return;
+      }
+      const cluster = owner.getMockCluster();
+      resolve({
+        bootstrapServers: cluster.bootstrapServers(),
+        cluster,
+        stop: () => new Promise(res => owner.disconnect(() => res())),
+      });
+    });
+  });
+}
+
+/**
+ * Create a topic on the cluster with the given number of partitions.
+ */
+function createTopic(bootstrapServers, topic, partitions) {
+  const admin = Kafka.AdminClient.create({ 'bootstrap.servers': bootstrapServers });
+  return new Promise((resolve, reject) => {
+    admin.createTopic({ topic, num_partitions: partitions, replication_factor: 1 }, err => {
+      admin.disconnect();
+      if (err) {
+        reject(err);
+      } else {
+        resolve();
+      }
+    });
+  });
+}
+
+module.exports = { start, createTopic };
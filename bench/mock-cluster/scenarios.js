@@ -0,0 +1,326 @@
+/*
+ * confluent-kafka-javascript - Node.js wrapper  for RdKafka C/C++ library
+ *
+ * Copyright (c) 2024 Confluent, Inc.
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE.txt file for details.
+ */
+
+const Kafka = require('../../');
+const { Kafka: KafkaJS, logLevel } = Kafka.KafkaJS;
+const { LatencyRecorder } = require('./stats');
+
+/*
+ * Every scenario is an async function taking a context object:
+ *   { bootstrapServers, cluster, topic, messages, messageSize, partitions }
+ * and resolving to { messages, bytes, latency }, where `latency` is a
+ * LatencyRecorder (or null if the scenario has no per-operation latency).
+ * `cluster` is the MockCluster, for injecting latency and faults. The topic
+ * is created by the runner before the scenario starts.
+ *
+ * A scenario may have a `setup` function, taking the same context, which the
+ * runner awaits before it starts measuring, e.g. to seed the topic.
+ */
+
+const QUEUE_FULL = Kafka.CODES.ERRORS.ERR__QUEUE_FULL;
+
+function createProducer(ctx, extraConfig = {}) {
+  const producer = new Kafka.Producer({
+    'bootstrap.servers': ctx.bootstrapServers,
+    'dr_cb': true,
+    'linger.ms': 5,
+    ...extraConfig,
+  });
+  producer.setPollInterval(5);
+  return new Promise((resolve, reject) => {
+    producer.connect({}, err => (err ? reject(err) : resolve(producer)));
+  });
+}
+
+function disconnect(client) {
+  return new Promise(resolve => client.disconnect(() => resolve()));
+}
+
+/**
+ * Produce `count` messages as fast as the local queue allows. `makePayload`
+ * is called for every message, `onDelivery` for every delivery report.
+ * Resolves once all messages have been delivered.
+ */
+function produceAll(producer, topic, count, makePayload, onDelivery = () => {}) {
+  return new Promise((resolve, reject) => {
+    let produced = 0;
+    let delivered = 0;
+
+    producer.on('delivery-report', (err, report) => {
+      if (err) {
+        producer.removeAllListeners('delivery-report');
+        reject(err);
+        return;
+      }
+      onDelivery(report);
+      if (++delivered === count) {
+        producer.removeAllListeners('delivery-report');
+        resolve();
+      }
+    });
+
+    const produceSome = () => {
+      while (produced < count) {
+        const start = process.hrtime.bigint();
+        try {
+          producer.produce(topic, null, makePayload(), null, null, start);
+        } catch (e) {
+          if (e.code === QUEUE_FULL) {
+            setTimeout(produceSome, 1);
+            return;
+          }
+          reject(e);
+          return;
+        }
+        produced++;
+      }
+    };
+
+    produceSome();
+  });
+}
+
+/* Payloads carry their send time in the first 8 bytes for end-to-end latency. */
+function timestampedPayload(size) {
+  const payload = Buffer.alloc(Math.max(size, 8), 'x');
+  payload.writeBigUInt64BE(process.hrtime.bigint(), 0);
+  return payload;
+}
+
+function payloadSendTime(value) {
+  return value.readBigUInt64BE(0);
+}
+
+async function seed(ctx) {
+  const producer = await createProducer(ctx);
+  const payload = Buffer.alloc(ctx.messageSize, 'x');
+  await produceAll(producer, ctx.topic, ctx.messages, () => payload);
+  await disconnect(producer);
+}
+
+/**
+ * Producer throughput. Latency is produce() to delivery report.
+ */
+async function produce(ctx) {
+  const latency = new LatencyRecorder();
+  const producer = await createProducer(ctx);
+  const payload = Buffer.alloc(ctx.messageSize, 'x');
+
+  await produceAll(producer, ctx.topic, ctx.messages, () => payload,
+    report => latency.recordSince(report.opaque));
+  await disconnect(producer);
+
+  return { messages: ctx.messages, bytes: ctx.messages * ctx.messageSize, latency };
+}
+
+/**
+ * Producer throughput with a 50ms round-trip time on every broker, which
+ * exposes how well produce requests are pipelined.
+ */
+async function produceSlowBroker(ctx) {
+  const brokers = ctx.cluster.bootstrapServers().split(',').length;
+  for (let id = 1; id <= brokers; id++) {
+    ctx.cluster.setBrokerRtt(id, 50);
+  }
+  try {
+    return await produce(ctx);
+  } finally {
+    for (let id = 1; id <= brokers; id++) {
+      ctx.cluster.setBrokerRtt(id, 0);
+    }
+  }
+}
+
+/**
+ * Consumer throughput from a pre-seeded topic using batched consume().
+ * Latency is the duration of each consume() call.
+ */
+async function consume(ctx) {
+  const latency = new LatencyRecorder();
+  const consumer = new Kafka.KafkaConsumer({
+    'bootstrap.servers': ctx.bootstrapServers,
+    'group.id': `${ctx.topic}-group`,
+    'enable.auto.commit': false,
+  }, {
+    'auto.offset.reset': 'earliest',
+  });
+
+  await new Promise((resolve, reject) => consumer.connect({}, err => (err ? reject(err) : resolve())));
+  consumer.subscribe([ctx.topic]);
+
+  let received = 0;
+  let bytes = 0;
+  await new Promise((resolve, reject) => {
+    const next = () => {
+      const start = process.hrtime.bigint();
+      consumer.consume(1000, (err, messages) => {
+        if (err) {
+          reject(err);
+          return;
+        }
+        if (messages.length > 0) {
+          latency.recordSince(start);
+        }
+        for (const message of messages) {
+          bytes += message.size;
+        }
+        received += messages.length;
+        if (received >= ctx.messages) {
+          resolve();
+        } else {
+          setImmediate(next);
+        }
+      });
+    };
+    next();
+  });
+
+  await disconnect(consumer);
+  return { messages: received, bytes, latency };
+}
+consume.setup = seed;
+
+/**
+ * Produce and consume concurrently with the non-promisified API.
+ * Latency is end-to-end, from produce() to the 'data' event.
+ */
+async function roundTrip(ctx) {
+  const latency = new LatencyRecorder();
+  const consumer = new Kafka.KafkaConsumer({
+    'bootstrap.servers': ctx.bootstrapServers,
+    'group.id': `${ctx.topic}-group`,
+    'enable.auto.commit': false,
+    'fetch.wait.max.ms': 10,
+  }, {
+    'auto.offset.reset': 'earliest',
+  });
+
+  await new Promise((resolve, reject) => consumer.connect({}, err => (err ? reject(err) : resolve())));
+  consumer.subscribe([ctx.topic]);
+
+  let received = 0;
+  const done = new Promise(resolve => {
+    consumer.on('data', message => {
+      latency.recordSince(payloadSendTime(message.value));
+      if (++received === ctx.messages) {
+        resolve();
+      }
+    });
+  });
+  consumer.consume();
+
+  const producer = await createProducer(ctx, { 'linger.ms': 0 });
+  await produceAll(producer, ctx.topic, ctx.messages, () => timestampedPayload(ctx.messageSize));
+  await done;
+
+  await disconnect(producer);
+  await disconnect(consumer);
+  return { messages: received, bytes: received * ctx.messageSize, latency };
+}
+
+function kafkaJSClient(ctx) {
+  return new KafkaJS({
+    kafkaJS: {
+      brokers: ctx.bootstrapServers.split(','),
+      logLevel: logLevel.NOTHING,
+    },
+  });
+}
+
+async function kafkaJSConsume(ctx, runConfig) {
+  const latency = new LatencyRecorder();
+  const kafka = kafkaJSClient(ctx);
+  const consumer = kafka.consumer({
+    kafkaJS: { groupId: `${ctx.topic}-group`, fromBeginning: true },
+  });
+
+  await consumer.connect();
+  await consumer.subscribe({ topic: ctx.topic });
+
+  let received = 0;
+  let resolveDone;
+  const done = new Promise(resolve => { resolveDone = resolve; });
+  const onMessage = message => {
+    latency.recordSince(payloadSendTime(message.value));
+    if (++received === ctx.messages) {
+      resolveDone();
+    }
+  };
+  consumer.run(runConfig(onMessage));
+
+  const producer = await createProducer(ctx, { 'linger.ms': 0 });
+  await produceAll(producer, ctx.topic, ctx.messages, () => timestampedPayload(ctx.messageSize));
+  await done;
+
+  await disconnect(producer);
+  await consumer.disconnect();
+  return { messages: received, bytes: received * ctx.messageSize, latency };
+}
+
+/**
+ * KafkaJS-compatible consumer with eachMessage. Latency is end-to-end.
+ */
+function kafkaJSEachMessage(ctx) {
+  return kafkaJSConsume(ctx, onMessage => ({
+    eachMessage: async ({ message }) => onMessage(message),
+  }));
+}
+
+/**
+ * KafkaJS-compatible consumer with eachBatch. Latency is end-to-end.
+ */
+function kafkaJSEachBatch(ctx) {
+  return kafkaJSConsume(ctx, onMessage => ({
+    eachBatch: async ({ batch }) => {
+      for (const message of batch.messages) {
+        onMessage(message);
+      }
+    },
+  }));
+}
+
+/**
+ * KafkaJS-compatible admin operations. `messages` is the number of admin
+ * round trips; latency is per operation.
+ */
+async function admin(ctx) {
+  const latency = new LatencyRecorder();
+  const kafka = kafkaJSClient(ctx);
+  const client = kafka.admin();
+  await client.connect();
+
+  const iterations = Math.max(1, Math.floor(ctx.messages / 10000));
+  let operations = 0;
+  const timed = async fn => {
+    const start = process.hrtime.bigint();
+    await fn();
+    latency.recordSince(start);
+    operations++;
+  };
+
+  for (let i = 0; i < iterations; i++) {
+    const topic = `${ctx.topic}-admin-${i}`;
+    await timed(() => client.createTopics({ topics: [{ topic, numPartitions: ctx.partitions }] }));
+    await timed(() => client.fetchTopicMetadata({ topics: [topic] }));
+    await timed(() => client.listTopics());
+  }
+
+  await client.disconnect();
+  return { messages: operations, bytes: 0, latency };
+}
+
+module.exports = {
+  'produce': produce,
+  'produce-slow-broker': produceSlowBroker,
+  'consume': consume,
+  'round-trip': roundTrip,
+  'kafkajs-each-message': kafkaJSEachMessage,
+  'kafkajs-each-batch': kafkaJSEachBatch,
+  'admin': admin,
+};
@@ -0,0 +1,118 @@
+/*
+ * confluent-kafka-javascript - Node.js wrapper  for RdKafka C/C++ library
+ *
+ * Copyright (c) 2024 Confluent, Inc.
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE.txt file for details.
+ */
+
+const { monitorEventLoopDelay } = require('perf_hooks');
+
+const NS_PER_MS = 1e6;
+
+/**
+ * Records latency samples (in milliseconds) and summarizes them.
+ */
+class LatencyRecorder {
+  #samples = [];
+
+  record(ms) {
+    this.#samples.push(ms);
+  }
+
+  /**
+   * Record the time elapsed since `startNs`, a value returned by
+   * `process.hrtime.bigint()`.
+   */
+  recordSince(startNs) {
+    this.#samples.push(Number(process.hrtime.bigint() - startNs) / NS_PER_MS);
+  }
+
+  get count() {
+    return this.#samples.length;
+  }
+
+  summary() {
+    const count = this.#samples.length;
+    if (count === 0) {
+      return null;
+    }
+
+    const sorted = Float64Array.from(this.#samples).sort();
+    const percentile = p => sorted[Math.min(count - 1, Math.floor((p / 100) * count))];
+    let sum = 0;
+    for (let i = 0; i < count; i++) {
+      sum += sorted[i];
+    }
+
+    return {
+      count,
+      meanMs: round(sum / count),
+      p50Ms: round(percentile(50)),
+      p99Ms: round(percentile(99)),
+      maxMs: round(sorted[count - 1]),
+    };
+  }
+}
+
+/**
+ * Samples process-level resource usage for the duration of a scenario:
+ * CPU time, resident set size and event-loop lag.
+ */
+class ResourceMonitor {
+  #histogram = null;
+  #rssTimer = null;
+  #rssPeak = 0;
+  #cpuStart = null;
+  #wallStart = 0n;
+
+  start() {
+    this.#histogram = monitorEventLoopDelay({ resolution: 10 });
+    this.#histogram.enable();
+    this.#rssPeak = process.memoryUsage.rss();
+    this.#rssTimer = setInterval(() => {
+      this.#rssPeak = Math.max(this.#rssPeak, process.memoryUsage.rss());
+    }, 100);
+    this.#rssTimer.unref();
+    this.#cpuStart = process.cpuUsage();
+    this.#wallStart = process.hrtime.bigint();
+  }
+
+  stop() {
+    const wallMs = Number(process.hrtime.bigint() - this.#wallStart) / NS_PER_MS;
+    const cpu = process.cpuUsage(this.#cpuStart);
+    clearInterval(this.#rssTimer);
+    this.#histogram.disable();
+
+    const rss = process.memoryUsage.rss();
+    this.#rssPeak = Math.max(this.#rssPeak, rss);
+
+    const h = this.#histogram;
+    return {
+      wallMs: round(wallMs),
+      cpu: {
+        userMs: round(cpu.user / 1000),
+        systemMs: round(cpu.system / 1000),
+        // Can exceed 100 as librdkafka runs its own threads.
+        percent: round(((cpu.user + cpu.system) / 1000) / wallMs * 100),
+      },
+      rss: {
+        endBytes: rss,
+        peakBytes: this.#rssPeak,
+      },
+      eventLoopLag: {
+        meanMs: round(h.mean / NS_PER_MS),
+        p50Ms: round(h.percentile(50) / NS_PER_MS),
+        p99Ms: round(h.percentile(99) / NS_PER_MS),
+        maxMs: round(h.max / NS_PER_MS),
+      },
+    };
+  }
+}
+
+function round(n) {
+  return Math.round(n * 1000) / 1000;
+}
+
+module.exports = { LatencyRecorder, ResourceMonitor };
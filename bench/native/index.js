@@ -0,0 +1,66 @@
+/*
+ * confluent-kafka-javascript - Node.js wrapper  for RdKafka C/C++ library
+ *
+ * Copyright (c) 2024 Confluent, Inc.
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE.txt file for details.
+ */
+
+/*
+ * Runs the native microbenchmarks in bench/native/microbench.cc.
+ *
+ * The microbenchmark addon is only built on request:
+ *   CKJS_BUILD_MICROBENCH=1 npx node-gyp rebuild
+ *   node bench/native [iterations] [--json]
+ */
+
+var path = require('path');
+var bindings = require('bindings');
+
+var bench = bindings({
+  bindings: 'confluent-kafka-javascript-microbench',
+  module_root: path.resolve(__dirname, '..', '..'),
+});
+
+var args = process.argv.slice(2);
+var json = args.indexOf('--json') !== -1;
+var iterations = parseInt(args.filter(function (a) { return a !== '--json'; })[0], 10) || 100000;
+
+var headers = [];
+for (var i = 0; i < 4; i++) {
+  var header = {};
+  header['header-' + i] = i % 2 ? Buffer.from('header-value') : 'header-value';
+  headers.push(header);
+}
+
+var cases = [
+  ['ToV8Object, 256B, no headers', function () { return bench.toV8Object(iterations, 256, 0); }],
+  ['ToV8Object, 256B, 4 headers', function () { return bench.toV8Object(iterations, 256, 4); }],
+  ['ToV8Object, 64KB, no headers', function () { return bench.toV8Object(iterations, 65536, 0); }],
+  ['DeliveryReport, 256B', function () { return bench.deliveryReport(iterations, 256); }],
+  ['DeliveryReportDispatcher::Flush, 256B', function () {
+    return bench.deliveryReportFlush(iterations, 256, function () {});
+  }],
+  ['NodeProduce headers, 4 headers', function () { return bench.headers(iterations, headers); }],
+  ['TopicPartitionListToV8Array, 16 partitions', function () {
+    return bench.topicPartitionListToV8Array(iterations, 16);
+  }],
+];
+
+var results = cases.map(function (c) {
+  // Warm up with a full run so the first case is not penalized.
+  c[1]();
+  var result = c[1]();
+  result.name = c[0];
+  return result;
+});
+
+if (json) {
+  console.log(JSON.stringify(results, null, 2));
+} else {
+  results.forEach(function (r) {
+    console.log(r.name + ': ' + r.nsPerOp.toFixed(1) + ' ns/op, ' +
+                r.allocsPerOp.toFixed(2) + ' allocs/op');
+  });
+}
@@ -0,0 +1,303 @@
+/*
+ * confluent-kafka-javascript - Node.js wrapper  for RdKafka C/C++ library
+ *
+ * Copyright (c) 2024 Confluent, Inc.
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE.txt file for details.
+ */
+
+/*
+ * Microbenchmarks for the conversion and dispatch hot paths of the addon.
+ *
+ * This is built as a separate addon (see the microbench target in
+ * binding.gyp) which links the same sources as the real one, minus its
+ * module entry point. Every benchmark drives one function with synthetic
+ * messages, so no broker is involved, and returns ns/op and allocs/op.
+ *
+ * Allocations are counted by replacing the global operator new for this
+ * module. malloc() calls (used for delivery report key and payload copies)
+ * and allocations made by V8 itself are not included.
+ */
+
+#include <nan.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "src/common.h"
+#include "src/callbacks.h"
+
+static std::atomic<size_t> g_allocations(0);
+
+void* operator new(size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  void* ptr = malloc(size == 0 ? 1 : size);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+  free(ptr);
+}
+
+namespace NodeKafka {
+namespace Bench {
+
+/**
+ * @brief A message which is not backed by librdkafka.
+ *
+ * Only the accessors used by the conversion paths return meaningful values.
+ * Headers are owned by the message, like they are for a consumed one.
+ */
+class SyntheticMessage : public RdKafka::Message {
+ public:
+  SyntheticMessage(const std::string &topic, size_t payload_size,
+                   size_t key_size, int header_count) :
+    m_topic(topic),
+    m_payload(payload_size, 'v'),
+    m_key(key_size, 'k'),
+    m_headers(NULL) {
+    if (header_count > 0) {
+      m_headers = RdKafka::Headers::create();
+      for (int i = 0; i < header_count; i++) {
+        m_headers->add("header-" + std::to_string(i), "header-value");
+      }
+    }
+  }
+
+  ~SyntheticMessage() {
+    delete m_headers;
+  }
+
+  std::string errstr() const { return ""; }
+  RdKafka::ErrorCode err() const { return RdKafka::ERR_NO_ERROR; }
+  RdKafka::Topic *topic() const { return NULL; }
+  std::string topic_name() const { return m_topic; }
+  int32_t partition() const { return 3; }
+  void *payload() const {
+    return m_payload.empty() ? NULL : const_cast<char*>(m_payload.data());
+  }
+  size_t len() const { return m_payload.size(); }
+  const std::string *key() const { return &m_key; }
+  const void *key_pointer() const {
+    return m_key.empty() ? NULL : m_key.data();
+  }
+  size_t key_len() const { return m_key.size(); }
+  int64_t offset() const { return 123456789; }
+  RdKafka::MessageTimestamp timestamp() const {
+    RdKafka::MessageTimestamp ts;
+    ts.type = RdKafka::MessageTimestamp::MSG_TIMESTAMP_CREATE_TIME;
+    ts.timestamp = 1700000000000;
+    return ts;
+  }
+  void *msg_opaque() const { return NULL; }
+  int64_t latency() const { return -1; }
+  struct rd_kafka_message_s *c_ptr() { return NULL; }
+  Status status() const { return MSG_STATUS_PERSISTED; }
+  RdKafka::Headers *headers() { return m_headers; }
+  RdKafka::Headers *headers(RdKafka::ErrorCode *err) {
+    *err = RdKafka::ERR_NO_ERROR;
+    return m_headers;
+  }
+  int32_t broker_id() const { return 1; }
+  int32_t leader_epoch() const { return 5; }
+  RdKafka::Error *offset_store() { return NULL; }
+
+ private:
+  std::string m_topic;
+  std::string m_payload;
+  std::string m_key;
+  RdKafka::Headers *m_headers;
+};
+
+/**
+ * @brief Exposes the protected event queue so it can be filled directly.
+ */
+class BenchDeliveryReportDispatcher :
+  public Callbacks::DeliveryReportDispatcher {
+ public:
+  size_t Pending() {
+    scoped_mutex_lock lock(async_lock);
+    return events.size();
+  }
+};
+
+class Measurement {
+ public:
+  Measurement() :
+    m_allocations(g_allocations.load()),
+    m_start(std::chrono::steady_clock::now()) {}
+
+  v8::Local<v8::Object> Result(uint32_t iterations) {
+    std::chrono::nanoseconds elapsed =
+      std::chrono::steady_clock::now() - m_start;
+    size_t allocations = g_allocations.load() - m_allocations;
+
+    v8::Local<v8::Object> result = Nan::New<v8::Object>();
+    Nan::Set(result, Nan::New("iterations").ToLocalChecked(),
+      Nan::New<v8::Number>(iterations));
+    Nan::Set(result, Nan::New("nsPerOp").ToLocalChecked(),
+      Nan::New<v8::Number>(
+        static_cast<double>(elapsed.count()) / iterations));
+    Nan::Set(result, Nan::New("allocsPerOp").ToLocalChecked(),
+      Nan::New<v8::Number>(static_cast<double>(allocations) / iterations));
+    return result;
+  }
+
+ private:
+  size_t m_allocations;
+  std::chrono::steady_clock::time_point m_start;
+};
+
+static uint32_t GetUint(const Nan::FunctionCallbackInfo<v8::Value> &info,
+                        int index, uint32_t def) {
+  if (info.Length() <= index || !info[index]->IsNumber()) {
+    return def;
+  }
+  return Nan::To<uint32_t>(info[index]).FromJust();
+}
+
+/**
+ * toV8Object(iterations, payloadSize, headerCount)
+ */
+NAN_METHOD(NodeToV8Object) {
+  uint32_t iterations = GetUint(info, 0, 100000);
+  SyntheticMessage message("bench", GetUint(info, 1, 256), 16,
+                           GetUint(info, 2, 0));
+
+  Measurement measurement;
+  for (uint32_t i = 0; i < iterations; i++) {
+    Nan::HandleScope scope;
+    Conversion::Message::ToV8Object(&message);
+  }
+  info.GetReturnValue().Set(measurement.Result(iterations));
+}
+
+/**
+ * deliveryReport(iterations, payloadSize)
+ *
+ * Construction on the librdkafka thread, including the payload copy.
+ */
+NAN_METHOD(NodeDeliveryReport) {
+  uint32_t iterations = GetUint(info, 0, 100000);
+  SyntheticMessage message("bench", GetUint(info, 1, 256), 16, 0);
+
+  Measurement measurement;
+  for (uint32_t i = 0; i < iterations; i++) {
+    Callbacks::DeliveryReport report(message, true);
+    free(report.key);
+    free(report.payload);
+  }
+  info.GetReturnValue().Set(measurement.Result(iterations));
+}
+
+/**
+ * deliveryReportFlush(iterations, payloadSize, callback)
+ *
+ * Queues reports and flushes them to `callback`, in batches of the size the
+ * dispatcher flushes at once.
+ */
+NAN_METHOD(NodeDeliveryReportFlush) {
+  uint32_t iterations = GetUint(info, 0, 100000);
+  SyntheticMessage message("bench", GetUint(info, 1, 256), 16, 0);
+  if (info.Length() < 3 || !info[2]->IsFunction()) {
+    return Nan::ThrowError("Need to specify a callback");
+  }
+
+  BenchDeliveryReportDispatcher dispatcher;
+  dispatcher.AddCallback(info[2].As<v8::Function>());
+
+  const uint32_t batch = 100;
+  Measurement measurement;
+  for (uint32_t done = 0; done < iterations; done += batch) {
+    for (uint32_t i = 0; i < batch && done + i < iterations; i++) {
+      dispatcher.Add(Callbacks::DeliveryReport(message, true));
+    }
+    while (dispatcher.Pending() > 0) {
+      dispatcher.Flush();
+    }
+  }
+  info.GetReturnValue().Set(measurement.Result(iterations));
+
+  dispatcher.RemoveCallback(info[2].As<v8::Function>());
+}
+
+/**
+ * headers(iterations, headerArray)
+ *
+ * The header conversion done by Producer::NodeProduce.
+ */
+NAN_METHOD(NodeHeaders) {
+  uint32_t iterations = GetUint(info, 0, 100000);
+  if (info.Length() < 2 || !info[1]->IsArray()) {
+    return Nan::ThrowError("Need to specify an array of headers");
+  }
+  v8::Local<v8::Array> v8Headers = info[1].As<v8::Array>();
+
+  Measurement measurement;
+  for (uint32_t i = 0; i < iterations; i++) {
+    Nan::HandleScope scope;
+    RdKafka::Headers *headers = RdKafka::Headers::create(
+      Conversion::Message::FromV8HeaderArray(v8Headers));
+    delete headers;
+  }
+  info.GetReturnValue().Set(measurement.Result(iterations));
+}
+
+/**
+ * topicPartitionListToV8Array(iterations, partitionCount)
+ */
+NAN_METHOD(NodeTopicPartitionListToV8Array) {
+  uint32_t iterations = GetUint(info, 0, 100000);
+  uint32_t partition_count = GetUint(info, 1, 16);
+
+  std::vector<Callbacks::event_topic_partition_t> partitions;
+  for (uint32_t i = 0; i < partition_count; i++) {
+    partitions.push_back(
+      Callbacks::event_topic_partition_t("bench", i, 1000 + i));
+  }
+
+  Measurement measurement;
+  for (uint32_t i = 0; i < iterations; i++) {
+    Nan::HandleScope scope;
+    Callbacks::TopicPartitionListToV8Array(partitions);
+  }
+  info.GetReturnValue().Set(measurement.Result(iterations));
+}
+
+NAN_MODULE_INIT(Init) {
+  Nan::SetMethod(target, "toV8Object", NodeToV8Object);
+  Nan::SetMethod(target, "deliveryReport", NodeDeliveryReport);
+  Nan::SetMethod(target, "deliveryReportFlush", NodeDeliveryReportFlush);
+  Nan::SetMethod(target, "headers", NodeHeaders);
+  Nan::SetMethod(target, "topicPartitionListToV8Array",
+    NodeTopicPartitionListToV8Array);
+}
+
+}  // namespace Bench
+}  // namespace NodeKafka
+
+NAN_MODULE_WORKER_ENABLED(microbench, NodeKafka::Bench::Init)
@@ -0,0 +1,128 @@
+/*
+ * confluent-kafka-javascript - Node.js wrapper  for RdKafka C/C++ library
+ *
+ * Copyright (c) 2024 Confluent, Inc.
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE.txt file for details.
+ */
+
+// Runs one producer per worker_thread and reports the aggregate delivery
+// throughput. Usage:
+//   node bench/producer-worker-threads.js [host] [topic] [workers] [messages per worker] [message size]
+
+var workerThreads = require('worker_threads');
+
+if (workerThreads.isMainThread) {
+  var host = process.argv[2] || '127.0.0.1:9092';
+  var topicName = process.argv[3] || 'test';
+  var workerCount = parseInt(process.argv[4], 10) || require('os').cpus().length;
+  var perWorker = parseInt(process.argv[5], 10) || 1000000;
+  var messageSize = parseInt(process.argv[6], 10) || 256;
+
+  var started = Date.now();
+  var results = [];
+
+  console.log('Starting %d workers, %d messages each', workerCount, perWorker);
+
+  for (var i = 0; i < workerCount; i++) {
+    var worker = new workerThreads.Worker(__filename, {
+      workerData: {
+        host: host,
+        topic: topicName,
+        messages: perWorker,
+        messageSize: messageSize,
+        id: i,
+      },
+    });
+
+    worker.on('message', function (result) {
+      results.push(result);
+      console.log('worker %d: %d messages delivered in %d ms (%d messages / second)',
+        result.id, result.delivered, result.elapsed,
+        Math.round(result.delivered / (result.elapsed / 1000)));
+
+      if (results.length === workerCount) {
+        var elapsed = Date.now() - started;
+        var delivered = results.reduce(function (acc, r) { return acc + r.delivered; }, 0);
+        var errors = results.reduce(function (acc, r) { return acc + r.errors; }, 0);
+        console.log('total: %d messages over %d ms with %d errors', delivered, elapsed, errors);
+        console.log('%d messages / second', Math.round(delivered / (elapsed / 1000)));
+      }
+    });
+
+    worker.on('error', function (err) {
+      console.error(err);
+      process.exit(1);
+    });
+  }
+} else {
+  var Kafka = require('../');
+  var options = workerThreads.workerData;
+
+  var producer = new Kafka.Producer({
+    'metadata.broker.list': options.host,
+    'client.id': 'confluent-kafka-javascript-bench-' + options.id,
+    'dr_cb': true,
+    'linger.ms': 5,
+    'queue.buffering.max.messages': 100000,
+    'batch.num.messages': 10000,
+  });
+
+  var payload = Buffer.alloc(options.messageSize, 'x');
+  var produced = 0;
+  var delivered = 0;
+  var errors = 0;
+  var started;
+
+  function produceSome() {
+    while (produced < options.messages) {
+      try {
+        producer.produce(options.topic, null, payload, null);
+        produced++;
+      } catch (e) {
+        // Queue is full: let delivery reports drain before retrying.
+        break;
+      }
+    }
+
+    if (produced < options.messages) {
+      setTimeout(produceSome, 1);
+    }
+  }
+
+  producer.setPollInterval(10);
+
+  producer.on('delivery-report', function (err) {
+    if (err) {
+      errors++;
+    }
+    delivered++;
+
+    if (delivered === options.messages) {
+      var elapsed = Date.now() - started;
+      producer.disconnect(function () {
+        workerThreads.parentPort.postMessage({
+          id: options.id,
+          delivered: delivered - errors,
+          errors: errors,
+          elapsed: elapsed,
+        });
+      });
+    }
+  });
+
+  producer.on('event.error', function (err) {
+    console.error(err);
+    process.exit(1);
+  });
+
+  producer.connect({}, function (err) {
+    if (err) {
+      console.error(err);
+      process.exit(1);
+    }
+    started = Date.now();
+    produceSome();
+  });
+}
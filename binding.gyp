@@ -4,164 +4,202 @@
     # "BUILD_LIBRDKAFKA%": "<!(echo ${BUILD_LIBRDKAFKA:-1})"
     "BUILD_LIBRDKAFKA%": "<!(node ./util/get-env.js BUILD_LIBRDKAFKA 1)",
     "CKJS_LINKING%": "<!(node ./util/get-env.js CKJS_LINKING static)",
+    # Also build the native microbenchmarks in bench/native
+    "CKJS_BUILD_MICROBENCH%": "<!(node ./util/get-env.js CKJS_BUILD_MICROBENCH 0)",
+    # Everything but the module entry point, shared with the microbenchmarks
+    'addon_sources': [
+      'src/callbacks.cc',
+      'src/capture.cc',
+      'src/common.cc',
+      'src/config.cc',
+      'src/connection.cc',
+      'src/errors.cc',
+      'src/kafka-consumer.cc',
+      'src/producer.cc',
+      'src/topic.cc',
+      'src/workers.cc',
+      'src/admin.cc',
+      'src/per-isolate-data.cc'
+    ],
   },
-  "targets": [
-    {
-      "target_name": "confluent-kafka-javascript",
-      'sources': [
-        'src/binding.cc',
-        'src/callbacks.cc',
-        'src/common.cc',
-        'src/config.cc',
-        'src/connection.cc',
-        'src/errors.cc',
-        'src/kafka-consumer.cc',
-        'src/producer.cc',
-        'src/topic.cc',
-        'src/workers.cc',
-        'src/admin.cc'
-      ],
-      "include_dirs": [
-        "<!(node -e \"require('nan')\")",
-        "<(module_root_dir)/"
-      ],
-      'conditions': [
-        [
-          'OS=="win"',
-          {
-            'actions': [
+  "target_defaults": {
+    "include_dirs": [
+      "<!(node -e \"require('nan')\")",
+      "<(module_root_dir)/"
+    ],
+    'conditions': [
+      [
+        'OS=="win"',
+        {
+          'actions': [
+            {
+              'action_name': 'nuget_librdkafka_download',
+              'inputs': [
+                'deps/windows-install.py'
+              ],
+              'outputs': [
+                'deps/precompiled/librdkafka.lib',
+                'deps/precompiled/librdkafkacpp.lib'
+              ],
+              'message': 'Getting librdkafka from nuget',
+              'action': ['python', '<@(_inputs)']
+            }
+          ],
+          'cflags_cc' : [
+            '-std=c++17'
+          ],
+          'msvs_settings': {
+            'VCLinkerTool': {
+              'AdditionalDependencies': [
+                'librdkafka.lib',
+                'librdkafkacpp.lib'
+              ],
+              'AdditionalLibraryDirectories': [
+                '../deps/precompiled/'
+              ]
+            },
+            'VCCLCompilerTool': {
+              'AdditionalOptions': [
+                '/GR'
+              ],
+              'AdditionalUsingDirectories': [
+                'deps/precompiled/'
+              ],
+              'AdditionalIncludeDirectories': [
+                'deps/librdkafka/src',
+                'deps/librdkafka/src-cpp'
+              ]
+            }
+          },
+          'include_dirs': [
+            'deps/include'
+          ]
+        },
+        {
+          'conditions': [
+            [ "<(BUILD_LIBRDKAFKA)==1",
               {
-                'action_name': 'nuget_librdkafka_download',
-                'inputs': [
-                  'deps/windows-install.py'
+                "dependencies": [
+                  "deps/librdkafka.gyp:librdkafka"
                 ],
-                'outputs': [
-                  'deps/precompiled/librdkafka.lib',
-                  'deps/precompiled/librdkafkacpp.lib'
+                "include_dirs": [
+                  "deps/librdkafka/src",
+                  "deps/librdkafka/src-cpp"
                 ],
-                'message': 'Getting librdkafka from nuget',
-                'action': ['python', '<@(_inputs)']
-              }
-            ],
-            'cflags_cc' : [
-              '-std=c++17'
-            ],
-            'msvs_settings': {
-              'VCLinkerTool': {
-                'AdditionalDependencies': [
-                  'librdkafka.lib',
-                  'librdkafkacpp.lib'
+                'conditions': [
+                  [
+                    'CKJS_LINKING=="dynamic"',
+                    {
+                      "conditions": [
+                          [
+                              'OS=="mac"',
+                              {
+                                "libraries": [
+                                  "../build/deps/librdkafka.dylib",
+                                  "../build/deps/librdkafka++.dylib",
+                                  "-Wl,-rpath,'$$ORIGIN/../deps'",
+                                ],
+                              },
+                              {
+                                  "libraries": [
+                                    "../build/deps/librdkafka.so",
+                                    "../build/deps/librdkafka++.so",
+                                    "-Wl,-rpath,'$$ORIGIN/../deps'",
+                                  ],
+                              },
+                          ]
+                      ]
+                    },
+                    {
+                      "libraries": [
+                        "../build/deps/librdkafka-static.a",
+                        "../build/deps/librdkafka++.a",
+                        "-Wl,-rpath,'$$ORIGIN/../deps'",
+                      ],
+                    }
+                  ],
                 ],
-                'AdditionalLibraryDirectories': [
-                  '../deps/precompiled/'
-                ]
               },
-              'VCCLCompilerTool': {
-                'AdditionalOptions': [
-                  '/GR'
+              # Else link against globally installed rdkafka and use
+              # globally installed headers.  On Debian, you should
+              # install the librdkafka1, librdkafka++1, and librdkafka-dev
+              # .deb packages.
+              {
+                "libraries": ["-lrdkafka", "-lrdkafka++"],
+                "include_dirs": [
+                  "/usr/include/librdkafka",
+                  "/usr/local/include/librdkafka",
+                  "/opt/include/librdkafka",
                 ],
-                'AdditionalUsingDirectories': [
-                  'deps/precompiled/'
+              },
+            ],
+            [
+              'OS=="linux"',
+              {
+                'cflags_cc' : [
+                  '-std=c++17'
                 ],
-                'AdditionalIncludeDirectories': [
-                  'deps/librdkafka/src',
-                  'deps/librdkafka/src-cpp'
+                'cflags_cc!': [
+                  '-fno-rtti'
                 ]
               }
-            },
-            'include_dirs': [
-              'deps/include'
-            ]
-          },
-          {
-            'conditions': [
-              [ "<(BUILD_LIBRDKAFKA)==1",
-                {
-                  "dependencies": [
-                    "deps/librdkafka.gyp:librdkafka"
-                  ],
-                  "include_dirs": [
-                    "deps/librdkafka/src",
-                    "deps/librdkafka/src-cpp"
-                  ],
-                  'conditions': [
-                    [
-                      'CKJS_LINKING=="dynamic"',
-                      {
-                        "conditions": [
-                            [
-                                'OS=="mac"',
-                                {
-                                  "libraries": [
-                                    "../build/deps/librdkafka.dylib",
-                                    "../build/deps/librdkafka++.dylib",
-                                    "-Wl,-rpath,'$$ORIGIN/../deps'",
-                                  ],
-                                },
-                                {
-                                    "libraries": [
-                                      "../build/deps/librdkafka.so",
-                                      "../build/deps/librdkafka++.so",
-                                      "-Wl,-rpath,'$$ORIGIN/../deps'",
-                                    ],
-                                },
-                            ]
-                        ]
-                      },
-                      {
-                        "libraries": [
-                          "../build/deps/librdkafka-static.a",
-                          "../build/deps/librdkafka++.a",
-                          "-Wl,-rpath,'$$ORIGIN/../deps'",
-                        ],
-                      }
-                    ],
+            ],
+            [
+              'OS=="mac"',
+              {
+                'xcode_settings': {
+                  'MACOSX_DEPLOYMENT_TARGET': '10.11',
+                  'GCC_ENABLE_CPP_RTTI': 'YES',
+                  'OTHER_LDFLAGS': [
+                    '-L/usr/local/opt/openssl/lib'
                   ],
-                },
-                # Else link against globally installed rdkafka and use
-                # globally installed headers.  On Debian, you should
-                # install the librdkafka1, librdkafka++1, and librdkafka-dev
-                # .deb packages.
-                {
-                  "libraries": ["-lrdkafka", "-lrdkafka++"],
-                  "include_dirs": [
-                    "/usr/include/librdkafka",
-                    "/usr/local/include/librdkafka",
-                    "/opt/include/librdkafka",
+                  'OTHER_CPLUSPLUSFLAGS': [
+                    '-I/usr/local/opt/openssl/include',
+                    '-std=c++17'
                   ],
                 },
-              ],
+              }
+            ]
+          ]
+        }
+      ]
+    ]
+  },
+  "targets": [
+    {
+      "target_name": "confluent-kafka-javascript",
+      'sources': [
+        'src/binding.cc',
+        '<@(addon_sources)'
+      ]
+    }
+  ],
+  'conditions': [
+    [
+      'CKJS_BUILD_MICROBENCH==1',
+      {
+        "targets": [
+          {
+            "target_name": "confluent-kafka-javascript-microbench",
+            'sources': [
+              'bench/native/microbench.cc',
+              '<@(addon_sources)'
+            ],
+            'conditions': [
               [
                 'OS=="linux"',
                 {
-                  'cflags_cc' : [
-                    '-std=c++17'
-                  ],
-                  'cflags_cc!': [
-                    '-fno-rtti'
+                  # Bind operator new to the counting one in microbench.cc
+                  # for all sources linked into this module.
+                  'ldflags': [
+                    '-Wl,-Bsymbolic-functions'
                   ]
                 }
-              ],
-              [
-                'OS=="mac"',
-                {
-                  'xcode_settings': {
-                    'MACOSX_DEPLOYMENT_TARGET': '10.11',
-                    'GCC_ENABLE_CPP_RTTI': 'YES',
-                    'OTHER_LDFLAGS': [
-                      '-L/usr/local/opt/openssl/lib'
-                    ],
-                    'OTHER_CPLUSPLUSFLAGS': [
-                      '-I/usr/local/opt/openssl/include',
-                      '-std=c++17'
-                    ],
-                  },
-                }
               ]
             ]
           }
         ]
-      ]
-    }
+      }
+    ]
   ]
 }
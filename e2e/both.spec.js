@@ -8,6 +8,9 @@
  */
 
 var crypto = require('crypto');
+var fs = require('fs');
+var os = require('os');
+var path = require('path');
 var t = require('assert');
 
 var Kafka = require('../');
@@ -227,6 +230,34 @@ describe('Consumer/Producer', function() {
     });
   });
 
+  it('should parse the wire format header when consuming', function(done) {
+    // Schema ID 7, message indexes [1] and the payload
+    var value = Buffer.from([0, 0, 0, 0, 7, 2, 2, 1, 2, 3]);
+
+    producer.setPollInterval(10);
+
+    consumer.setWireFormatParsing('protobuf');
+    consumer.subscribe([topic]);
+
+    var consumeOne = function() {
+      consumer.consume(1, function(err, messages) {
+        t.ifError(err);
+        if (messages.length === 0) {
+          return consumeOne();
+        }
+        t.equal(messages[0].schemaId, 7);
+        t.deepStrictEqual(messages[0].messageIndexes, [1]);
+        t.deepStrictEqual(messages[0].value, Buffer.from([1, 2, 3]));
+        consumer.setWireFormatParsing('none');
+        consumer.unsubscribe();
+        done();
+      });
+    };
+
+    producer.produce(topic, null, value, null);
+    consumeOne();
+  });
+
   it('should emit partition.eof event when reaching end of partition', function(done) {
     crypto.randomBytes(4096, function(ex, buffer) {
       producer.setPollInterval(10);
@@ -546,6 +577,97 @@ describe('Consumer/Producer', function() {
     }, 2000);
   });
 
+  it('should be able to record consumed messages and replay them without the cluster', function(done) {
+    var capture = path.join(os.tmpdir(), 'capture-' + crypto.randomBytes(8).toString('hex'));
+    var headers = [{ 'header-string': 'value' }, { 'header-buffer': Buffer.from('buffer') }];
+    var value = Buffer.from('replayed value');
+    var key = 'replayed key';
+
+    producer.setPollInterval(10);
+
+    consumer.once('data', function(recorded) {
+      consumer.stopCapture();
+      consumer.unsubscribe();
+
+      var replayConsumer = new Kafka.KafkaConsumer({
+        'test.mock.num.brokers': 1,
+        'group.id': grp + '-replay',
+      }, {});
+
+      replayConsumer.connect({ timeout: 2000 }, function(err) {
+        t.ifError(err);
+        replayConsumer.startReplay(capture);
+        replayConsumer.setDefaultConsumeTimeout(100);
+        replayConsumer.consume(10, function(err, messages) {
+          t.ifError(err);
+          t.equal(messages.length, 1, 'expected the recorded message only');
+          var replayed = messages[0];
+          t.equal(value.toString(), replayed.value.toString(), 'invalid replayed value');
+          t.equal(key, replayed.key.toString(), 'invalid replayed key');
+          t.equal(recorded.topic, replayed.topic, 'invalid replayed topic');
+          t.equal(recorded.partition, replayed.partition, 'invalid replayed partition');
+          t.equal(recorded.offset, replayed.offset, 'invalid replayed offset');
+          t.equal(recorded.timestamp, replayed.timestamp, 'invalid replayed timestamp');
+          assert_headers_match(headers, replayed.headers);
+
+          replayConsumer.stopReplay();
+          replayConsumer.disconnect(function() {
+            fs.unlinkSync(capture);
+            done();
+          });
+        });
+      });
+    });
+
+    consumer.startCapture(capture);
+    consumer.subscribe([topic]);
+    consumer.consume();
+
+    setTimeout(function() {
+      producer.produce(topic, null, value, key, Date.now(), '', headers);
+    }, 2000);
+  });
+
+  it('should keep consuming when the capture file cannot be written', function(done) {
+    if (!fs.existsSync('/dev/full')) {
+      this.skip();
+    }
+
+    // Writes to /dev/full fail with ENOSPC. The value is larger than the
+    // stdio buffer, so the first record already reaches the device.
+    var value = Buffer.alloc(64 * 1024, 'x');
+    var captureStopped = false;
+    var received = 0;
+
+    producer.setPollInterval(10);
+
+    consumer.on('event.log', function(log) {
+      if (log.fac === 'CAPTURE') {
+        t.equal(captureStopped, false, 'capture error should be logged once');
+        captureStopped = true;
+      }
+    });
+
+    consumer.on('data', function(message) {
+      t.equal(value.length, message.value.length, 'invalid message value');
+      if (++received === 2) {
+        consumer.removeAllListeners('data');
+        consumer.unsubscribe();
+        t.ok(captureStopped, 'expected the capture error to be logged');
+        done();
+      }
+    });
+
+    consumer.startCapture('/dev/full');
+    consumer.subscribe([topic]);
+    consumer.consume();
+
+    setTimeout(function() {
+      producer.produce(topic, null, value, null);
+      producer.produce(topic, null, value, null);
+    }, 2000);
+  });
+
   describe('Exceptional case -  offset_commit_cb true', function() {
     var grp = 'kafka-mocha-grp-' + crypto.randomBytes(20).toString('hex');
     var consumerOpts = {
@@ -160,6 +160,22 @@ describe('Consumer', function() {
       done();
     });
 
+    it('should resolve offsets and assign them', function(done) {
+      consumer.resolveOffsets([{ topic: topic, partition: 0 }], {
+        fallback: 'earliest',
+        watermarks: true,
+        assign: true,
+      }, function(err, partitions, timings) {
+        t.ifError(err);
+        t.equal(partitions.length, 1);
+        t.ok(['committed', 'fallback'].indexOf(partitions[0].source) !== -1);
+        t.equal(typeof partitions[0].highOffset, 'number');
+        t.equal(typeof timings.totalMs, 'number');
+        t.deepStrictEqual(consumer.assignments().map(function(a) { return a.partition; }), [0]);
+        done();
+      });
+    });
+
     it('should obey the timeout', function(done) {
       consumer.committed(null, 0, function(err, committed) {
         if (!err) {
@@ -216,6 +232,25 @@ describe('Consumer', function() {
         cb();
       });
     });
+
+    it('should be able to seek several partitions at once', function(cb) {
+      consumer.seekPartitions([{
+        topic,
+        partition: 0,
+        offset: 0
+      }, {
+        topic,
+        partition: 1,
+        offset: 0
+      }], 1000, function(err, topicPartitions) {
+        t.ifError(err);
+        t.equal(topicPartitions.length, 2);
+        t.equal(topicPartitions[0].error, undefined);
+        t.equal(topicPartitions[0].offset, 0);
+        t.equal(topicPartitions[1].partition, 1);
+        cb();
+      });
+    });
   });
 
   describe('subscribe', function() {
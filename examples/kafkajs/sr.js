@@ -101,7 +101,7 @@ const run = async () => {
     await consumer.run({
         eachMessage: async ({ message }) => {
             const decodedMessage = {
-                ...message,
+                ...message.toJSON(),
                 value: await deser.deserialize(topicName, message.value)
             };
             console.log("Consumer received message.\nBefore decoding: " + JSON.stringify(message) + "\nAfter decoding: " + JSON.stringify(decodedMessage));
@@ -17,6 +17,7 @@ var Kafka = require('../librdkafka.js');
 const { bindingVersion, dictToStringList } = require('./util');
 
 var LibrdKafkaError = require('./error');
+var MockCluster = require('./mock-cluster');
 
 util.inherits(Client, Emitter);
 
@@ -340,6 +341,20 @@ Client.prototype.getClient = function() {
   return this._client;
 };
 
+/**
+ * Get the controls of the mock cluster created by this client.
+ *
+ * Only available for clients created with `test.mock.num.brokers`, which
+ * makes librdkafka start an in-process mock cluster and connect to it.
+ * Use it to inject broker latency, request errors, leader moves and broker
+ * outages in tests and benchmarks.
+ *
+ * @return {MockCluster} - Controls for the mock cluster.
+ */
+Client.prototype.getMockCluster = function() {
+  return new MockCluster(this);
+};
+
 /**
  * Find out how long we have been connected to Kafka.
  *
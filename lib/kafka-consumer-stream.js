@@ -13,6 +13,7 @@ module.exports = KafkaConsumerStream;
 
 var Readable = require('stream').Readable;
 var util = require('util');
+var RingBuffer = require('./tools/ring-buffer');
 
 util.inherits(KafkaConsumerStream, Readable);
 
@@ -32,14 +33,27 @@ util.inherits(KafkaConsumerStream, Readable);
  * The stream detects if Kafka is already connected. If it is, it will begin
  * reading. If it is not, it will connect and read when it is ready.
  *
+ * Messages are fetched ahead of reads, up to the high water mark. Once that
+ * many are waiting to be read, the stream stops consuming and pauses the
+ * assigned partitions until they are read, including partitions assigned in
+ * the meantime. Partitions paused with {@link KafkaConsumer#pause} are left
+ * alone, and only the partitions the stream paused itself are resumed. When
+ * the consumer queue is empty, the stream waits for the consumer to report
+ * new messages before fetching again.
+ *
  * This stream operates in objectMode. It streams {Consumer~Message}
  *
  * @param {Consumer} consumer - The Kafka Consumer object.
  * @param {object} options - Options to configure the stream.
  * @param {number} options.waitInterval - Number of ms to wait if Kafka reports
- * that it has timed out or that we are out of messages (right now).
+ * that it has timed out or that we are out of messages (right now), unless
+ * the consumer reports new messages earlier.
  * @param {array} options.topics - Array of topics, or a function that parses
  * metadata into an array of topics
+ * @param {number} options.highWaterMark - Number of messages (in objectMode)
+ * or bytes to fetch ahead of reads.
+ * @param {number} options.highWaterMarkBytes - Number of bytes of message
+ * values to fetch ahead of reads in objectMode. Unlimited by default.
  * @constructor
  * @extends stream.Readable
  * @see Consumer~Message
@@ -85,11 +99,7 @@ function KafkaConsumerStream(consumer, options) {
     }
   }
 
-  if (options.objectMode !== true) {
-    this._read = this._read_buffer;
-  } else {
-    this._read = this._read_message;
-  }
+  this.objectMode = options.objectMode === true;
 
   Readable.call(this, options);
 
@@ -101,17 +111,63 @@ function KafkaConsumerStream(consumer, options) {
   this.connectOptions = options.connectOptions || {};
   this.streamAsBatch = options.streamAsBatch || false;
 
-  // Hold the messages in here
-  this.messages = [];
+  // The high water mark of the stream is in messages in objectMode and in
+  // bytes otherwise. Fetching ahead is bounded by it in the same unit, and
+  // by highWaterMarkBytes if given.
+  this.highWaterMarkMessages = this.objectMode ? this.readableHighWaterMark : Infinity;
+  this.highWaterMarkBytes = options.highWaterMarkBytes ||
+    (this.objectMode ? Infinity : this.readableHighWaterMark);
+
+  // Hold the messages fetched ahead of reads in here, in the form they are
+  // pushed: messages, message values, or batches of messages
+  this.messages = new RingBuffer();
+  this._bufferedMessages = 0;
+  this._bufferedBytes = 0;
+
+  // Whether the stream asked for more data than it has been given
+  this._reading = false;
+  this._fetching = false;
+  // Set while waiting for the consumer to report new messages
+  this._waitTimeout = null;
+  // Set when the consumer reported new messages since the last fetch
+  this._queueNonEmpty = false;
+  // The partitions the stream paused because the buffer is full, by topic
+  // and partition, or null while it has not paused any
+  this._pausedPartitions = null;
 
   var self = this;
 
+  // Let the consumer wake us up when messages arrive on its empty queue
+  this._onQueueNonEmpty = null;
+  if (consumer._client && typeof consumer._client.configureCallbacks === 'function') {
+    this._onQueueNonEmpty = function() {
+      self._queueNonEmpty = true;
+      if (self._waitTimeout) {
+        clearTimeout(self._waitTimeout);
+        self._waitTimeout = null;
+        self._fetch();
+      }
+    };
+    consumer._client.configureCallbacks(true, { event: { queue_non_empty_cb: this._onQueueNonEmpty } });
+  }
+
   this.consumer
     .on('unsubscribed', function() {
       // Invalidate the stream when we unsubscribe
       self.push(null);
     });
 
+  // Pause the partitions assigned while the buffer is full. The rebalance
+  // callback changes the assignment after emitting the event.
+  this._onRebalance = function() {
+    setImmediate(function() {
+      if (self._pausedPartitions && !self.destroyed) {
+        self._pausePartitions();
+      }
+    });
+  };
+  this.consumer.on('rebalance', this._onRebalance);
+
   // Call connect. Handles potentially being connected already
   this.connect(this.connectOptions);
 
@@ -124,13 +180,37 @@ function KafkaConsumerStream(consumer, options) {
 }
 
 /**
- * Internal stream read method. This method reads message objects.
+ * Internal stream read method. Hands out the messages fetched ahead, and
+ * keeps fetching.
  * @param {number} size - This parameter is ignored for our cases.
  * @private
  */
-KafkaConsumerStream.prototype._read_message = function(size) {
-  if (this.messages.length > 0) {
-    return this.push(this.messages.shift());
+KafkaConsumerStream.prototype._read = function(size) {
+  this._reading = true;
+  this._drain();
+  this._fetch();
+};
+
+/**
+ * Push buffered messages while the stream wants more.
+ * @private
+ */
+KafkaConsumerStream.prototype._drain = function() {
+  while (this._reading && this.messages.length > 0) {
+    var chunk = this.messages.shift();
+    this._release(chunk);
+    this._reading = this.push(chunk);
+  }
+};
+
+/**
+ * Fetch the next messages from the consumer, unless a fetch is in flight,
+ * we are waiting for messages, or the buffer is full.
+ * @private
+ */
+KafkaConsumerStream.prototype._fetch = function() {
+  if (this._fetching || this._waitTimeout || this.destroyed) {
+    return;
   }
 
   if (!this.consumer) {
@@ -139,43 +219,30 @@ KafkaConsumerStream.prototype._read_message = function(size) {
   }
 
   if (!this.consumer.isConnected()) {
-    this.consumer.once('ready', function() {
-      // This is the way Node.js does it
-      // https://github.com/nodejs/node/blob/master/lib/fs.js#L1733
-      this._read(size);
-    }.bind(this));
+    if (!this._waitingForReady) {
+      this._waitingForReady = true;
+      this.consumer.once('ready', function() {
+        this._waitingForReady = false;
+        this._fetch();
+      }.bind(this));
+    }
     return;
   }
 
-  if (this.destroyed) {
+  if (this._isFull()) {
+    // _read fetches again once the buffer is drained
+    this._pausePartitions();
     return;
   }
 
-  var self = this;
+  this._resumePartitions();
 
-  // If the size (number of messages) we are being advised to fetch is
-  // greater than or equal to the fetch size, use the fetch size.
-  // Only opt to use the size in case it is LESS than the fetch size.
-  // Essentially, we want to use the smaller value here
-  var fetchSize = size >= this.fetchSize ? this.fetchSize : size;
-
-  this.consumer.consume(fetchSize, onread);
-
-  // Retry function. Will wait up to the wait interval, with some
-  // random noise if one is provided. Otherwise, will go immediately.
-  function retry() {
-    if (!self.waitInterval) {
-      setImmediate(function() {
-        self._read(size);
-      });
-    } else {
-      setTimeout(function() {
-        self._read(size);
-      }, self.waitInterval * Math.random()).unref();
-    }
-  }
+  var self = this;
 
-  function onread(err, messages) {
+  this._fetching = true;
+  this._queueNonEmpty = false;
+  this.consumer.consume(this.fetchSize, function(err, messages) {
+    self._fetching = false;
 
     // If there was an error we still want to emit it.
     // Essentially, if the user does not register an error
@@ -188,115 +255,180 @@ KafkaConsumerStream.prototype._read_message = function(size) {
     }
 
     // If there are no messages it means we reached EOF or a timeout.
-    // Do what we used to do
-
     if (err || messages.length < 1) {
-      // If we got an error or if there were no messages, initiate a retry
-      retry();
+      self._wait();
       return;
-    } else {
-      if (self.streamAsBatch) {
-        self.push(messages);
-      } else {
-        for (var i = 0; i < messages.length; i++) {
-          self.messages.push(messages[i]);
-        }
-
-        // Now that we have added them all the inner messages buffer,
-        // we can just push the most recent one
-        self.push(self.messages.shift());
-      }
     }
 
+    self._buffer(messages);
+    self._drain();
+
+    // Keep fetching ahead until the buffer is full
+    self._fetch();
+  });
+};
+
+/**
+ * Wait for the consumer to report new messages, or for up to the wait
+ * interval when it cannot, before fetching again.
+ * @private
+ */
+KafkaConsumerStream.prototype._wait = function() {
+  var self = this;
+
+  if (this._queueNonEmpty) {
+    // Messages arrived while the fetch was in flight
+    setImmediate(function() {
+      self._fetch();
+    });
+    return;
+  }
+
+  // With wakeups from the consumer, the timer only guards against missing
+  // one. Without them, add some random noise as before.
+  var interval = this.waitInterval;
+  if (!this._onQueueNonEmpty) {
+    interval = interval * Math.random();
   }
+  this._waitTimeout = setTimeout(function() {
+    self._waitTimeout = null;
+    self._fetch();
+  }, interval);
+  this._waitTimeout.unref();
 };
 
 /**
- * Internal stream read method. This method reads message buffers.
- * @param {number} size - This parameter is ignored for our cases.
+ * Add fetched messages to the buffer.
  * @private
  */
-KafkaConsumerStream.prototype._read_buffer = function(size) {
-  if (this.messages.length > 0) {
-    return this.push(this.messages.shift());
+KafkaConsumerStream.prototype._buffer = function(messages) {
+  var i;
+  if (this.streamAsBatch) {
+    this.messages.push(messages);
+  } else if (this.objectMode) {
+    for (i = 0; i < messages.length; i++) {
+      this.messages.push(messages[i]);
+    }
+  } else {
+    for (i = 0; i < messages.length; i++) {
+      this.messages.push(messages[i].value);
+    }
   }
 
-  if (!this.consumer) {
-    // This consumer is set to `null` in the close function
-    return;
+  this._bufferedMessages += messages.length;
+  for (i = 0; i < messages.length; i++) {
+    this._bufferedBytes += valueSize(messages[i].value);
   }
+};
 
-  if (!this.consumer.isConnected()) {
-    this.consumer.once('ready', function() {
-      // This is the way Node.js does it
-      // https://github.com/nodejs/node/blob/master/lib/fs.js#L1733
-      this._read(size);
-    }.bind(this));
-    return;
+/**
+ * Account for a chunk leaving the buffer.
+ * @private
+ */
+KafkaConsumerStream.prototype._release = function(chunk) {
+  if (this.streamAsBatch) {
+    this._bufferedMessages -= chunk.length;
+    for (var i = 0; i < chunk.length; i++) {
+      this._bufferedBytes -= valueSize(chunk[i].value);
+    }
+  } else {
+    this._bufferedMessages--;
+    this._bufferedBytes -= valueSize(this.objectMode ? chunk.value : chunk);
   }
+};
 
-  if (this.destroyed) {
+/**
+ * Pause the assigned partitions that nobody paused yet, and forget the
+ * revoked ones.
+ * @private
+ */
+KafkaConsumerStream.prototype._pausePartitions = function() {
+  var client = this.consumer._client;
+  if (!client || typeof client.pause !== 'function' || !this.consumer.isConnected()) {
     return;
   }
 
-  var self = this;
+  var paused = this._pausedPartitions || new Map();
+  var userPaused = this.consumer._pausedPartitions;
+  this._pausedPartitions = paused;
+  try {
+    var assigned = new Set();
+    var partitions = [];
+    var assignments = this.consumer.assignments();
+    for (var i = 0; i < assignments.length; i++) {
+      var key = partitionKey(assignments[i]);
+      assigned.add(key);
+      if (!paused.has(key) && !(userPaused && userPaused.has(key))) {
+        partitions.push({ topic: assignments[i].topic, partition: assignments[i].partition });
+      }
+    }
+    paused.forEach(function(partition, key) {
+      if (!assigned.has(key)) {
+        paused.delete(key);
+      }
+    });
 
-  // If the size (number of messages) we are being advised to fetch is
-  // greater than or equal to the fetch size, use the fetch size.
-  // Only opt to use the size in case it is LESS than the fetch size.
-  // Essentially, we want to use the smaller value here
-  var fetchSize = size >= this.fetchSize ? this.fetchSize : size;
-
-  this.consumer.consume(fetchSize, onread);
-
-  // Retry function. Will wait up to the wait interval, with some
-  // random noise if one is provided. Otherwise, will go immediately.
-  function retry() {
-    if (!self.waitInterval) {
-      setImmediate(function() {
-        self._read(size);
-      });
-    } else {
-      setTimeout(function() {
-        self._read(size);
-      }, self.waitInterval * Math.random()).unref();
+    if (partitions.length > 0) {
+      this.consumer._errorWrap(client.pause(partitions), true);
+      for (var j = 0; j < partitions.length; j++) {
+        paused.set(partitionKey(partitions[j]), partitions[j]);
+      }
     }
+  } catch (e) {
+    this.emit('error', e);
   }
+};
 
-  function onread(err, messages) {
-    // If there was an error we still want to emit it.
-    // Essentially, if the user does not register an error
-    // handler, it will still cause the stream to blow up.
-    //
-    // But... if one is provided, consumption will move on
-    // as normal
-    if (err) {
-      self.emit('error', err);
-    }
+/**
+ * Resume the partitions the stream paused, unless they were revoked or the
+ * user paused them since.
+ * @private
+ */
+KafkaConsumerStream.prototype._resumePartitions = function() {
+  var paused = this._pausedPartitions;
+  if (!paused) {
+    return;
+  }
+  this._pausedPartitions = null;
+  if (paused.size === 0 || !this.consumer.isConnected()) {
+    return;
+  }
 
-    // If there are no messages it means we reached EOF or a timeout.
-    // Do what we used to do
+  var userPaused = this.consumer._pausedPartitions;
+  try {
+    var assigned = new Set();
+    var assignments = this.consumer.assignments();
+    for (var i = 0; i < assignments.length; i++) {
+      assigned.add(partitionKey(assignments[i]));
+    }
 
-    if (err || messages.length < 1) {
-      // If we got an error or if there were no messages, initiate a retry
-      retry();
-      return;
-    } else {
-      if (self.streamAsBatch) {
-        self.push(messages);
-      } else {
-        for (var i = 0; i < messages.length; i++) {
-          self.messages.push(messages[i].value);
-        }
-        // Now that we have added them all the inner messages buffer,
-        // we can just push the most recent one
-        self.push(self.messages.shift());
+    var partitions = [];
+    paused.forEach(function(partition, key) {
+      if (assigned.has(key) && !(userPaused && userPaused.has(key))) {
+        partitions.push(partition);
       }
+    });
+    if (partitions.length > 0) {
+      this.consumer._errorWrap(this.consumer._client.resume(partitions), true);
     }
-
+  } catch (e) {
+    this.emit('error', e);
   }
 };
 
+KafkaConsumerStream.prototype._isFull = function() {
+  return this._bufferedMessages >= this.highWaterMarkMessages ||
+    this._bufferedBytes >= this.highWaterMarkBytes;
+};
+
+function valueSize(value) {
+  return value ? value.length : 0;
+}
+
+function partitionKey(topicPartition) {
+  return topicPartition.topic + '|' + topicPartition.partition;
+}
+
 KafkaConsumerStream.prototype.connect = function(options) {
   var self = this;
 
@@ -345,6 +477,19 @@ KafkaConsumerStream.prototype.destroy = function() {
     return;
   }
   this.destroyed = true;
+  if (this._waitTimeout) {
+    clearTimeout(this._waitTimeout);
+    this._waitTimeout = null;
+  }
+  if (this._onQueueNonEmpty) {
+    this.consumer._client.configureCallbacks(false, { event: { queue_non_empty_cb: this._onQueueNonEmpty } });
+    this._onQueueNonEmpty = null;
+  }
+  this.consumer.removeListener('rebalance', this._onRebalance);
+  this._resumePartitions();
+  this.messages.clear();
+  this._bufferedMessages = 0;
+  this._bufferedBytes = 0;
   this.close();
 };
 
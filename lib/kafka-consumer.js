@@ -16,11 +16,14 @@ var util = require('util');
 var Kafka = require('../librdkafka');
 var KafkaConsumerStream = require('./kafka-consumer-stream');
 var LibrdKafkaError = require('./error');
+var Topic = require('./topic');
 var TopicPartition = require('./topic-partition');
 var shallowCopy = require('./util').shallowCopy;
 var DEFAULT_CONSUME_LOOP_TIMEOUT_DELAY = 500;
 var DEFAULT_CONSUME_TIME_OUT = 1000;
 const DEFAULT_IS_TIMEOUT_ONLY_FOR_FIRST_MESSAGE = false;
+// Must match Conversion::Message::WireFormatMode in src/common.h
+const WIRE_FORMAT_MODES = { none: 0, schemaId: 1, protobuf: 2 };
 util.inherits(KafkaConsumer, Client);
 
 /**
@@ -133,6 +136,12 @@ function KafkaConsumer(conf, topicConf) {
   this._consumeTimeout = DEFAULT_CONSUME_TIME_OUT;
   this._consumeLoopTimeoutDelay = DEFAULT_CONSUME_LOOP_TIMEOUT_DELAY;
   this._consumeIsTimeoutOnlyForFirstMessage = DEFAULT_IS_TIMEOUT_ONLY_FOR_FIRST_MESSAGE;
+  this._consumeKafkaJSFormat = false;
+  this._consumeWireFormat = WIRE_FORMAT_MODES.none;
+
+  // Partitions paused with pause() and not resumed since, by topic and
+  // partition, so that streams can tell them from the ones they pause
+  this._pausedPartitions = new Set();
 
   if (queue_non_empty_cb) {
     this._cb_configs.event.queue_non_empty_cb = queue_non_empty_cb;
@@ -169,6 +178,37 @@ KafkaConsumer.prototype.setDefaultIsTimeoutOnlyForFirstMessage = function(isTime
   this._consumeIsTimeoutOnlyForFirstMessage = isTimeoutOnlyForFirstMessage;
 };
 
+/**
+ * Make consume(number, cb) return messages in the shape of KafkaJS batch
+ * messages: string offset and timestamp, `attributes`, and headers as an
+ * object. Do not use this method.
+ * This method is meant for internal use, and the API is not guaranteed to be stable.
+ *
+ * @param {boolean} enabled
+ */
+KafkaConsumer.prototype._setKafkaJSMessageFormat = function(enabled) {
+  this._consumeKafkaJSFormat = enabled;
+};
+
+/**
+ * Parse the Confluent schema registry wire format header of messages returned
+ * by consume(number, cb) on the consume thread.
+ *
+ * For messages with a valid header, `schemaId` is set, `messageIndexes` is
+ * set as well in 'protobuf' mode, and `value` holds only the payload after
+ * the header. Pass these to the schema registry deserializers so that they
+ * skip parsing the header again. Messages without a valid header are
+ * returned unchanged.
+ *
+ * @param {string} format - 'none' (the default), 'schemaId' or 'protobuf'
+ */
+KafkaConsumer.prototype.setWireFormatParsing = function(format) {
+  if (!Object.hasOwn(WIRE_FORMAT_MODES, format)) {
+    throw new TypeError('"format" must be one of ' + Object.keys(WIRE_FORMAT_MODES).join(', '));
+  }
+  this._consumeWireFormat = WIRE_FORMAT_MODES[format];
+};
+
 /**
  * Get a stream representation of this KafkaConsumer
  *
@@ -231,6 +271,88 @@ KafkaConsumer.prototype.committed = function(toppars, timeout, cb) {
   return this;
 };
 
+/**
+ * Resolve the offsets to start consuming partitions from, for instance for
+ * the partitions of a new assignment.
+ *
+ * The committed offsets, the offsets for `options.timestamp` and, if
+ * requested, the watermarks of all partitions are each fetched with one
+ * request, and the requests run concurrently. Each partition starts from
+ * its committed offset, or else from the offset for `options.timestamp`,
+ * or else from `options.fallback`.
+ *
+ * @param {TopicPartition[]} toppars - Topic partitions to resolve offsets for.
+ * @param {object} options
+ * @param {number} [options.timestamp] - Timestamp in ms to start partitions
+ * without a committed offset from.
+ * @param {string|number} [options.fallback='stored'] - Offset of partitions
+ * without a committed offset or an offset for the timestamp: 'earliest',
+ * 'latest', 'stored' (use `auto.offset.reset`) or an absolute offset.
+ * @param {boolean} [options.watermarks=false] - Also return `lowOffset` and
+ * `highOffset` for each partition.
+ * @param {boolean} [options.assign=false] - Assign the partitions at the
+ * resolved offsets before calling back, incrementally if the consumer uses
+ * the cooperative rebalance protocol.
+ * @param {number} [options.timeout=5000] - Number of ms to wait for each request.
+ * @param {Function} cb - Callback called with an error, or with the
+ * partitions (with `offset`, its `source`: 'committed', 'timestamp' or
+ * 'fallback', and an `error` if the committed offset couldn't be fetched)
+ * and the time spent in each phase, in ms.
+ * @return {Client} - Returns itself
+ */
+KafkaConsumer.prototype.resolveOffsets = function(toppars, options, cb) {
+  var self = this;
+  options = options || {};
+
+  var timestamp = typeof options.timestamp === 'number' ? options.timestamp : null;
+  var fallback = Topic.OFFSET_STORED;
+  if (options.fallback === 'earliest') {
+    fallback = Topic.OFFSET_BEGINNING;
+  } else if (options.fallback === 'latest') {
+    fallback = Topic.OFFSET_END;
+  } else if (typeof options.fallback === 'number') {
+    fallback = options.fallback;
+  }
+  var timeout = options.timeout === undefined ? 5000 : options.timeout;
+
+  this._client.resolveOffsets(TopicPartition.map(toppars), timestamp, fallback,
+    !!options.watermarks, timeout, function(err, topicPartitions, timings) {
+      if (err) {
+        cb(LibrdKafkaError.create(err));
+        return;
+      }
+
+      for (var i = 0; i < topicPartitions.length; i++) {
+        if (topicPartitions[i].error) {
+          topicPartitions[i].error = LibrdKafkaError.create(topicPartitions[i].error);
+        }
+      }
+
+      if (options.assign) {
+        var assignment = topicPartitions.map(function(topicPartition) {
+          return {
+            topic: topicPartition.topic,
+            partition: topicPartition.partition,
+            offset: topicPartition.offset,
+          };
+        });
+        try {
+          if (self.rebalanceProtocol() === 'COOPERATIVE') {
+            self.incrementalAssign(assignment);
+          } else {
+            self.assign(assignment);
+          }
+        } catch (e) {
+          cb(e);
+          return;
+        }
+      }
+
+      cb(null, topicPartitions, timings);
+    });
+  return this;
+};
+
 /**
  * Seek consumer for topic+partition to offset which is either an absolute or
  * logical offset.
@@ -267,6 +389,39 @@ KafkaConsumer.prototype.seek = function(toppar, timeout, cb) {
   return this;
 };
 
+/**
+ * Seek several topic partitions to offsets in a single call.
+ *
+ * Unlike {@link KafkaConsumer#seek}, which takes a thread pool task per
+ * partition, all partitions are sought at once and errors are reported per
+ * partition.
+ *
+ * @param {TopicPartition[]} toppars - Topic partitions with the offsets to seek to.
+ * @param {number} timeout - Number of ms to wait for the seeks to complete.
+ * Values below 10 ms, including 0, are raised to 10 ms, as without a timeout
+ * the seeks are asynchronous and report no per-partition errors.
+ * @param {Function} cb - Callback called with an error if the seek could not
+ * be performed at all, or with the topic partitions, each with an `error`
+ * property if seeking it failed.
+ * @return {Client} - Returns itself
+ */
+KafkaConsumer.prototype.seekPartitions = function(toppars, timeout, cb) {
+  this._client.seekPartitions(TopicPartition.map(toppars), timeout, function(err, topicPartitions) {
+    if (err) {
+      cb(LibrdKafkaError.create(err));
+      return;
+    }
+
+    for (var i = 0; i < topicPartitions.length; i++) {
+      if (topicPartitions[i].error) {
+        topicPartitions[i].error = LibrdKafkaError.create(topicPartitions[i].error);
+      }
+    }
+    cb(null, topicPartitions);
+  });
+  return this;
+};
+
 /**
  * Assign the consumer specific partitions and topics. Used for
  * eager (non-cooperative) rebalancing.
@@ -531,7 +686,7 @@ KafkaConsumer.prototype._consumeLoop = function(timeoutMs, cb) {
 KafkaConsumer.prototype._consumeNum = function(timeoutMs, numMessages, cb) {
   var self = this;
 
-  this._client.consume(timeoutMs, numMessages, this._consumeIsTimeoutOnlyForFirstMessage, function(err, messages, eofEvents) {
+  this._client.consume(timeoutMs, numMessages, this._consumeIsTimeoutOnlyForFirstMessage, this._consumeKafkaJSFormat, this._consumeWireFormat, function(err, messages, eofEvents) {
     if (err) {
       err = LibrdKafkaError.create(err);
       if (cb) {
@@ -576,6 +731,71 @@ KafkaConsumer.prototype._consumeNum = function(timeoutMs, numMessages, cb) {
  * @param {KafkaConsumer~Message} message
  */
 
+/**
+ * Record every message consumed from now on to a capture file.
+ *
+ * The capture keeps message sizes, keys, headers, partitions and the time
+ * each message was consumed, so it can later be fed back through
+ * {@link KafkaConsumer#startReplay} without a cluster.
+ *
+ * If a message cannot be written, e.g. because the disk is full, the capture
+ * is stopped and the write error is emitted once as an `event.log` with the
+ * `CAPTURE` facility. Consuming is not affected.
+ *
+ * @param {string} path - Capture file to create. Overwritten if it exists.
+ * @throws When the file cannot be created.
+ * @return {KafkaConsumer} - returns itself.
+ */
+KafkaConsumer.prototype.startCapture = function(path) {
+  this._client.startCapture(path);
+  return this;
+};
+
+/**
+ * Stop recording consumed messages and close the capture file.
+ *
+ * @return {KafkaConsumer} - returns itself.
+ */
+KafkaConsumer.prototype.stopCapture = function() {
+  this._client.stopCapture();
+  return this;
+};
+
+/**
+ * Serve consume calls from a capture file instead of from the cluster.
+ *
+ * Replayed messages go through the same native consume and conversion paths
+ * as consumed ones, which makes this useful to profile handlers offline.
+ * The consumer needs to be connected, but not subscribed. To replay without
+ * a cluster, connect it to librdkafka's mock cluster by setting
+ * `test.mock.num.brokers` instead of the bootstrap servers. Offsets of
+ * replayed messages must not be committed.
+ *
+ * @param {string} path - Capture file written by {@link KafkaConsumer#startCapture}.
+ * @param {object} [options]
+ * @param {number} [options.speed=0] - Playback speed relative to the capture.
+ * 0 replays as fast as possible, 1 at the original pace.
+ * @param {boolean} [options.loop=false] - Restart from the beginning at the
+ * end of the capture. Otherwise consume times out once it is exhausted.
+ * @throws When the file cannot be read or is not a valid capture.
+ * @return {KafkaConsumer} - returns itself.
+ */
+KafkaConsumer.prototype.startReplay = function(path, options) {
+  options = options || {};
+  this._client.startReplay(path, options.speed || 0, !!options.loop);
+  return this;
+};
+
+/**
+ * Stop replaying and consume from the cluster again.
+ *
+ * @return {KafkaConsumer} - returns itself.
+ */
+KafkaConsumer.prototype.stopReplay = function() {
+  this._client.stopReplay();
+  return this;
+};
+
 /**
  * Commit a topic partition or all topic partitions that have been read
  *
@@ -748,7 +968,11 @@ KafkaConsumer.prototype.resume = function(topicPartitions) {
     throw new Error('Client is disconnected');
   }
 
-  return this._errorWrap(this._client.resume(topicPartitions), true);
+  var result = this._errorWrap(this._client.resume(topicPartitions), true);
+  for (var i = 0; i < topicPartitions.length; i++) {
+    this._pausedPartitions.delete(topicPartitions[i].topic + '|' + topicPartitions[i].partition);
+  }
+  return result;
 };
 
 /**
@@ -762,5 +986,9 @@ KafkaConsumer.prototype.pause = function(topicPartitions) {
     throw new Error('Client is disconnected');
   }
 
-  return this._errorWrap(this._client.pause(topicPartitions), true);
+  var result = this._errorWrap(this._client.pause(topicPartitions), true);
+  for (var i = 0; i < topicPartitions.length; i++) {
+    this._pausedPartitions.add(topicPartitions[i].topic + '|' + topicPartitions[i].partition);
+  }
+  return result;
 };
@@ -21,10 +21,10 @@ const {
   DeferredPromise,
   Timer
 } = require('./_common');
-const { Buffer } = require('buffer');
 const MessageCache = require('./_consumer_cache');
 const { hrtime } = require('process');
 const { LinkedList } = require('./_linked-list');
+const { createEachMessagePayload } = require('./_consumer_payload');
 
 const ConsumerState = Object.freeze({
   INIT: 0,
@@ -282,33 +282,45 @@ class Consumer {
     this.#messageCacheMaxSize = 1;
     this.#increaseCount = 0;
     const clearPartitions = this.assignment();
-    const seeks = [];
+    const topicPartitionOffsets = [];
     for (const topicPartition of clearPartitions) {
       const key = partitionKey(topicPartition);
       if (!this.#lastConsumedOffsets.has(key))
         continue;
 
       const lastConsumedOffsets = this.#lastConsumedOffsets.get(key);
-      const topicPartitionOffsets = [
-        {
-          topic: topicPartition.topic,
-          partition: topicPartition.partition,
-          offset: lastConsumedOffsets.offset,
-          leaderEpoch: lastConsumedOffsets.leaderEpoch,
-        }
-      ];
-      seeks.push(this.#seekInternal(topicPartitionOffsets));
+      topicPartitionOffsets.push({
+        topic: topicPartition.topic,
+        partition: topicPartition.partition,
+        offset: lastConsumedOffsets.offset,
+        leaderEpoch: lastConsumedOffsets.leaderEpoch,
+      });
     }
 
-    await Promise.allSettled(seeks);
     try {
-      await Promise.all(seeks);
+      await this.#seekInternal(topicPartitionOffsets);
     } catch (err) {
       /* TODO: we should cry more about this and render the consumer unusable. */
       this.#logger.error(`Seek error. This is effectively a fatal error: ${err.stack}`);
     }
   }
 
+  /**
+   * Drop what's kept for partitions revoked in an incremental rebalance: their cached
+   * messages, their pending batch payloads (which become stale) and their last consumed
+   * offsets, which must not be used for seeking if they're assigned to us again.
+   * Retained partitions keep their cached messages and positions, so no seek is needed.
+   *
+   * @param {Array<{topic: string, partition: number}>} topicPartitions revoked partitions.
+   */
+  #dropRevokedPartitions(topicPartitions) {
+    this.#messageCache.markStale(topicPartitions);
+    this.#markBatchPayloadsStale(topicPartitions);
+    for (const topicPartition of topicPartitions) {
+      this.#lastConsumedOffsets.delete(partitionKey(topicPartition));
+    }
+  }
+
   #unassign(assignment) {
     if (this.#internalClient.rebalanceProtocol() === "EAGER") {
       this.#internalClient.unassign();
@@ -316,7 +328,7 @@ class Consumer {
       this.#partitionCount = 0;
     } else {
       this.#internalClient.incrementalUnassign(assignment);
-      this.#messageCache.markStale(assignment);
+      this.#dropRevokedPartitions(assignment);
       this.#partitionCount -= assignment.length;
     }
   }
@@ -675,60 +687,20 @@ class Consumer {
     }
   }
 
-  /**
-   * Converts headers returned by node-rdkafka into a format that can be used by the eachMessage/eachBatch callback.
-   * @param {import("../..").MessageHeader[] | undefined} messageHeaders
-   * @returns {import("../../types/kafkajs").IHeaders}
-   */
-  #createHeaders(messageHeaders) {
-    let headers;
-    if (messageHeaders) {
-      headers = {};
-      for (const header of messageHeaders) {
-        for (const [key, value] of Object.entries(header)) {
-          if (!Object.hasOwn(headers, key)) {
-            headers[key] = value;
-          } else if (headers[key].constructor === Array) {
-            headers[key].push(value);
-          } else {
-            headers[key] = [headers[key], value];
-          }
-        }
-      }
-    }
-    return headers;
-  }
-
   /**
    * Converts a message returned by node-rdkafka into a message that can be used by the eachMessage callback.
    * @param {import("../..").Message} message
+   * @param {import("./_consumer_cache").PerPartitionMessageCache} ppc - cache of the message's partition.
    * @returns {import("../../types/kafkajs").EachMessagePayload}
    */
-  #createPayload(message) {
-    let key = message.key;
-    if (typeof key === 'string') {
-      key = Buffer.from(key);
-    }
-
-    let timestamp = message.timestamp ? String(message.timestamp) : '';
-    const headers = this.#createHeaders(message.headers);
-
-    return {
-      topic: message.topic,
-      partition: message.partition,
-      message: {
-        key,
-        value: message.value,
-        timestamp,
-        attributes: 0,
-        offset: String(message.offset),
-        size: message.size,
-        leaderEpoch: message.leaderEpoch,
-        headers
-      },
-      heartbeat: async () => { /* no op */ },
-      pause: this.pause.bind(this, [{ topic: message.topic, partitions: [message.partition] }]),
-    };
+  #createPayload(message, ppc) {
+    /* The pause function only depends on the partition, create it once per assignment. */
+    let pause = ppc._pause;
+    if (!pause) {
+      pause = this.pause.bind(this, [{ topic: message.topic, partitions: [message.partition] }]);
+      ppc._pause = pause;
+    }
+    return createEachMessagePayload(message, pause);
   }
 
   /**
@@ -811,47 +783,35 @@ class Consumer {
   }
 
   /**
-   * Converts a list of messages returned by node-rdkafka into a message that can be used by the eachBatch callback.
-   * @param {import("../..").Message[]} messages - must not be empty. Must contain messages from the same topic and partition.
+   * Creates the payload for the eachBatch callback.
+   * @param {import("../../types/kafkajs").KafkaMessage[]} messages - must not be empty. Must contain messages from the
+   *                                                                  same topic and partition. These are already in their
+   *                                                                  final form, as the internal client is set to return
+   *                                                                  messages in the KafkaJS format when running eachBatch.
    * @returns {import("../../types/kafkajs").EachBatchPayload}
    */
   #createBatchPayload(messages) {
     const topic = messages[0].topic;
     const partition = messages[0].partition;
+    const firstOffset = messages[0].offset;
+    const lastOffset = messages[messages.length - 1].offset;
 
-    const messagesConverted = [];
-    for (let i = 0; i < messages.length; i++) {
-      const message = messages[i];
-      let key = message.key;
-      if (typeof key === 'string') {
-        key = Buffer.from(key);
-      }
-
-      let timestamp = message.timestamp ? String(message.timestamp) : '';
-      const headers = this.#createHeaders(message.headers);
-
-      const messageConverted = {
-        key,
-        value: message.value,
-        timestamp,
-        attributes: 0,
-        offset: String(message.offset),
-        size: message.size,
-        leaderEpoch: message.leaderEpoch,
-        headers
-      };
-
-      messagesConverted.push(messageConverted);
+    /* The watermarks are cached by librdkafka from fetch responses, so this does not incur network calls. */
+    let highWatermark = '-1001';
+    try {
+      highWatermark = String(this.#internalClient.getWatermarkOffsets(topic, partition).highOffset);
+    } catch (e) {
+      /* Watermarks aren't known yet, keep the default. */
     }
 
     const batch = {
       topic,
       partition,
-      highWatermark: '-1001', /* We don't fetch it yet. We can call committed() to fetch it but that might incur network calls. */
-      messages: messagesConverted,
+      highWatermark,
+      messages,
       isEmpty: () => false,
-      firstOffset: () => (messagesConverted[0].offset).toString(),
-      lastOffset: () => (messagesConverted[messagesConverted.length - 1].offset).toString(),
+      firstOffset: () => firstOffset,
+      lastOffset: () => lastOffset,
       offsetLag: () => notImplemented(),
       offsetLagLow: () => notImplemented(),
     };
@@ -1127,6 +1087,8 @@ class Consumer {
     }
 
     this.#messageCache = new MessageCache(this.#logger);
+    /* eachBatch hands messages to the user as they are returned, so have them converted natively. */
+    this.#internalClient._setKafkaJSMessageFormat(!!configCopy.eachBatch);
     /* We deliberately don't await this because we want to return from this method immediately. */
     this.#runInternal(configCopy);
   }
@@ -1143,7 +1105,7 @@ class Consumer {
     [m, ppc] = m;
     let key = partitionKey(m);
     let eachMessageProcessed = false;
-    const payload = this.#createPayload(m);
+    const payload = this.#createPayload(m, ppc);
 
     try {
       this.#lastConsumedOffsets.set(key, m);
@@ -1629,23 +1591,31 @@ class Consumer {
     }
 
     const offsetsToCommit = [];
-    const librdkafkaSeekPromises = [];
     for (const [key, topicPartitionOffset] of seekedPartitions) {
       this.#lastConsumedOffsets.delete(key);
       this.#messageCache.markStale([topicPartitionOffset]);
       offsetsToCommit.push(topicPartitionOffset);
+    }
 
+    /* Seek all partitions in a single call rather than using a thread pool task for each. */
+    if (offsetsToCommit.length !== 0) {
       const librdkafkaSeekPromise = new DeferredPromise();
-      this.#internalClient.seek(topicPartitionOffset, 1000,
-        (err) => {
-          if (err)
+      this.#internalClient.seekPartitions(offsetsToCommit, 1000,
+        (err, topicPartitions) => {
+          if (err) {
             this.#logger.error(`Error while calling seek from within seekInternal: ${err}`, this.#createConsumerBindingMessageMetadata());
+          } else {
+            for (const topicPartition of topicPartitions) {
+              if (topicPartition.error)
+                this.#logger.error(
+                  `Error while seeking ${topicPartition.topic}[${topicPartition.partition}] from within seekInternal: ${topicPartition.error}`,
+                  this.#createConsumerBindingMessageMetadata());
+            }
+          }
           librdkafkaSeekPromise.resolve();
         });
-      librdkafkaSeekPromises.push(librdkafkaSeekPromise);
+      await librdkafkaSeekPromise;
     }
-    await Promise.allSettled(librdkafkaSeekPromises);
-    await Promise.all(librdkafkaSeekPromises);
 
     for (const [key, ] of seekedPartitions) {
       this.#pendingSeeks.delete(key);
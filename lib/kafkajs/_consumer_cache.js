@@ -13,6 +13,8 @@ class PerPartitionMessageCache {
     #key = null;
     /* Whether the cache is assigned to a consumer. */
     _assigned = false;
+    /* eachMessage pause function for the partition, set by the consumer. */
+    _pause = null;
 
     constructor(key) {
         this.#key = key;
@@ -0,0 +1,138 @@
+const { Buffer } = require('buffer');
+
+/**
+ * Converts headers returned by node-rdkafka into a format that can be used by the eachMessage/eachBatch callback.
+ * @param {import("../..").MessageHeader[] | undefined} messageHeaders
+ * @returns {import("../../types/kafkajs").IHeaders}
+ */
+function createHeaders(messageHeaders) {
+    let headers;
+    if (messageHeaders) {
+        headers = {};
+        for (const header of messageHeaders) {
+            for (const [key, value] of Object.entries(header)) {
+                if (!Object.hasOwn(headers, key)) {
+                    headers[key] = value;
+                } else if (headers[key].constructor === Array) {
+                    headers[key].push(value);
+                } else {
+                    headers[key] = [headers[key], value];
+                }
+            }
+        }
+    }
+    return headers;
+}
+
+/* Shared by all payloads, there is nothing to do per call. */
+async function heartbeat() { /* no op */ }
+
+/**
+ * The message of an eachMessage payload.
+ *
+ * `offset`, `timestamp` and `headers` are converted from the node-rdkafka
+ * message the first time they are read, since many handlers never look at
+ * them. They are accessors on the prototype, which keeps every message the
+ * same shape, so spreading the message or `Object.keys` do not include them.
+ * `toJSON` returns a plain copy with all fields.
+ */
+class EachMessagePayloadMessage {
+    /* The node-rdkafka message the lazy fields are converted from. */
+    #source;
+    #offset;
+    #timestamp;
+    #headers;
+
+    constructor(message) {
+        let key = message.key;
+        if (typeof key === 'string') {
+            key = Buffer.from(key);
+        }
+
+        this.key = key;
+        this.value = message.value;
+        this.attributes = 0;
+        this.size = message.size;
+        this.leaderEpoch = message.leaderEpoch;
+        this.#source = message;
+    }
+
+    get offset() {
+        if (this.#offset === undefined) {
+            this.#offset = String(this.#source.offset);
+        }
+        return this.#offset;
+    }
+
+    set offset(offset) {
+        this.#offset = offset;
+    }
+
+    get timestamp() {
+        if (this.#timestamp === undefined) {
+            const timestamp = this.#source.timestamp;
+            this.#timestamp = timestamp ? String(timestamp) : '';
+        }
+        return this.#timestamp;
+    }
+
+    set timestamp(timestamp) {
+        this.#timestamp = timestamp;
+    }
+
+    get headers() {
+        if (this.#headers === undefined) {
+            /* createHeaders returns undefined for messages without headers,
+             * use null as the "converted" marker in that case. */
+            this.#headers = createHeaders(this.#source.headers) ?? null;
+        }
+        return this.#headers ?? undefined;
+    }
+
+    set headers(headers) {
+        this.#headers = headers ?? null;
+    }
+
+    /* A plain copy with all fields, in KafkaJS order, also for spreading. */
+    toJSON() {
+        return {
+            key: this.key,
+            value: this.value,
+            timestamp: this.timestamp,
+            attributes: this.attributes,
+            offset: this.offset,
+            size: this.size,
+            leaderEpoch: this.leaderEpoch,
+            headers: this.headers,
+        };
+    }
+}
+
+/* Make the lazy fields show up in for...in like the own properties do. */
+for (const name of ['offset', 'timestamp', 'headers']) {
+    const descriptor = Object.getOwnPropertyDescriptor(EachMessagePayloadMessage.prototype, name);
+    descriptor.enumerable = true;
+    Object.defineProperty(EachMessagePayloadMessage.prototype, name, descriptor);
+}
+
+/**
+ * Creates the payload passed to eachMessage.
+ * @param {import("../..").Message} message
+ * @param {Function} pause - pause function for the partition of the message, shared between its payloads.
+ * @returns {import("../../types/kafkajs").EachMessagePayload}
+ */
+function createEachMessagePayload(message, pause) {
+    return {
+        topic: message.topic,
+        partition: message.partition,
+        message: new EachMessagePayloadMessage(message),
+        heartbeat,
+        pause,
+    };
+}
+
+module.exports = {
+    createHeaders,
+    createEachMessagePayload,
+    EachMessagePayloadMessage,
+};
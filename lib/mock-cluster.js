@@ -0,0 +1,171 @@
+/*
+ * confluent-kafka-javascript - Node.js wrapper  for RdKafka C/C++ library
+ *
+ * Copyright (c) 2024 Confluent, Inc.
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE.txt file for details.
+ */
+
+module.exports = MockCluster;
+
+/**
+ * Kafka protocol API keys, for injecting request errors.
+ *
+ * @readonly
+ * @enum {number}
+ */
+MockCluster.ApiKeys = {
+  Produce: 0,
+  Fetch: 1,
+  ListOffsets: 2,
+  Metadata: 3,
+  OffsetCommit: 8,
+  OffsetFetch: 9,
+  FindCoordinator: 10,
+  JoinGroup: 11,
+  Heartbeat: 12,
+  LeaveGroup: 13,
+  SyncGroup: 14,
+  DescribeGroups: 15,
+  ListGroups: 16,
+  ApiVersions: 18,
+  CreateTopics: 19,
+  DeleteTopics: 20,
+  InitProducerId: 22,
+  AddPartitionsToTxn: 24,
+  AddOffsetsToTxn: 25,
+  EndTxn: 26,
+  TxnOffsetCommit: 28,
+};
+
+/**
+ * Controls for librdkafka's in-process mock cluster.
+ *
+ * Obtained through {@link Client#getMockCluster} from a connected client
+ * created with `test.mock.num.brokers`. Other clients use the cluster
+ * through {@link MockCluster#bootstrapServers}, and are affected by all
+ * injected latencies and faults. The cluster lives as long as the client
+ * that created it.
+ *
+ * Broker ids start at 1.
+ *
+ * @param {Client} client - The client owning the mock cluster.
+ * @constructor
+ */
+function MockCluster(client) {
+  if (!(this instanceof MockCluster)) {
+    return new MockCluster(client);
+  }
+
+  this._client = client;
+}
+
+// Methods of the native client throw if it is not connected, or was not
+// created with a mock cluster.
+MockCluster.prototype._native = function() {
+  return this._client.getClient();
+};
+
+/**
+ * Bootstrap servers through which other clients connect to the cluster.
+ *
+ * @return {string} - Comma separated list of broker addresses.
+ */
+MockCluster.prototype.bootstrapServers = function() {
+  return this._native().mockBootstrapServers();
+};
+
+/**
+ * Set the round-trip time of a broker. Every response from it is delayed
+ * by this amount.
+ *
+ * @param {number} brokerId - Broker id.
+ * @param {number} rttMs - Round-trip time in milliseconds, 0 to reset.
+ * @return {MockCluster} - returns itself.
+ */
+MockCluster.prototype.setBrokerRtt = function(brokerId, rttMs) {
+  this._native().mockBrokerSetRtt(brokerId, rttMs);
+  return this;
+};
+
+/**
+ * Take a broker down: its connections are closed and new ones are refused.
+ *
+ * @param {number} brokerId - Broker id.
+ * @return {MockCluster} - returns itself.
+ */
+MockCluster.prototype.setBrokerDown = function(brokerId) {
+  this._native().mockBrokerSetUp(brokerId, false);
+  return this;
+};
+
+/**
+ * Bring a broker taken down with {@link MockCluster#setBrokerDown} back up.
+ *
+ * @param {number} brokerId - Broker id.
+ * @return {MockCluster} - returns itself.
+ */
+MockCluster.prototype.setBrokerUp = function(brokerId) {
+  this._native().mockBrokerSetUp(brokerId, true);
+  return this;
+};
+
+/**
+ * Move the leadership of a partition to another broker.
+ *
+ * @param {string} topic - Topic name.
+ * @param {number} partition - Partition.
+ * @param {number} brokerId - New leader, or -1 for no leader.
+ * @return {MockCluster} - returns itself.
+ */
+MockCluster.prototype.setPartitionLeader = function(topic, partition, brokerId) {
+  this._native().mockPartitionSetLeader(topic, partition, brokerId);
+  return this;
+};
+
+/**
+ * Fail the next requests of a type, one error per request, in order.
+ *
+ * @param {number|string} apiKey - API key, or its name in {@link MockCluster.ApiKeys}.
+ * @param {number[]} errors - Error codes, see `CODES.ERRORS`.
+ * @return {MockCluster} - returns itself.
+ */
+MockCluster.prototype.pushRequestErrors = function(apiKey, errors) {
+  this._native().mockPushRequestErrors(resolveApiKey(apiKey), errors);
+  return this;
+};
+
+/**
+ * Drop all errors pushed for a request type which were not returned yet.
+ *
+ * @param {number|string} apiKey - API key, or its name in {@link MockCluster.ApiKeys}.
+ * @return {MockCluster} - returns itself.
+ */
+MockCluster.prototype.clearRequestErrors = function(apiKey) {
+  this._native().mockClearRequestErrors(resolveApiKey(apiKey));
+  return this;
+};
+
+/**
+ * Create a topic directly on the cluster, bypassing the admin API.
+ *
+ * @param {string} topic - Topic name.
+ * @param {number} numPartitions - Number of partitions.
+ * @param {number} [replicationFactor=1] - Replication factor.
+ * @return {MockCluster} - returns itself.
+ */
+MockCluster.prototype.createTopic = function(topic, numPartitions, replicationFactor) {
+  this._native().mockTopicCreate(topic, numPartitions, replicationFactor || 1);
+  return this;
+};
+
+function resolveApiKey(apiKey) {
+  if (typeof apiKey === 'string') {
+    if (!Object.prototype.hasOwnProperty.call(MockCluster.ApiKeys, apiKey)) {
+      throw new TypeError('Unknown API key "' + apiKey + '"');
+    }
+    return MockCluster.ApiKeys[apiKey];
+  }
+  return apiKey;
+}
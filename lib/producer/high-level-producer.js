@@ -11,8 +11,6 @@ module.exports = HighLevelProducer;
 
 var util = require('util');
 var Producer = require('../producer');
-var EventEmitter = require('events').EventEmitter;
-var RefCounter = require('../tools/ref-counter');
 var shallowCopy = require('../util').shallowCopy;
 
 util.inherits(HighLevelProducer, Producer);
@@ -96,7 +94,7 @@ function createTopicSerializer(serializer) {
  * 1. You may not define opaque tokens
  *    The higher level producer is powered by opaque tokens.
  * 2. Every message ack will dispatch an event on the node thread.
- * 3. Will use a ref counter to determine if there are outgoing produces.
+ * 3. Delivery reports are polled for on the librdkafka background thread.
  *
  * This will return the new object you should use instead when doing your
  * produce calls
@@ -121,41 +119,41 @@ function HighLevelProducer(conf, topicConf) {
   Producer.call(this, conf, topicConf);
   var self = this;
 
-  // Add a delivery emitter to the producer
   this._hl = {
-    deliveryEmitter: new EventEmitter(),
-    messageId: 0,
-    // Special logic for polling. We use a reference counter to know when we need
-    // to be doing it and when we can stop. This means when we go into fast polling
-    // mode we don't need to do multiple calls to poll since they all will yield
-    // the same result
-    pollingRefTimeout: null,
+    // Delivery callbacks, indexed by the message ID in the opaque of each
+    // message. IDs are reused once their delivery report arrives.
+    callbacks: [],
+    freeIds: [],
+    nextId: 0,
+    // Callback, error and offset of each delivery report of the current
+    // dispatcher flush, called together on the next turn of the event loop
+    delivered: [],
   };
 
-  // Add the polling ref counter to the class which ensures we poll when we go active
-  this._hl.pollingRef = new RefCounter(function() {
-    self._hl.pollingRefTimeout = setInterval(function() {
-      try {
-        self.poll();
-      } catch {
-        if (!self._isConnected) {
-          // If we got disconnected for some reason there is no point
-          // in polling anymore
-          clearInterval(self._hl.pollingRefTimeout);
-        }
-      }
-    }, 1);
-  }, function() {
-    clearInterval(self._hl.pollingRefTimeout);
+  // Rather than polling from a timer while messages are in flight, let the
+  // librdkafka background thread serve delivery reports, which wakes up the
+  // delivery report dispatcher as they arrive.
+  this.on('ready', function() {
+    self.setPollInBackground(true);
   });
 
-  // Default poll interval. More sophisticated polling is also done in create rule method
-  this.setPollInterval(1000);
-
-  // Listen to all delivery reports to propagate elements with a _message_id to the emitter
+  // Look up the callback of every delivery report with a _message_id
   this.on('delivery-report', function(err, report) {
-    if (report.opaque && report.opaque.__message_id !== undefined) {
-      self._hl.deliveryEmitter.emit(report.opaque.__message_id, err, report.offset);
+    if (!report.opaque || report.opaque.__message_id === undefined) {
+      return;
+    }
+    var id = report.opaque.__message_id;
+    var callback = self._hl.callbacks[id];
+    if (callback === undefined) {
+      return;
+    }
+    self._hl.callbacks[id] = undefined;
+    self._hl.freeIds.push(id);
+
+    var delivered = self._hl.delivered;
+    delivered.push(callback, err, report.offset);
+    if (delivered.length === 3) {
+      setImmediate(callDelivered, self._hl);
     }
   });
 
@@ -168,6 +166,32 @@ function HighLevelProducer(conf, topicConf) {
   this.valueSerializer = noopSerializer;
 }
 
+/**
+ * Call the delivery callbacks collected from a dispatcher flush
+ *
+ * @param {object} hl - High level producer state
+ * @private
+ */
+function callDelivered(hl) {
+  var delivered = hl.delivered;
+  hl.delivered = [];
+  for (var i = 0; i < delivered.length; i += 3) {
+    try {
+      // Offset must be greater than or equal to 0 otherwise it is a null offset
+      // Possibly because we have acks off
+      var offset = delivered[i + 2];
+      delivered[i](delivered[i + 1], offset >= 0 ? offset : null);
+    } catch (e) {
+      // Still call the remaining callbacks
+      hl.delivered = delivered.slice(i + 3).concat(hl.delivered);
+      if (hl.delivered.length > 0) {
+        setImmediate(callDelivered, hl);
+      }
+      throw e;
+    }
+  }
+}
+
 /**
  * Produce a message to Kafka asynchronously.
  *
@@ -195,13 +219,6 @@ HighLevelProducer.prototype._modifiedProduce = function(topic, partition, messag
     headers = undefined;
   }
 
-  // Add the message id
-  var opaque = {
-    __message_id: this._hl.messageId++,
-  };
-
-  this._hl.pollingRef.increment();
-
   var self = this;
 
   var resolvedSerializedValue;
@@ -211,22 +228,17 @@ HighLevelProducer.prototype._modifiedProduce = function(topic, partition, messag
   // Actually do the produce with new key and value based on deserialized
   // results
   function doProduce(v, k) {
+    var hl = self._hl;
+    var id = hl.freeIds.length > 0 ? hl.freeIds.pop() : hl.nextId++;
+    hl.callbacks[id] = callback;
+
     try {
-      var r = self._oldProduce(topic, partition,
+      return self._oldProduce(topic, partition,
         v, k,
-        timestamp, opaque, headers);
-
-      self._hl.deliveryEmitter.once(opaque.__message_id, function(err, offset) {
-        self._hl.pollingRef.decrement();
-        setImmediate(function() {
-          // Offset must be greater than or equal to 0 otherwise it is a null offset
-          // Possibly because we have acks off
-          callback(err, offset >= 0 ? offset : null);
-        });
-      });
-
-      return r;
+        timestamp, { __message_id: id }, headers);
     } catch (e) {
+      hl.callbacks[id] = undefined;
+      hl.freeIds.push(id);
       callback(e);
     }
   }
@@ -15,6 +15,7 @@ var util = require('util');
 var lib = require('../librdkafka');
 var Topic = require('./topic');
 var Admin = require('./admin');
+var MockCluster = require('./mock-cluster');
 var features = lib.features().split(',');
 
 module.exports = {
@@ -29,6 +30,7 @@ module.exports = {
     ERRORS: error.codes,
   },
   Topic: Topic,
+  MockCluster: MockCluster,
   features: features,
   librdkafkaVersion: lib.librdkafkaVersion,
 };
@@ -0,0 +1,68 @@
+/*
+ * confluent-kafka-javascript - Node.js wrapper  for RdKafka C/C++ library
+ *
+ * Copyright (c) 2016-2023 Blizzard Entertainment
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE.txt file for details.
+ */
+
+module.exports = RingBuffer;
+
+/**
+ * Ring buffer class.
+ *
+ * A first in, first out queue with constant time push and shift, that grows
+ * by doubling its capacity when full.
+ *
+ * For the consumer stream, it holds the messages fetched ahead of reads.
+ */
+function RingBuffer() {
+  this.items = new Array(16);
+  this.head = 0;
+  this.length = 0;
+}
+
+/**
+ * Add an item to the end of the buffer
+ */
+RingBuffer.prototype.push = function(item) {
+  var capacity = this.items.length;
+  if (this.length === capacity) {
+    var items = new Array(capacity * 2);
+    for (var i = 0; i < capacity; i++) {
+      items[i] = this.items[(this.head + i) & (capacity - 1)];
+    }
+    this.items = items;
+    this.head = 0;
+    capacity = items.length;
+  }
+  this.items[(this.head + this.length) & (capacity - 1)] = item;
+  this.length++;
+};
+
+/**
+ * Remove and return the item at the start of the buffer
+ *
+ * @return {*} - The item, or undefined if the buffer is empty
+ */
+RingBuffer.prototype.shift = function() {
+  if (this.length === 0) {
+    return undefined;
+  }
+  var item = this.items[this.head];
+  // Release the item so it can be garbage collected
+  this.items[this.head] = undefined;
+  this.head = (this.head + 1) & (this.items.length - 1);
+  this.length--;
+  return item;
+};
+
+/**
+ * Remove all items
+ */
+RingBuffer.prototype.clear = function() {
+  this.items = new Array(16);
+  this.head = 0;
+  this.length = 0;
+};
@@ -21,5 +21,6 @@ export {
   BasicAuthCredentials,
   BearerAuthCredentials,
   ClientConfig,
+  EndpointMetrics,
   SaslInfo
 } from './rest-service';
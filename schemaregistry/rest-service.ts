@@ -3,6 +3,8 @@ import { OAuthClient } from './oauth/oauth-client';
 import { RestError } from './rest-error';
 import axiosRetry from "axios-retry";
 import { fullJitter, isRetriable } from './retry-helper';
+import http from 'http';
+import https from 'https';
 /*
  * Confluent-Schema-Registry-TypeScript - Node.js wrapper for Confluent Schema Registry
  *
@@ -46,6 +48,73 @@ export interface ClientConfig {
   maxRetries?: number,
   retriesWaitMs?: number,
   retriesMaxWaitMs?: number,
+  // maxConnections caps the kept-alive connections to each base URL
+  maxConnections?: number,
+  // maxConcurrentRequests caps the requests in flight, further requests wait
+  maxConcurrentRequests?: number,
+}
+
+/**
+ * EndpointMetrics holds the latency of the requests to one endpoint, such as
+ * `GET /subjects/{}/versions/{}`, including retries and failover.
+ */
+export interface EndpointMetrics {
+  count: number,
+  errors: number,
+  totalMs: number,
+  maxMs: number,
+}
+
+interface Agents {
+  httpAgent: http.Agent,
+  httpsAgent: https.Agent,
+}
+
+// Path segments that name a collection, the segment after one is an identifier
+const collectionSegments = new Set([
+  'subjects', 'versions', 'ids', 'guids', 'config', 'mode', 'contexts', 'keks', 'deks',
+]);
+
+// endpointOf returns the URL with its query and identifiers stripped, to
+// group the metrics of requests to the same endpoint
+function endpointOf(method: string, url: string): string {
+  const query = url.indexOf('?');
+  const segments = (query < 0 ? url : url.substring(0, query)).split('/');
+  for (let i = 1; i < segments.length; i++) {
+    if (collectionSegments.has(segments[i - 1]) && segments[i] !== '') {
+      segments[i] = '{}';
+    }
+  }
+  return `${method} ${segments.join('/')}`;
+}
+
+/**
+ * RequestLimiter bounds the number of requests in flight, queueing the rest.
+ */
+class RequestLimiter {
+  private active: number = 0;
+  private waiting: Array<() => void> = [];
+
+  constructor(private max: number) {
+  }
+
+  async acquire(): Promise<void> {
+    if (this.active < this.max) {
+      this.active++;
+      return;
+    }
+    // The slot is handed over by release()
+    await new Promise<void>(resolve => this.waiting.push(resolve));
+  }
+
+  release(): void {
+    const next = this.waiting.shift();
+    if (next) {
+      next();
+    } else {
+      this.active--;
+    }
+  }
 }
 
 const toBase64 = (str: string): string => Buffer.from(str).toString('base64');
@@ -55,11 +124,24 @@ export class RestService {
   private baseURLs: string[];
   private oauthClient?: OAuthClient;
   private oauthBearer: boolean = false;
+  // keep-alive agents per base URL, unless agents were given in axiosDefaults
+  private agents?: Map<string, Agents>;
+  private maxConnections?: number;
+  private limiter?: RequestLimiter;
+  private metrics: Map<string, EndpointMetrics> = new Map();
 
   constructor(baseURLs: string[], isForward?: boolean, axiosDefaults?: CreateAxiosDefaults,
               basicAuthCredentials?: BasicAuthCredentials, bearerAuthCredentials?: BearerAuthCredentials,
-              maxRetries?: number, retriesWaitMs?: number, retriesMaxWaitMs?: number) {
+              maxRetries?: number, retriesWaitMs?: number, retriesMaxWaitMs?: number,
+              maxConnections?: number, maxConcurrentRequests?: number) {
     this.client = axios.create(axiosDefaults);
+    if (axiosDefaults?.httpAgent == null && axiosDefaults?.httpsAgent == null) {
+      this.agents = new Map();
+      this.maxConnections = maxConnections;
+    }
+    if (maxConcurrentRequests != null && maxConcurrentRequests > 0) {
+      this.limiter = new RequestLimiter(maxConcurrentRequests);
+    }
     axiosRetry(this.client, {
       retries: maxRetries ?? 2,
       retryDelay: (retryCount) => {
@@ -170,10 +252,32 @@ export class RestService {
       await this.setOAuthBearerToken();
     }
 
+    await this.limiter?.acquire();
+    const start = process.hrtime.bigint();
+    let failed = true;
+    try {
+      const response = await this.requestWithFailover<T>(url, method, data, config);
+      failed = false;
+      return response;
+    } finally {
+      this.limiter?.release();
+      this.recordLatency(endpointOf(method, url), Number(process.hrtime.bigint() - start) / 1e6, failed);
+    }
+  }
+
+  private async requestWithFailover<T>(
+    url: string,
+    method: 'GET' | 'POST' | 'PUT' | 'DELETE',
+    data?: any, // eslint-disable-line @typescript-eslint/no-explicit-any
+    config?: AxiosRequestConfig,
+  ): Promise<AxiosResponse<T>> {
     for (let i = 0; i < this.baseURLs.length; i++) {
       try {
-        this.setBaseURL(this.baseURLs[i]);
+        // The base URL is set per request, as concurrent requests may fail over
+        const baseURL = this.baseURLs[i];
         const response = await this.client.request<T>({
+          baseURL,
+          ...this.getAgents(baseURL),
           url,
           method,
           data,
@@ -198,6 +302,51 @@ export class RestService {
     throw new Error('Internal HTTP retry error'); // Should never reach here
   }
 
+  private getAgents(baseURL: string): Agents | undefined {
+    if (this.agents == null) {
+      return undefined;
+    }
+    let agents = this.agents.get(baseURL);
+    if (agents == null) {
+      const options = { keepAlive: true, maxSockets: this.maxConnections ?? Infinity };
+      agents = { httpAgent: new http.Agent(options), httpsAgent: new https.Agent(options) };
+      this.agents.set(baseURL, agents);
+    }
+    return agents;
+  }
+
+  private recordLatency(endpoint: string, elapsedMs: number, failed: boolean): void {
+    let metrics = this.metrics.get(endpoint);
+    if (metrics == null) {
+      metrics = { count: 0, errors: 0, totalMs: 0, maxMs: 0 };
+      this.metrics.set(endpoint, metrics);
+    }
+    metrics.count++;
+    if (failed) {
+      metrics.errors++;
+    }
+    metrics.totalMs += elapsedMs;
+    metrics.maxMs = Math.max(metrics.maxMs, elapsedMs);
+  }
+
+  /**
+   * Returns the request latency per endpoint since the service was created.
+   */
+  getMetrics(): Map<string, EndpointMetrics> {
+    return new Map(Array.from(this.metrics, ([endpoint, metrics]) => [endpoint, { ...metrics }]));
+  }
+
+  /**
+   * Closes the kept-alive connections.
+   */
+  close(): void {
+    this.agents?.forEach(agents => {
+      agents.httpAgent.destroy();
+      agents.httpsAgent.destroy();
+    });
+    this.agents?.clear();
+  }
+
   setHeaders(headers: Record<string, string>): void {
     this.client.defaults.headers.common = { ...this.client.defaults.headers.common, ...headers }
   }
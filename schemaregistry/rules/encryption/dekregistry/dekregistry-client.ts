@@ -49,10 +49,11 @@ interface Dek {
 interface DekClient {
   registerKek(name: string, kmsType: string, kmsKeyId: string, shared: boolean,
               kmsProps?: { [key: string]: string }, doc?: string): Promise<Kek>;
-  getKek(name: string, deleted: boolean): Promise<Kek>;
+  getKek(name: string, deleted: boolean, skipCache?: boolean): Promise<Kek>;
   registerDek(kekName: string, subject: string, algorithm: string, version: number,
               encryptedKeyMaterial?: string): Promise<Dek>;
-  getDek(kekName: string, subject: string, algorithm: string, version: number, deleted: boolean): Promise<Dek>;
+  getDek(kekName: string, subject: string, algorithm: string, version: number, deleted: boolean,
+         skipCache?: boolean): Promise<Dek>;
   close(): Promise<void>;
 }
 
@@ -72,7 +73,8 @@ class DekRegistryClient implements DekClient {
 
     this.restService = new RestService(config.baseURLs, config.isForward, config.createAxiosDefaults,
       config.basicAuthCredentials, config.bearerAuthCredentials,
-      config.maxRetries, config.retriesWaitMs, config.retriesMaxWaitMs);
+      config.maxRetries, config.retriesWaitMs, config.retriesMaxWaitMs,
+      config.maxConnections, config.maxConcurrentRequests);
     this.kekCache = new LRUCache<string, Kek>(cacheOptions);
     this.dekCache = new LRUCache<string, Dek>(cacheOptions);
     this.kekMutex = new Mutex();
@@ -162,11 +164,11 @@ class DekRegistryClient implements DekClient {
     });
   }
 
-  async getKek(name: string, deleted: boolean = false): Promise<Kek> {
+  async getKek(name: string, deleted: boolean = false, skipCache: boolean = false): Promise<Kek> {
     const cacheKey = stringify({ name, deleted });
 
     return await this.kekMutex.runExclusive(async () => {
-      const kek = this.kekCache.get(cacheKey);
+      const kek = skipCache ? undefined : this.kekCache.get(cacheKey);
       if (kek) {
         return kek;
       }
@@ -212,11 +214,11 @@ class DekRegistryClient implements DekClient {
   }
 
   async getDek(kekName: string, subject: string,
-    algorithm: string, version: number = 1, deleted: boolean = false): Promise<Dek> {
+    algorithm: string, version: number = 1, deleted: boolean = false, skipCache: boolean = false): Promise<Dek> {
     const cacheKey = stringify({ kekName, subject, version, algorithm, deleted });
 
     return await this.dekMutex.runExclusive(async () => {
-      const dek = this.dekCache.get(cacheKey);
+      const dek = skipCache ? undefined : this.dekCache.get(cacheKey);
       if (dek) {
         return dek;
       }
@@ -232,7 +234,7 @@ class DekRegistryClient implements DekClient {
   }
 
   async close(): Promise<void> {
-    return;
+    this.restService.close();
   }
 
   //Cache methods for testing
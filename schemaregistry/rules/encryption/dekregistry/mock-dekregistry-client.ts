@@ -33,7 +33,7 @@ class MockDekRegistryClient implements DekClient {
     return kek;
   }
 
-  async getKek(name: string, deleted: boolean = false): Promise<Kek> {
+  async getKek(name: string, deleted: boolean = false, skipCache: boolean = false): Promise<Kek> {
     const cacheKey = stringify({ name, deleted });
     const cachedKek = this.kekCache.get(cacheKey);
     if (cachedKek && (!cachedKek.deleted || deleted)) {
@@ -65,7 +65,7 @@ class MockDekRegistryClient implements DekClient {
   }
 
   async getDek(kekName: string, subject: string,
-    algorithm: string, version: number = 1, deleted: boolean = false): Promise<Dek> {
+    algorithm: string, version: number = 1, deleted: boolean = false, skipCache: boolean = false): Promise<Dek> {
     if (version === -1) {
       let latestVersion = 0;
       for (const key of this.dekCache.keys()) {
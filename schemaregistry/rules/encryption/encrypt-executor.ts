@@ -10,6 +10,7 @@ import {
 import {RuleMode,} from "../../schemaregistry-client";
 import {DekClient, Dek, DekRegistryClient, Kek} from "./dekregistry/dekregistry-client";
 import {RuleRegistry} from "../../serde/rule-registry";
+import {KeyCache} from "./key-cache";
 import {ClientConfig} from "../../rest-service";
 import {RestError} from "../../rest-error";
 import * as Random from './tink/random';
@@ -19,6 +20,7 @@ import {AesGcmKey, AesGcmKeySchema} from "./tink/proto/aes_gcm_pb";
 import {AesSivKey, AesSivKeySchema} from "./tink/proto/aes_siv_pb";
 import {create, fromBinary, toBinary} from "@bufbuild/protobuf";
 import {fromRawKey as aesGcmFromRawKey} from "./tink/aes_gcm";
+import {Aead} from "./tink/aead";
 import {fromRawKey as aesSivFromRawKey} from "./tink/aes_siv";
 
 // EncryptKekName represents a kek name
@@ -32,6 +34,14 @@ const ENCRYPT_DEK_ALGORITHM = 'encrypt.dek.algorithm'
 // EncryptDekExpiryDays represents dek expiry days
 const ENCRYPT_DEK_EXPIRY_DAYS = 'encrypt.dek.expiry.days'
 
+// EncryptCacheTtlSecs represents how long KEKs and DEKs are cached before they are refreshed
+const ENCRYPT_CACHE_TTL_SECS = 'encrypt.cache.ttl.secs'
+// EncryptCacheNegativeTtlSecs represents how long missing KEKs and DEKs are cached
+const ENCRYPT_CACHE_NEGATIVE_TTL_SECS = 'encrypt.cache.negative.ttl.secs'
+
+const DEFAULT_CACHE_TTL_SECS = 300
+const DEFAULT_CACHE_NEGATIVE_TTL_SECS = 10
+
 // MillisInDay represents number of milliseconds in a day
 const MILLIS_IN_DAY = 24 * 60 * 60 * 1000
 
@@ -60,9 +70,17 @@ export class Clock {
   }
 }
 
+interface KeyCaches {
+  keks: KeyCache<Kek>
+  deks: KeyCache<Dek>
+}
+
 export class FieldEncryptionExecutor extends FieldRuleExecutor {
   client: DekClient | null = null
   clock: Clock
+  cacheCapacity: number | undefined
+  // KEKs and DEKs of each DEK registry client
+  private keyCaches = new WeakMap<DekClient, KeyCaches>()
 
   /**
    * Register the field encryption executor with the rule registry.
@@ -85,12 +103,44 @@ export class FieldEncryptionExecutor extends FieldRuleExecutor {
   override configure(clientConfig: ClientConfig, config: Map<string, string>) {
     this.client = DekRegistryClient.newClient(clientConfig)
     this.config = config
+    this.cacheCapacity = clientConfig.cacheCapacity
   }
 
   override type(): string {
     return 'ENCRYPT'
   }
 
+  // getKeyCaches returns the KEK and DEK caches of the current client
+  getKeyCaches(): KeyCaches {
+    let caches = this.keyCaches.get(this.client!)
+    if (caches == null) {
+      const ttlMs = this.getConfigSecs(ENCRYPT_CACHE_TTL_SECS, DEFAULT_CACHE_TTL_SECS) * 1000
+      const negativeTtlMs =
+        this.getConfigSecs(ENCRYPT_CACHE_NEGATIVE_TTL_SECS, DEFAULT_CACHE_NEGATIVE_TTL_SECS) * 1000
+      // Refresh in the last tenth of the TTL
+      const refreshAheadMs = ttlMs / 10
+      caches = {
+        // Sized like the caches of the DEK registry client
+        keks: new KeyCache<Kek>(this.clock, ttlMs, refreshAheadMs, negativeTtlMs, this.cacheCapacity),
+        deks: new KeyCache<Dek>(this.clock, ttlMs, refreshAheadMs, negativeTtlMs, this.cacheCapacity),
+      }
+      this.keyCaches.set(this.client!, caches)
+    }
+    return caches
+  }
+
+  private getConfigSecs(name: string, defaultSecs: number): number {
+    const value = this.config?.get(name)
+    if (value == null) {
+      return defaultSecs
+    }
+    const secs = Number(value)
+    if (isNaN(secs) || secs < 0) {
+      throw new RuleError(`invalid ${name}`)
+    }
+    return secs
+  }
+
   override newTransform(ctx: RuleContext): FieldTransform {
     const cryptor = this.getCryptor(ctx)
     const kekName = this.getKekName(ctx)
@@ -192,56 +242,55 @@ export class Cryptor {
   }
 
   async encrypt(dek: Buffer, plaintext: Buffer): Promise<Buffer> {
-    let rawKey
-    switch (this.dekFormat) {
-      case DekFormat.AES256_SIV:
-        const aesSivKey = fromBinary(AesSivKeySchema, dek)
-        rawKey = aesSivKey.keyValue
-        return Buffer.from(await this.encryptWithAesSiv(rawKey, plaintext))
-      case DekFormat.AES128_GCM:
-      case DekFormat.AES256_GCM:
-        const aesGcmKey = fromBinary(AesGcmKeySchema, dek)
-        rawKey = aesGcmKey.keyValue
-        return Buffer.from(await this.encryptWithAesGcm(rawKey, plaintext))
-      default:
-        throw new RuleError('unsupported dek format')
-    }
+    const aead = await this.getAead(dek)
+    return toBuffer(await aead.encrypt(plaintext, Cryptor.EMPTY_AAD))
   }
 
   async decrypt(dek: Buffer, ciphertext: Buffer): Promise<Buffer> {
-    let rawKey
+    const aead = await this.getAead(dek)
+    return toBuffer(await aead.decrypt(ciphertext, Cryptor.EMPTY_AAD))
+  }
+
+  // getAead returns the primitive for the given DEK, which is created once
+  // per DEK and shared by all the cryptors of its format
+  getAead(dek: Buffer): Promise<Aead> {
+    let entry = aeadCache.get(dek)
+    if (entry == null || entry.dekFormat !== this.dekFormat) {
+      entry = { dekFormat: this.dekFormat, aead: this.newAead(dek) }
+      aeadCache.set(dek, entry)
+    }
+    return entry.aead
+  }
+
+  private async newAead(dek: Buffer): Promise<Aead> {
     switch (this.dekFormat) {
       case DekFormat.AES256_SIV:
-        const aesSivKey = fromBinary(AesSivKeySchema, dek)
-        rawKey = aesSivKey.keyValue
-        return Buffer.from(await this.decryptWithAesSiv(rawKey, ciphertext))
+        return await aesSivFromRawKey(fromBinary(AesSivKeySchema, dek).keyValue)
       case DekFormat.AES128_GCM:
       case DekFormat.AES256_GCM:
-        const aesGcmKey = fromBinary(AesGcmKeySchema, dek)
-        rawKey = aesGcmKey.keyValue
-        return Buffer.from(await this.decryptWithAesGcm(rawKey, ciphertext))
+        return await aesGcmFromRawKey(fromBinary(AesGcmKeySchema, dek).keyValue)
       default:
         throw new RuleError('unsupported dek format')
     }
   }
 
   async encryptWithAesSiv(key: Uint8Array, plaintext: Uint8Array): Promise<Uint8Array> {
-    const aead = await aesSivFromRawKey(key)
+    const aead = await getRawKeyAead(key, aesSivFromRawKey)
     return aead.encrypt(plaintext, Cryptor.EMPTY_AAD)
   }
 
   async decryptWithAesSiv(key: Uint8Array, ciphertext: Uint8Array): Promise<Uint8Array> {
-    const aead = await aesSivFromRawKey(key)
+    const aead = await getRawKeyAead(key, aesSivFromRawKey)
     return aead.decrypt(ciphertext, Cryptor.EMPTY_AAD)
   }
 
   async encryptWithAesGcm(key: Uint8Array, plaintext: Uint8Array): Promise<Uint8Array> {
-    const aead = await aesGcmFromRawKey(key)
+    const aead = await getRawKeyAead(key, aesGcmFromRawKey)
     return aead.encrypt(plaintext, Cryptor.EMPTY_AAD)
   }
 
   async decryptWithAesGcm(key: Uint8Array, ciphertext: Uint8Array): Promise<Uint8Array> {
-    const aead = await aesGcmFromRawKey(key)
+    const aead = await getRawKeyAead(key, aesGcmFromRawKey)
     return aead.decrypt(ciphertext, Cryptor.EMPTY_AAD)
   }
 }
@@ -251,6 +300,8 @@ export class FieldEncryptionExecutorTransform implements FieldTransform {
   private cryptor: Cryptor
   private kekName: string
   private kek: Kek | null = null
+  // DEKs by version, a transform is created for every message
+  private deks = new Map<number, Promise<Dek>>()
   private dekExpiryDays: number
 
   constructor(
@@ -276,6 +327,18 @@ export class FieldEncryptionExecutorTransform implements FieldTransform {
     return this.kek
   }
 
+  // getDek returns the DEK of the given version, looking it up once for all
+  // the fields of the message
+  getDek(ctx: RuleContext, version: number | null): Promise<Dek> {
+    const key = version ?? 0
+    let dek = this.deks.get(key)
+    if (dek == null) {
+      dek = this.getOrCreateDek(ctx, version)
+      this.deks.set(key, dek)
+    }
+    return dek
+  }
+
   async getOrCreateKek(ctx: RuleContext): Promise<Kek> {
     const isRead = ctx.ruleMode === RuleMode.READ
     const kmsType = ctx.getParameter(ENCRYPT_KMS_TYPE)
@@ -284,7 +347,8 @@ export class FieldEncryptionExecutorTransform implements FieldTransform {
       name: this.kekName,
       deleted: false,
     }
-    let kek = await this.retrieveKekFromRegistry(kekId)
+    const keks = this.executor.getKeyCaches().keks
+    let kek = await keks.get(this.kekName, () => this.retrieveKekFromRegistry(kekId))
     if (kek == null) {
       if (isRead) {
         throw new RuleError(`no kek found for ${this.kekName} during consume`)
@@ -303,6 +367,7 @@ export class FieldEncryptionExecutorTransform implements FieldTransform {
       if (kek == null) {
         throw new RuleError(`no kek found for ${this.kekName} during produce`)
       }
+      keks.set(this.kekName, kek)
     }
     if (kmsType != null && kmsType.length !== 0 && kmsType !== kek.kmsType) {
       throw new RuleError(
@@ -317,9 +382,11 @@ export class FieldEncryptionExecutorTransform implements FieldTransform {
     return kek
   }
 
+  // retrieveKekFromRegistry skips the cache of the DEK registry client, since
+  // the key cache decides when to go to the registry
   async retrieveKekFromRegistry(key: KekId): Promise<Kek | null> {
     try {
-      return await this.executor.client!.getKek(key.name, key.deleted)
+      return await this.executor.client!.getKek(key.name, key.deleted, true)
     } catch (err) {
       if (err instanceof RestError && err.status === 404) {
         return null
@@ -352,10 +419,15 @@ export class FieldEncryptionExecutorTransform implements FieldTransform {
       algorithm: this.cryptor.dekFormat,
       deleted: isRead
     }
-    let dek = await this.retrieveDekFromRegistry(dekId)
+    const deks = this.executor.getKeyCaches().deks
+    const dekKey = dekCacheKey(dekId)
+    let dek = await deks.get(dekKey, async () => {
+      const dek = await this.retrieveDekFromRegistry(dekId)
+      return dek != null ? await this.unwrapDek(dek, kek, null) : null
+    })
     const isExpired = this.isExpired(ctx, dek)
-    let kmsClient: KmsClient | null = null
     if (dek == null || isExpired) {
+      let kmsClient: KmsClient | null = null
       if (isRead) {
         throw new RuleError(`no dek found for ${this.kekName} during consume`)
       }
@@ -383,8 +455,15 @@ export class FieldEncryptionExecutorTransform implements FieldTransform {
       if (dek == null) {
         throw new RuleError(`no dek found for ${this.kekName} during produce`)
       }
+      dek = await this.unwrapDek(dek, kek, kmsClient)
+      deks.set(dekKey, dek)
     }
 
+    return dek
+  }
+
+  // unwrapDek decrypts the key material of the DEK with the KMS, if needed
+  async unwrapDek(dek: Dek, kek: Kek, kmsClient: KmsClient | null): Promise<Dek> {
     if (DekRegistryClient.getKeyMaterialBytes(dek) == null) {
       if (kmsClient == null) {
         kmsClient = getKmsClient(this.executor.config!, kek)
@@ -392,10 +471,11 @@ export class FieldEncryptionExecutorTransform implements FieldTransform {
       const rawDek = await kmsClient.decrypt(DekRegistryClient.getEncryptedKeyMaterialBytes(dek)!)
       DekRegistryClient.setKeyMaterial(dek, rawDek)
     }
-
     return dek
   }
 
+  // retrieveDekFromRegistry skips the cache of the DEK registry client, so that
+  // refreshes get the DEK from the registry and unwrap it with the KMS again
   async retrieveDekFromRegistry(key: DekId): Promise<Dek | null> {
     try {
         let dek: Dek
@@ -403,7 +483,7 @@ export class FieldEncryptionExecutorTransform implements FieldTransform {
         if (version == null || version === 0) {
           version = 1
         }
-        dek = await this.executor.client!.getDek(key.kekName, key.subject, key.algorithm, version, key.deleted)
+        dek = await this.executor.client!.getDek(key.kekName, key.subject, key.algorithm, version, key.deleted, true)
         return dek != null && dek.encryptedKeyMaterial != null ? dek : null
       } catch (err) {
         if (err instanceof RestError && err.status === 404) {
@@ -456,7 +536,7 @@ export class FieldEncryptionExecutorTransform implements FieldTransform {
         if (this.isDekRotated()) {
           version = -1
         }
-        let dek = await this.getOrCreateDek(ctx, version)
+        let dek = await this.getDek(ctx, version)
         let keyMaterialBytes = DekRegistryClient.getKeyMaterialBytes(dek)!
         let ciphertext = await this.cryptor.encrypt(keyMaterialBytes, plaintext)
         if (this.isDekRotated()) {
@@ -486,7 +566,7 @@ export class FieldEncryptionExecutorTransform implements FieldTransform {
           }
           ciphertext = ciphertext.subarray(5)
         }
-        let dek = await this.getOrCreateDek(ctx, version)
+        let dek = await this.getDek(ctx, version)
         let keyMaterialBytes = DekRegistryClient.getKeyMaterialBytes(dek)!
         let plaintext = await this.cryptor.decrypt(keyMaterialBytes, ciphertext)
         return this.toObject(fieldCtx.type, plaintext)
@@ -537,6 +617,31 @@ export class FieldEncryptionExecutorTransform implements FieldTransform {
   }
 }
 
+// Primitives by DEK key material, which DekRegistryClient keeps per DEK
+const aeadCache = new WeakMap<Buffer, { dekFormat: DekFormat, aead: Promise<Aead> }>()
+
+type AeadFromRawKey = (key: Uint8Array) => Promise<Aead>
+
+// Primitives by raw key, for the Cryptor methods taking one
+const rawKeyAeadCache = new WeakMap<Uint8Array, { fromRawKey: AeadFromRawKey, aead: Promise<Aead> }>()
+
+function getRawKeyAead(key: Uint8Array, fromRawKey: AeadFromRawKey): Promise<Aead> {
+  let entry = rawKeyAeadCache.get(key)
+  if (entry == null || entry.fromRawKey !== fromRawKey) {
+    entry = { fromRawKey, aead: fromRawKey(key) }
+    rawKeyAeadCache.set(key, entry)
+  }
+  return entry.aead
+}
+
+function dekCacheKey(key: DekId): string {
+  return `${key.kekName}:${key.subject}:${key.version}:${key.algorithm}:${key.deleted}`
+}
+
+function toBuffer(bytes: Uint8Array): Buffer {
+  return Buffer.isBuffer(bytes) ? bytes : Buffer.from(bytes)
+}
+
 function getKmsClient(config: Map<string, string>, kek: Kek): KmsClient {
   let keyUrl = kek.kmsType + '://' + kek.kmsKeyId
   let kmsClient = Registry.getKmsClient(keyUrl)
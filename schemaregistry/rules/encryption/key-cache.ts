@@ -0,0 +1,109 @@
+import { LRUCache } from 'lru-cache'
+
+/**
+ * KeyCacheClock returns the current time in milliseconds.
+ */
+export interface KeyCacheClock {
+  now(): number
+}
+
+interface KeyCacheEntry<T> {
+  value: T | null
+  loadedAt: number
+  // the load in flight, if any
+  loading: Promise<T | null> | null
+}
+
+/**
+ * KeyCache caches KEKs and DEKs, with the KMS unwrap already done, for the
+ * encryption executor so that the message path does not wait on the DEK
+ * registry or the KMS:
+ *
+ * - Concurrent misses of the same key share one load.
+ * - A value is refreshed in the background once it is older than `ttlMs`
+ *   minus `refreshAheadMs`, and is still returned until the refresh is done,
+ *   for up to twice `ttlMs`.
+ * - Keys that were not found are cached as null for `negativeTtlMs`.
+ * - Failed loads are not cached, a failed refresh keeps the previous value.
+ * - At most `capacity` keys are kept, the least recently used are evicted.
+ */
+export class KeyCache<T> {
+  private entries: LRUCache<string, KeyCacheEntry<T>>
+
+  constructor(private clock: KeyCacheClock, private ttlMs: number,
+              private refreshAheadMs: number, private negativeTtlMs: number,
+              capacity: number = 1000) {
+    this.entries = new LRUCache({ max: capacity })
+  }
+
+  /**
+   * Returns the value of the key, loading it on a miss.
+   * @param key - the key
+   * @param load - loads the value, resolves to null if it does not exist
+   */
+  async get(key: string, load: () => Promise<T | null>): Promise<T | null> {
+    const entry = this.entries.get(key)
+    if (entry == null) {
+      return await this.load(key, load)
+    }
+    if (entry.loadedAt < 0) {
+      // first load still in flight
+      return await entry.loading!
+    }
+    const age = this.clock.now() - entry.loadedAt
+    if (entry.value == null) {
+      if (age < this.negativeTtlMs) {
+        return null
+      }
+    } else if (age < this.ttlMs - this.refreshAheadMs) {
+      return entry.value
+    }
+    const refresh = entry.loading ?? this.refresh(key, entry, load)
+    if (entry.value != null && age < 2 * this.ttlMs) {
+      return entry.value
+    }
+    return await refresh
+  }
+
+  /**
+   * Sets the value of the key, such as a newly created DEK.
+   */
+  set(key: string, value: T): void {
+    this.entries.set(key, { value, loadedAt: this.clock.now(), loading: null })
+  }
+
+  clear(): void {
+    this.entries.clear()
+  }
+
+  private async load(key: string, load: () => Promise<T | null>): Promise<T | null> {
+    const loading = load()
+    const entry: KeyCacheEntry<T> = { value: null, loadedAt: -1, loading }
+    this.entries.set(key, entry)
+    try {
+      const value = await loading
+      if (this.entries.get(key) === entry) {
+        this.entries.set(key, { value, loadedAt: this.clock.now(), loading: null })
+      }
+      return value
+    } catch (err) {
+      if (this.entries.get(key) === entry) {
+        this.entries.delete(key)
+      }
+      throw err
+    }
+  }
+
+  private refresh(key: string, entry: KeyCacheEntry<T>, load: () => Promise<T | null>): Promise<T | null> {
+    const loading = load()
+    entry.loading = loading
+    loading.then(value => {
+      if (this.entries.get(key) === entry) {
+        this.entries.set(key, { value, loadedAt: this.clock.now(), loading: null })
+      }
+    }, () => {
+      entry.loading = null
+    })
+    return loading
+  }
+}
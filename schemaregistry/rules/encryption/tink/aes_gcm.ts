@@ -6,7 +6,6 @@
 import {Aead} from './aead';
 import {SecurityException} from './exception/security_exception';
 
-import * as Bytes from './bytes';
 import * as Random from './random';
 import * as Validators from './validators';
 import * as crypto from 'crypto';
@@ -26,59 +25,72 @@ const TAG_SIZE_IN_BITS: number = 128;
 /**
  * Implementation of AES-GCM.
  *
+ * Uses the native ciphers of Node's crypto module with a key object created
+ * once, so that encrypting a value does not import the key again.
  */
 export class AesGcm extends Aead {
-  constructor(private readonly key: CryptoKey) {
+  private readonly algorithm: crypto.CipherGCMTypes;
+
+  constructor(private readonly key: crypto.KeyObject) {
     super();
+    this.algorithm = `aes-${key.symmetricKeySize! * 8}-gcm` as crypto.CipherGCMTypes;
   }
 
   /**
    */
   async encrypt(plaintext: Uint8Array, associatedData?: Uint8Array):
       Promise<Uint8Array> {
+    return this.encryptSync(plaintext, associatedData);
+  }
+
+  /**
+   * Encrypts without awaiting, the native cipher is synchronous.
+   */
+  encryptSync(plaintext: Uint8Array, associatedData?: Uint8Array): Uint8Array {
     Validators.requireUint8Array(plaintext);
     if (associatedData != null) {
       Validators.requireUint8Array(associatedData);
     }
     const iv = Random.randBytes(IV_SIZE_IN_BYTES);
-    const alg: AesGcmParams = {
-      'name': 'AES-GCM',
-      'iv': iv,
-      'tagLength': TAG_SIZE_IN_BITS
-    };
+    const cipher = crypto.createCipheriv(this.algorithm, this.key, iv, {
+      authTagLength: TAG_SIZE_IN_BITS / 8
+    });
     if (associatedData) {
-      alg['additionalData'] = associatedData;
+      cipher.setAAD(associatedData);
     }
-    const ciphertext =
-        await crypto.subtle.encrypt(alg, this.key, plaintext);
-    return Bytes.concat(iv, new Uint8Array(ciphertext));
+    return Buffer.concat([iv, cipher.update(plaintext), cipher.final(), cipher.getAuthTag()]);
   }
 
   /**
    */
   async decrypt(ciphertext: Uint8Array, associatedData?: Uint8Array):
       Promise<Uint8Array> {
+    return this.decryptSync(ciphertext, associatedData);
+  }
+
+  /**
+   * Decrypts without awaiting, the native cipher is synchronous.
+   */
+  decryptSync(ciphertext: Uint8Array, associatedData?: Uint8Array): Uint8Array {
     Validators.requireUint8Array(ciphertext);
-    if (ciphertext.length < IV_SIZE_IN_BYTES + TAG_SIZE_IN_BITS / 8) {
+    const tagSize = TAG_SIZE_IN_BITS / 8;
+    if (ciphertext.length < IV_SIZE_IN_BYTES + tagSize) {
       throw new SecurityException('ciphertext too short');
     }
     if (associatedData != null) {
       Validators.requireUint8Array(associatedData);
     }
-    const iv = new Uint8Array(IV_SIZE_IN_BYTES);
-    iv.set(ciphertext.subarray(0, IV_SIZE_IN_BYTES));
-    const alg: AesGcmParams = {
-      'name': 'AES-GCM',
-      'iv': iv,
-      'tagLength': TAG_SIZE_IN_BITS
-    };
-    if (associatedData) {
-      alg['additionalData'] = associatedData;
-    }
     try {
-      return new Uint8Array(await crypto.subtle.decrypt(
-          alg, this.key,
-          new Uint8Array(ciphertext.subarray(IV_SIZE_IN_BYTES))));
+      const decipher = crypto.createDecipheriv(this.algorithm, this.key,
+          ciphertext.subarray(0, IV_SIZE_IN_BYTES), {authTagLength: tagSize});
+      if (associatedData) {
+        decipher.setAAD(associatedData);
+      }
+      decipher.setAuthTag(ciphertext.subarray(ciphertext.length - tagSize));
+      return Buffer.concat([
+        decipher.update(ciphertext.subarray(IV_SIZE_IN_BYTES, ciphertext.length - tagSize)),
+        decipher.final()
+      ]);
       // Preserving old behavior when moving to
       // https://www.typescriptlang.org/tsconfig#useUnknownInCatchVariables
       // tslint:disable-next-line:no-any
@@ -88,19 +100,8 @@ export class AesGcm extends Aead {
   }
 }
 
-export async function fromRawKey(key: Uint8Array): Promise<Aead> {
+export async function fromRawKey(key: Uint8Array): Promise<AesGcm> {
   Validators.requireUint8Array(key);
   Validators.validateAesKeySize(key.length);
-  const webCryptoKey = await crypto.subtle.importKey(
-      /* format */
-      'raw', key,
-      /* keyData */
-      {'name': 'AES-GCM', 'length': key.length},
-      /* algo */
-      false,
-      /* extractable*/
-      ['encrypt', 'decrypt']);
-
-  /* usage */
-  return new AesGcm(webCryptoKey);
+  return new AesGcm(crypto.createSecretKey(key));
 }
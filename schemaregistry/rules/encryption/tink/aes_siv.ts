@@ -12,26 +12,39 @@ import * as crypto from 'crypto';
 /**
  * Implementation of AES-SIV.
  *
+ * The key is imported once. Operations on it are run one at a time, since
+ * the imported key keeps the state of its MAC between awaits.
  */
 export class AesSiv extends Aead {
+  private sivKey: Promise<any> | null = null;
+  private pending: Promise<unknown> = Promise.resolve();
+
   constructor(private readonly key: Uint8Array) {
     super();
   }
 
+  private run<T>(op: (key: any) => Promise<T>): Promise<T> {
+    if (this.sivKey == null) {
+      this.sivKey = SIV.importKey(this.key, "AES-CMAC-SIV", new WebCryptoProvider(crypto));
+    }
+    const sivKey = this.sivKey;
+    const result = this.pending.then(async () => op(await sivKey));
+    this.pending = result.catch(() => {});
+    return result;
+  }
+
   /**
    */
   async encrypt(plaintext: Uint8Array, associatedData?: Uint8Array):
       Promise<Uint8Array> {
-    let key = await SIV.importKey(this.key, "AES-CMAC-SIV", new WebCryptoProvider(crypto));
-    return key.seal(plaintext, [associatedData]);
+    return this.run(key => key.seal(plaintext, [associatedData]));
   }
 
   /**
    */
   async decrypt(ciphertext: Uint8Array, associatedData?: Uint8Array):
       Promise<Uint8Array> {
-    let key = await SIV.importKey(this.key, "AES-CMAC-SIV", new WebCryptoProvider(crypto));
-    return key.open(ciphertext, [associatedData]);
+    return this.run(key => key.open(ciphertext, [associatedData]));
   }
 }
 
@@ -1,9 +1,9 @@
-import { RestService, ClientConfig } from './rest-service';
+import { RestService, ClientConfig, EndpointMetrics } from './rest-service';
 import { AxiosResponse } from 'axios';
 import stringify from "json-stringify-deterministic";
 import { LRUCache } from 'lru-cache';
-import { Mutex } from 'async-mutex';
 import { MockClient } from "./mock-schemaregistry-client";
+import { createHash } from 'crypto';
 
 /*
  * Confluent-Schema-Registry-TypeScript - Node.js wrapper for Confluent Schema Registry
@@ -77,6 +77,52 @@ export function minimize(info: SchemaInfo): SchemaInfo {
   }
 }
 
+interface Fingerprint {
+  schemaType?: string;
+  schema: string;
+  references?: Reference[];
+  metadata?: Metadata;
+  ruleSet?: RuleSet;
+  fingerprint: string;
+}
+
+const fingerprints = new WeakMap<SchemaInfo, Fingerprint>();
+
+/**
+ * Returns a fingerprint identifying the fields of a SchemaInfo that minimize
+ * keeps. It is cached per object, and computed again if any of those fields
+ * was assigned a different value since. Changes inside the references,
+ * metadata or rule set objects themselves are not detected, assign new ones
+ * instead.
+ * @param info - The schema to fingerprint.
+ */
+export function schemaFingerprint(info: SchemaInfo): string {
+  const cached = fingerprints.get(info);
+  if (cached !== undefined && cached.schema === info.schema && cached.schemaType === info.schemaType &&
+      cached.references === info.references && cached.metadata === info.metadata &&
+      cached.ruleSet === info.ruleSet) {
+    return cached.fingerprint;
+  }
+  const hash = createHash('sha256');
+  hash.update(info.schemaType ?? '');
+  hash.update('\0');
+  hash.update(info.schema);
+  if (info.references != null || info.metadata != null || info.ruleSet != null) {
+    hash.update('\0');
+    hash.update(stringify({ references: info.references, metadata: info.metadata, ruleSet: info.ruleSet }));
+  }
+  const fingerprint = hash.digest('base64');
+  fingerprints.set(info, {
+    schemaType: info.schemaType,
+    schema: info.schema,
+    references: info.references,
+    metadata: info.metadata,
+    ruleSet: info.ruleSet,
+    fingerprint,
+  });
+  return fingerprint;
+}
+
 /**
  * SchemaMetadata extends SchemaInfo with additional metadata
  */
@@ -166,6 +212,71 @@ export interface Client {
   close(): void;
 }
 
+/**
+ * PendingRequests holds the in-flight requests for the entries of a cache.
+ * Concurrent lookups of the same key share one request, whose result is
+ * cached unless the cache was invalidated while it was in flight.
+ */
+class PendingRequests<T extends {}> {
+  private requests = new Map<string, Promise<T>>();
+  // bumped by invalidate, so that requests started before do not cache their result
+  private generation = 0;
+
+  constructor(private cache: LRUCache<string, T>) {
+  }
+
+  /**
+   * Fetches the value of a key that is not cached, and caches it.
+   * @param cacheKey - the key
+   * @param request - fetches the value
+   */
+  async get(cacheKey: string, request: () => Promise<T>): Promise<T> {
+    let pending = this.requests.get(cacheKey);
+    if (pending === undefined) {
+      const generation = this.generation;
+      const fetched: Promise<T> = request().then(value => {
+        if (this.generation === generation) {
+          this.cache.set(cacheKey, value);
+        }
+        return value;
+      }).finally(() => {
+        if (this.requests.get(cacheKey) === fetched) {
+          this.requests.delete(cacheKey);
+        }
+      });
+      this.requests.set(cacheKey, fetched);
+      pending = fetched;
+    }
+    return await pending;
+  }
+
+  /**
+   * Stops the requests in flight from caching their results, and makes later
+   * lookups of the matching keys start new requests.
+   * @param matches - selects the keys, all keys if omitted
+   */
+  invalidate(matches?: (cacheKey: string) => boolean): void {
+    this.generation++;
+    if (matches === undefined) {
+      this.requests.clear();
+      return;
+    }
+    for (const cacheKey of Array.from(this.requests.keys())) {
+      if (matches(cacheKey)) {
+        this.requests.delete(cacheKey);
+      }
+    }
+  }
+}
+
+function deleteMatching<T extends {}>(cache: LRUCache<string, T>, matches: (cacheKey: string) => boolean): void {
+  for (const cacheKey of Array.from(cache.keys())) {
+    if (matches(cacheKey)) {
+      cache.delete(cacheKey);
+    }
+  }
+}
+
 /**
  * SchemaRegistryClient is a client for interacting with the Confluent Schema Registry.
  * This client will cache responses from Schema Registry to reduce network requests.
@@ -182,13 +293,13 @@ export class SchemaRegistryClient implements Client {
   private versionToSchemaCache: LRUCache<string, SchemaMetadata>;
   private metadataToSchemaCache: LRUCache<string, SchemaMetadata>;
 
-  private schemaToIdMutex: Mutex;
-  private idToSchemaInfoMutex: Mutex;
-  private infoToSchemaMutex: Mutex;
-  private latestToSchemaMutex: Mutex;
-  private schemaToVersionMutex: Mutex;
-  private versionToSchemaMutex: Mutex;
-  private metadataToSchemaMutex: Mutex;
+  private schemaToIdRequests: PendingRequests<number>;
+  private idToSchemaInfoRequests: PendingRequests<SchemaInfo>;
+  private infoToSchemaRequests: PendingRequests<SchemaMetadata>;
+  private latestToSchemaRequests: PendingRequests<SchemaMetadata>;
+  private schemaToVersionRequests: PendingRequests<number>;
+  private versionToSchemaRequests: PendingRequests<SchemaMetadata>;
+  private metadataToSchemaRequests: PendingRequests<SchemaMetadata>;
 
   /**
    * Create a new Schema Registry client.
@@ -203,7 +314,8 @@ export class SchemaRegistryClient implements Client {
 
     this.restService = new RestService(config.baseURLs, config.isForward, config.createAxiosDefaults,
       config.basicAuthCredentials, config.bearerAuthCredentials,
-      config.maxRetries, config.retriesWaitMs, config.retriesMaxWaitMs);
+      config.maxRetries, config.retriesWaitMs, config.retriesMaxWaitMs,
+      config.maxConnections, config.maxConcurrentRequests);
 
     this.schemaToIdCache = new LRUCache(cacheOptions);
     this.idToSchemaInfoCache = new LRUCache(cacheOptions);
@@ -212,13 +324,13 @@ export class SchemaRegistryClient implements Client {
     this.schemaToVersionCache = new LRUCache(cacheOptions);
     this.versionToSchemaCache = new LRUCache(cacheOptions);
     this.metadataToSchemaCache = new LRUCache(cacheOptions);
-    this.schemaToIdMutex = new Mutex();
-    this.idToSchemaInfoMutex = new Mutex();
-    this.infoToSchemaMutex = new Mutex();
-    this.latestToSchemaMutex = new Mutex();
-    this.schemaToVersionMutex = new Mutex();
-    this.versionToSchemaMutex = new Mutex();
-    this.metadataToSchemaMutex = new Mutex();
+    this.schemaToIdRequests = new PendingRequests(this.schemaToIdCache);
+    this.idToSchemaInfoRequests = new PendingRequests(this.idToSchemaInfoCache);
+    this.infoToSchemaRequests = new PendingRequests(this.infoToSchemaCache);
+    this.latestToSchemaRequests = new PendingRequests(this.latestToSchemaCache);
+    this.schemaToVersionRequests = new PendingRequests(this.schemaToVersionCache);
+    this.versionToSchemaRequests = new PendingRequests(this.versionToSchemaCache);
+    this.metadataToSchemaRequests = new PendingRequests(this.metadataToSchemaCache);
   }
 
   static newClient(config: ClientConfig): Client {
@@ -252,14 +364,14 @@ export class SchemaRegistryClient implements Client {
    * @param normalize - Whether to normalize the schema before registering.
    */
   async registerFullResponse(subject: string, schema: SchemaInfo, normalize: boolean = false): Promise<SchemaMetadata> {
-    const cacheKey = stringify({ subject, schema: minimize(schema) });
+    const cacheKey = stringify({ subject, schema: schemaFingerprint(schema) });
 
-    return await this.infoToSchemaMutex.runExclusive(async () => {
-      const cachedSchemaMetadata: SchemaMetadata | undefined = this.infoToSchemaCache.get(cacheKey);
-      if (cachedSchemaMetadata) {
-        return cachedSchemaMetadata;
-      }
+    const cachedSchemaMetadata: SchemaMetadata | undefined = this.infoToSchemaCache.get(cacheKey);
+    if (cachedSchemaMetadata) {
+      return cachedSchemaMetadata;
+    }
 
+    return await this.infoToSchemaRequests.get(cacheKey, async () => {
       subject = encodeURIComponent(subject);
 
       const response: AxiosResponse<SchemaMetadata> = await this.restService.handleRequest(
@@ -267,7 +379,6 @@ export class SchemaRegistryClient implements Client {
         'POST',
         schema
       );
-      this.infoToSchemaCache.set(cacheKey, response.data);
       return response.data;
     });
   }
@@ -280,12 +391,12 @@ export class SchemaRegistryClient implements Client {
    */
   async getBySubjectAndId(subject: string, id: number, format?: string): Promise<SchemaInfo> {
     const cacheKey = stringify({ subject, id });
-    return await this.idToSchemaInfoMutex.runExclusive(async () => {
-      const cachedSchema: SchemaInfo | undefined = this.idToSchemaInfoCache.get(cacheKey);
-      if (cachedSchema) {
-        return cachedSchema;
-      }
+    const cachedSchema: SchemaInfo | undefined = this.idToSchemaInfoCache.get(cacheKey);
+    if (cachedSchema) {
+      return cachedSchema;
+    }
 
+    return await this.idToSchemaInfoRequests.get(cacheKey, async () => {
       subject = encodeURIComponent(subject);
 
       let formatStr = format != null ? `&format=${format}` : '';
@@ -294,7 +405,6 @@ export class SchemaRegistryClient implements Client {
         `/schemas/ids/${id}?subject=${subject}${formatStr}`,
         'GET'
       );
-      this.idToSchemaInfoCache.set(cacheKey, response.data);
       return response.data;
     });
   }
@@ -306,14 +416,14 @@ export class SchemaRegistryClient implements Client {
    * @param normalize - Whether to normalize the schema before getting the ID.
    */
   async getId(subject: string, schema: SchemaInfo, normalize: boolean = false): Promise<number> {
-    const cacheKey = stringify({ subject, schema: minimize(schema) });
+    const cacheKey = stringify({ subject, schema: schemaFingerprint(schema) });
 
-    return await this.schemaToIdMutex.runExclusive(async () => {
-      const cachedId: number | undefined = this.schemaToIdCache.get(cacheKey);
-      if (cachedId) {
-        return cachedId;
-      }
+    const cachedId: number | undefined = this.schemaToIdCache.get(cacheKey);
+    if (cachedId) {
+      return cachedId;
+    }
 
+    return await this.schemaToIdRequests.get(cacheKey, async () => {
       subject = encodeURIComponent(subject);
 
       const response: AxiosResponse<SchemaMetadata> = await this.restService.handleRequest(
@@ -321,7 +431,6 @@ export class SchemaRegistryClient implements Client {
         'POST',
         schema
       );
-      this.schemaToIdCache.set(cacheKey, response.data.id);
       return response.data.id;
     });
   }
@@ -332,12 +441,12 @@ export class SchemaRegistryClient implements Client {
    * @param format - The format of the schema.
    */
   async getLatestSchemaMetadata(subject: string, format?: string): Promise<SchemaMetadata> {
-    return await this.latestToSchemaMutex.runExclusive(async () => {
-      const cachedSchema: SchemaMetadata | undefined = this.latestToSchemaCache.get(subject);
-      if (cachedSchema) {
-        return cachedSchema;
-      }
+    const cachedSchema: SchemaMetadata | undefined = this.latestToSchemaCache.get(subject);
+    if (cachedSchema) {
+      return cachedSchema;
+    }
 
+    return await this.latestToSchemaRequests.get(subject, async () => {
       subject = encodeURIComponent(subject);
 
       let formatStr = format != null ? `?format=${format}` : '';
@@ -346,7 +455,6 @@ export class SchemaRegistryClient implements Client {
         `/subjects/${subject}/versions/latest${formatStr}`,
         'GET'
       );
-      this.latestToSchemaCache.set(subject, response.data);
       return response.data;
     });
   }
@@ -361,12 +469,12 @@ export class SchemaRegistryClient implements Client {
   async getSchemaMetadata(subject: string, version: number, deleted: boolean = false, format?: string): Promise<SchemaMetadata> {
     const cacheKey = stringify({ subject, version, deleted });
 
-    return await this.versionToSchemaMutex.runExclusive(async () => {
-      const cachedSchemaMetadata: SchemaMetadata | undefined = this.versionToSchemaCache.get(cacheKey);
-      if (cachedSchemaMetadata) {
-        return cachedSchemaMetadata;
-      }
+    const cachedSchemaMetadata: SchemaMetadata | undefined = this.versionToSchemaCache.get(cacheKey);
+    if (cachedSchemaMetadata) {
+      return cachedSchemaMetadata;
+    }
 
+    return await this.versionToSchemaRequests.get(cacheKey, async () => {
       subject = encodeURIComponent(subject);
 
       let formatStr = format != null ? `&format=${format}` : '';
@@ -375,7 +483,6 @@ export class SchemaRegistryClient implements Client {
         `/subjects/${subject}/versions/${version}?deleted=${deleted}${formatStr}`,
         'GET'
       );
-      this.versionToSchemaCache.set(cacheKey, response.data);
       return response.data;
     });
   }
@@ -391,12 +498,12 @@ export class SchemaRegistryClient implements Client {
                               deleted: boolean = false, format?: string): Promise<SchemaMetadata> {
     const cacheKey = stringify({ subject, metadata, deleted });
 
-    return await this.metadataToSchemaMutex.runExclusive(async () => {
-      const cachedSchemaMetadata: SchemaMetadata | undefined = this.metadataToSchemaCache.get(cacheKey);
-      if (cachedSchemaMetadata) {
-        return cachedSchemaMetadata;
-      }
+    const cachedSchemaMetadata: SchemaMetadata | undefined = this.metadataToSchemaCache.get(cacheKey);
+    if (cachedSchemaMetadata) {
+      return cachedSchemaMetadata;
+    }
 
+    return await this.metadataToSchemaRequests.get(cacheKey, async () => {
       subject = encodeURIComponent(subject);
 
       let metadataStr = '';
@@ -413,7 +520,6 @@ export class SchemaRegistryClient implements Client {
         `/subjects/${subject}/metadata?deleted=${deleted}&${metadataStr}${formatStr}`,
         'GET'
       );
-      this.metadataToSchemaCache.set(cacheKey, response.data);
       return response.data;
     });
   }
@@ -438,14 +544,14 @@ export class SchemaRegistryClient implements Client {
    */
   async getVersion(subject: string, schema: SchemaInfo,
                    normalize: boolean = false, deleted: boolean = false): Promise<number> {
-    const cacheKey = stringify({ subject, schema: minimize(schema), deleted });
+    const cacheKey = stringify({ subject, schema: schemaFingerprint(schema), deleted });
 
-    return await this.schemaToVersionMutex.runExclusive(async () => {
-      const cachedVersion: number | undefined = this.schemaToVersionCache.get(cacheKey);
-      if (cachedVersion) {
-        return cachedVersion;
-      }
+    const cachedVersion: number | undefined = this.schemaToVersionCache.get(cacheKey);
+    if (cachedVersion) {
+      return cachedVersion;
+    }
 
+    return await this.schemaToVersionRequests.get(cacheKey, async () => {
       subject = encodeURIComponent(subject);
 
       const response: AxiosResponse<SchemaMetadata> = await this.restService.handleRequest(
@@ -453,7 +559,6 @@ export class SchemaRegistryClient implements Client {
         'POST',
         schema
       );
-      this.schemaToVersionCache.set(cacheKey, response.data.version);
       return response.data.version!;
     });
   }
@@ -475,41 +580,15 @@ export class SchemaRegistryClient implements Client {
    * @param permanent - Whether to permanently delete the subject.
    */
   async deleteSubject(subject: string, permanent: boolean = false): Promise<number[]> {
-    await this.infoToSchemaMutex.runExclusive(async () => {
-      this.infoToSchemaCache.forEach((_, key) => {
-        const parsedKey = JSON.parse(key);
-        if (parsedKey.subject === subject) {
-          this.infoToSchemaCache.delete(key);
-        }
-      });
-    });
-
-    await this.schemaToVersionMutex.runExclusive(async () => {
-      this.schemaToVersionCache.forEach((_, key) => {
-        const parsedKey = JSON.parse(key);
-        if (parsedKey.subject === subject) {
-          this.schemaToVersionCache.delete(key);
-        }
-      });
-    });
-
-    await this.versionToSchemaMutex.runExclusive(async () => {
-      this.versionToSchemaCache.forEach((_, key) => {
-        const parsedKey = JSON.parse(key);
-        if (parsedKey.subject === subject) {
-          this.versionToSchemaCache.delete(key);
-        }
-      });
-    });
-
-    await this.idToSchemaInfoMutex.runExclusive(async () => {
-      this.idToSchemaInfoCache.forEach((_, key) => {
-        const parsedKey = JSON.parse(key);
-        if (parsedKey.subject === subject) {
-          this.idToSchemaInfoCache.delete(key);
-        }
-      });
-    });
+    const ofSubject = (key: string) => JSON.parse(key).subject === subject;
+    deleteMatching(this.infoToSchemaCache, ofSubject);
+    deleteMatching(this.schemaToVersionCache, ofSubject);
+    deleteMatching(this.versionToSchemaCache, ofSubject);
+    deleteMatching(this.idToSchemaInfoCache, ofSubject);
+    this.infoToSchemaRequests.invalidate(ofSubject);
+    this.schemaToVersionRequests.invalidate(ofSubject);
+    this.versionToSchemaRequests.invalidate(ofSubject);
+    this.idToSchemaInfoRequests.invalidate(ofSubject);
 
     subject = encodeURIComponent(subject);
 
@@ -527,42 +606,39 @@ export class SchemaRegistryClient implements Client {
    * @param permanent - Whether to permanently delete the version.
    */
   async deleteSubjectVersion(subject: string, version: number, permanent: boolean = false): Promise<number> {
-    return await this.schemaToVersionMutex.runExclusive(async () => {
-      let metadataValue: SchemaMetadata | undefined;
-
-      this.schemaToVersionCache.forEach((value, key) => {
-        const parsedKey = JSON.parse(key);
-        if (parsedKey.subject === subject && value === version) {
-          this.schemaToVersionCache.delete(key);
-          const infoToSchemaCacheKey = stringify({ subject: subject, schema: minimize(parsedKey.schema) });
-
-          this.infoToSchemaMutex.runExclusive(async () => {
-            metadataValue = this.infoToSchemaCache.get(infoToSchemaCacheKey);
-            if (metadataValue) {
-              this.infoToSchemaCache.delete(infoToSchemaCacheKey);
-              const cacheKeyID = stringify({ subject: subject, id: metadataValue.id });
-
-              this.idToSchemaInfoMutex.runExclusive(async () => {
-                this.idToSchemaInfoCache.delete(cacheKeyID);
-              });
-            }
-          });
+    this.schemaToVersionCache.forEach((value, key) => {
+      const parsedKey = JSON.parse(key);
+      if (parsedKey.subject === subject && value === version) {
+        this.schemaToVersionCache.delete(key);
+        const infoToSchemaCacheKey = stringify({ subject: subject, schema: parsedKey.schema });
+
+        const metadataValue = this.infoToSchemaCache.get(infoToSchemaCacheKey);
+        if (metadataValue) {
+          this.infoToSchemaCache.delete(infoToSchemaCacheKey);
+          this.idToSchemaInfoCache.delete(stringify({ subject: subject, id: metadataValue.id }));
         }
-      });
+      }
+    });
+    deleteMatching(this.versionToSchemaCache, key => {
+      const parsedKey = JSON.parse(key);
+      return parsedKey.subject === subject && parsedKey.version === version;
+    });
 
-      const cacheKey = stringify({ subject: subject, version: version });
-      this.versionToSchemaMutex.runExclusive(async () => {
-        this.versionToSchemaCache.delete(cacheKey);
-      });
+    // The version of what is being fetched is not known yet, so drop every
+    // request of the subject.
+    const ofSubject = (key: string) => JSON.parse(key).subject === subject;
+    this.infoToSchemaRequests.invalidate(ofSubject);
+    this.schemaToVersionRequests.invalidate(ofSubject);
+    this.versionToSchemaRequests.invalidate(ofSubject);
+    this.idToSchemaInfoRequests.invalidate(ofSubject);
 
-      subject = encodeURIComponent(subject);
+    subject = encodeURIComponent(subject);
 
-      const response: AxiosResponse<number> = await this.restService.handleRequest(
-        `/subjects/${subject}/versions/${version}?permanent=${permanent}`,
-        'DELETE'
-      );
-      return response.data;
-    });
+    const response: AxiosResponse<number> = await this.restService.handleRequest(
+      `/subjects/${subject}/versions/${version}?permanent=${permanent}`,
+      'DELETE'
+    );
+    return response.data;
   }
 
   /**
@@ -710,6 +786,8 @@ export class SchemaRegistryClient implements Client {
   clearLatestCaches(): void {
     this.latestToSchemaCache.clear();
     this.metadataToSchemaCache.clear();
+    this.latestToSchemaRequests.invalidate();
+    this.metadataToSchemaRequests.invalidate();
   }
 
   /**
@@ -723,6 +801,13 @@ export class SchemaRegistryClient implements Client {
     this.schemaToVersionCache.clear();
     this.versionToSchemaCache.clear();
     this.metadataToSchemaCache.clear();
+    this.schemaToIdRequests.invalidate();
+    this.idToSchemaInfoRequests.invalidate();
+    this.infoToSchemaRequests.invalidate();
+    this.latestToSchemaRequests.invalidate();
+    this.schemaToVersionRequests.invalidate();
+    this.versionToSchemaRequests.invalidate();
+    this.metadataToSchemaRequests.invalidate();
   }
 
   /**
@@ -730,58 +815,50 @@ export class SchemaRegistryClient implements Client {
    */
   async close(): Promise<void> {
     this.clearCaches();
+    this.restService.close();
+  }
+
+  /**
+   * Returns the latency of the requests to Schema Registry per endpoint.
+   */
+  getRequestMetrics(): Map<string, EndpointMetrics> {
+    return this.restService.getMetrics();
   }
 
   // Cache methods for testing
   async addToInfoToSchemaCache(subject: string, schema: SchemaInfo, metadata: SchemaMetadata): Promise<void> {
-    const cacheKey = stringify({ subject, schema: minimize(schema) });
-    await this.infoToSchemaMutex.runExclusive(async () => {
-      this.infoToSchemaCache.set(cacheKey, metadata);
-    });
+    const cacheKey = stringify({ subject, schema: schemaFingerprint(schema) });
+    this.infoToSchemaCache.set(cacheKey, metadata);
   }
 
   async addToSchemaToVersionCache(subject: string, schema: SchemaInfo, version: number): Promise<void> {
-    const cacheKey = stringify({ subject, schema: minimize(schema) });
-    await this.schemaToVersionMutex.runExclusive(async () => {
-      this.schemaToVersionCache.set(cacheKey, version);
-    });
+    const cacheKey = stringify({ subject, schema: schemaFingerprint(schema) });
+    this.schemaToVersionCache.set(cacheKey, version);
   }
 
   async addToVersionToSchemaCache(subject: string, version: number, metadata: SchemaMetadata): Promise<void> {
     const cacheKey = stringify({ subject, version });
-    await this.versionToSchemaMutex.runExclusive(async () => {
-      this.versionToSchemaCache.set(cacheKey, metadata);
-    });
+    this.versionToSchemaCache.set(cacheKey, metadata);
   }
 
   async addToIdToSchemaInfoCache(subject: string, id: number, schema: SchemaInfo): Promise<void> {
     const cacheKey = stringify({ subject, id });
-    await this.idToSchemaInfoMutex.runExclusive(async () => {
-      this.idToSchemaInfoCache.set(cacheKey, schema);
-    });
+    this.idToSchemaInfoCache.set(cacheKey, schema);
   }
 
   async getInfoToSchemaCacheSize(): Promise<number> {
-    return await this.infoToSchemaMutex.runExclusive(async () => {
-      return this.infoToSchemaCache.size;
-    });
+    return this.infoToSchemaCache.size;
   }
 
   async getSchemaToVersionCacheSize(): Promise<number> {
-    return await this.schemaToVersionMutex.runExclusive(async () => {
-      return this.schemaToVersionCache.size;
-    });
+    return this.schemaToVersionCache.size;
   }
 
   async getVersionToSchemaCacheSize(): Promise<number> {
-    return await this.versionToSchemaMutex.runExclusive(async () => {
-      return this.versionToSchemaCache.size;
-    });
+    return this.versionToSchemaCache.size;
   }
 
   async getIdToSchemaInfoCacheSize(): Promise<number> {
-    return await this.idToSchemaInfoMutex.runExclusive(async () => {
-      return this.idToSchemaInfoCache.size;
-    });
+    return this.idToSchemaInfoCache.size;
   }
 }
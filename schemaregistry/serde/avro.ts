@@ -1,14 +1,15 @@
 import {
   Deserializer, DeserializerConfig,
+  FieldRulePlan,
   FieldTransform,
-  FieldType, Migration, RefResolver,
+  FieldType, HEADER_SIZE, Migration, RefResolver,
   RuleConditionError,
   RuleContext, SerdeType,
-  Serializer, SerializerConfig
+  Serializer, SerializerConfig, WireHeader
 } from "./serde";
 import {
   Client, RuleMode,
-  SchemaInfo
+  SchemaInfo, SchemaMetadata
 } from "../schemaregistry-client";
 import avro, {ForSchemaOptions, Type, types} from "avsc";
 import UnwrappedUnionType = types.UnwrappedUnionType
@@ -19,7 +20,6 @@ import RecordType = types.RecordType
 import Field = types.Field
 import { LRUCache } from 'lru-cache'
 import {RuleRegistry} from "./rule-registry";
-import stringify from "json-stringify-deterministic";
 
 type TypeHook = (schema: avro.Schema, opts: ForSchemaOptions) => Type | undefined
 
@@ -39,6 +39,8 @@ export type AvroSerializerConfig = SerializerConfig & AvroSerdeConfig
  */
 export class AvroSerializer extends Serializer implements AvroSerde {
   schemaToTypeCache: LRUCache<string, [avro.Type, Map<string, string>]>
+  // messages are encoded here before being copied behind the header
+  private scratch: Buffer = Buffer.allocUnsafe(1024)
 
   /**
    * Create a new AvroSerializer.
@@ -87,10 +89,79 @@ export class AvroSerializer extends Serializer implements AvroSerde {
     let deps: Map<string, string>
     [avroSchema, deps] = await this.toType(info)
     const subject = this.subjectName(topic, info)
-    msg = await this.executeRules(
-      subject, topic, RuleMode.WRITE, null, info, msg, getInlineTags(info, deps))
-    const msgBytes = avroSchema.toBuffer(msg)
-    return this.writeBytes(id, msgBytes)
+    if (this.hasActiveRules(RuleMode.WRITE, info)) {
+      msg = await this.executeRules(
+        subject, topic, RuleMode.WRITE, null, info, msg, getInlineTags(info, deps))
+    }
+    return this.encode(id, avroSchema, msg)
+  }
+
+  // encode writes the message into the scratch buffer, growing it if needed,
+  // and copies it once into a buffer behind the wire format header.
+  private encode(id: number, avroSchema: Type, msg: any): Buffer {
+    let size = avroSchema.encode(msg, this.scratch, 0)
+    if (size < 0) {
+      // a negative size is the number of bytes missing
+      this.scratch = Buffer.allocUnsafe(Math.max(this.scratch.length * 2, this.scratch.length - size))
+      size = avroSchema.encode(msg, this.scratch, 0)
+    }
+    const buffer = this.allocMessage(id, size)
+    this.scratch.copy(buffer, HEADER_SIZE, 0, size)
+    return buffer
+  }
+
+  /**
+   * serializeBatch is used to serialize several messages using Avro. Messages
+   * are grouped by schema, which is looked up once per group.
+   * @param topic - the topic to serialize the messages for
+   * @param msgs - the messages to serialize
+   */
+  override async serializeBatch(topic: string, msgs: any[]): Promise<Buffer[]> {
+    if (this.client == null) {
+      throw new Error('client is not initialized')
+    }
+
+    // Don't derive the schema if it is being looked up in the following ways
+    const deriveSchema = this.config().useSchemaId == null &&
+        !this.config().useLatestVersion &&
+        this.config().useLatestWithMetadata == null
+    const groups = new Map<string, number[]>()
+    for (let i = 0; i < msgs.length; i++) {
+      if (msgs[i] == null) {
+        throw new Error('message is empty')
+      }
+      const key = deriveSchema ? JSON.stringify(AvroSerializer.messageToSchema(msgs[i])) : ''
+      let indexes = groups.get(key)
+      if (indexes == null) {
+        indexes = []
+        groups.set(key, indexes)
+      }
+      indexes.push(i)
+    }
+
+    const result = new Array<Buffer>(msgs.length)
+    for (const [key, indexes] of groups) {
+      let schema: SchemaInfo | undefined = undefined
+      if (deriveSchema) {
+        schema = {
+          schemaType: 'AVRO',
+          schema: key,
+        }
+      }
+      const [id, info] = await this.getId(topic, msgs[indexes[0]], schema)
+      const [avroSchema, deps] = await this.toType(info)
+      const subject = this.subjectName(topic, info)
+      const hasRules = this.hasActiveRules(RuleMode.WRITE, info)
+      const inlineTags = hasRules ? getInlineTags(info, deps) : null
+      for (const i of indexes) {
+        let msg = msgs[i]
+        if (hasRules) {
+          msg = await this.executeRules(subject, topic, RuleMode.WRITE, null, info, msg, inlineTags)
+        }
+        result[i] = this.encode(id, avroSchema, msg)
+      }
+    }
+    return result
   }
 
   async fieldTransform(ctx: RuleContext, fieldTransform: FieldTransform, msg: any): Promise<any> {
@@ -140,11 +211,33 @@ export class AvroSerializer extends Serializer implements AvroSerde {
  */
 export type AvroDeserializerConfig = DeserializerConfig & AvroSerdeConfig
 
+/**
+ * AvroDeserializerPlan holds everything needed to deserialize messages written
+ * with one schema ID, for one subject and reader schema version.
+ */
+interface AvroDeserializerPlan {
+  info: SchemaInfo
+  subject: string
+  // the schema rules are executed against, the reader schema if there is one
+  target: SchemaInfo
+  migrations: Migration[]
+  writer: Type
+  // decodes a message into the reader schema (or the writer schema if there is none)
+  decode: (msgBytes: Buffer) => any
+  inlineTags: Map<string, Set<string>>
+  // whether the target schema has any READ rules to execute
+  hasRules: boolean
+}
+
 /**
  * AvroDeserializer is used to deserialize messages using Avro.
  */
 export class AvroDeserializer extends Deserializer implements AvroSerde {
   schemaToTypeCache: LRUCache<string, [avro.Type, Map<string, string>]>
+  // plans keyed by subject, writer schema ID and reader schema ID and version
+  private planCache: LRUCache<string, AvroDeserializerPlan>
+  // subject of the schema rules, keyed by topic and writer schema ID
+  private planSubjectCache: LRUCache<string, string>
 
   /**
    * Create a new AvroDeserializer.
@@ -156,6 +249,8 @@ export class AvroDeserializer extends Deserializer implements AvroSerde {
   constructor(client: Client, serdeType: SerdeType, conf: AvroDeserializerConfig, ruleRegistry?: RuleRegistry) {
     super(client, serdeType, conf, ruleRegistry)
     this.schemaToTypeCache = new LRUCache<string, [Type, Map<string, string>]>({ max: this.conf.cacheCapacity ?? 1000 })
+    this.planCache = new LRUCache<string, AvroDeserializerPlan>({ max: this.conf.cacheCapacity ?? 1000 })
+    this.planSubjectCache = new LRUCache<string, string>({ max: this.conf.cacheCapacity ?? 1000 })
     this.fieldTransformer = async (ctx: RuleContext, fieldTransform: FieldTransform, msg: any) => {
       return await this.fieldTransform(ctx, fieldTransform, msg)
     }
@@ -164,49 +259,125 @@ export class AvroDeserializer extends Deserializer implements AvroSerde {
     }
   }
 
-  override async deserialize(topic: string, payload: Buffer): Promise<any> {
+  override async deserialize(topic: string, payload: Buffer, header?: WireHeader): Promise<any> {
     if (!Buffer.isBuffer(payload)) {
       throw new Error('Invalid buffer')
     }
-    if (payload.length === 0) {
+    if (payload.length === 0 && header?.schemaId == null) {
       return null
     }
 
-    const info = await this.getSchema(topic, payload)
+    const [id, msgBytes] = this.splitPayload(payload, header)
+    const plan = await this.getPlan(topic, id)
+    return await this.applyPlan(plan, topic, msgBytes)
+  }
+
+  /**
+   * deserializeBatch is used to deserialize several messages using Avro.
+   * Messages are grouped by schema ID, and messages whose schema has no
+   * migrations or read rules are decoded without awaiting.
+   * @param topic - the topic of the messages
+   * @param payloads - the payloads to deserialize
+   * @param headers - the already parsed wire format headers, if any
+   */
+  override async deserializeBatch(topic: string, payloads: Buffer[], headers?: WireHeader[]): Promise<any[]> {
+    const msgs = new Array<any>(payloads.length).fill(null)
+    for (const [id, indexes] of this.groupBySchemaId(payloads, headers)) {
+      const plan = await this.getPlan(topic, id)
+      if (plan.migrations.length === 0 && !plan.hasRules) {
+        for (const i of indexes) {
+          msgs[i] = plan.decode(this.splitPayload(payloads[i], headers?.[i])[1])
+        }
+      } else {
+        for (const i of indexes) {
+          msgs[i] = await this.applyPlan(plan, topic, this.splitPayload(payloads[i], headers?.[i])[1])
+        }
+      }
+    }
+    return msgs
+  }
+
+  private async applyPlan(plan: AvroDeserializerPlan, topic: string, msgBytes: Buffer): Promise<any> {
+    let msg: any
+    if (plan.migrations.length > 0) {
+      msg = plan.writer.fromBuffer(msgBytes)
+      msg = await this.executeMigrations(plan.migrations, plan.subject, topic, msg)
+    } else {
+      msg = plan.decode(msgBytes)
+    }
+    if (!plan.hasRules) {
+      return msg
+    }
+    return await this.executeRules(
+      plan.subject, topic, RuleMode.READ, null, plan.target, msg, plan.inlineTags)
+  }
+
+  // getPlan returns the plan for the given topic and writer schema ID. Once
+  // the subject is known, only the reader schema is looked up, from the
+  // client's latest caches, so that new latest versions are picked up as
+  // soon as the client sees them.
+  private async getPlan(topic: string, id: number): Promise<AvroDeserializerPlan> {
+    const subject = this.planSubjectCache.get(`${topic}:${id}`)
+    if (subject != null) {
+      const readerMeta = this.hasReaderSchema() ? await this.getReaderSchema(subject) : null
+      const plan = this.planCache.get(planKey(subject, id, readerMeta))
+      if (plan != null) {
+        return plan
+      }
+    }
+    return await this.createPlan(topic, id)
+  }
+
+  private async createPlan(topic: string, id: number): Promise<AvroDeserializerPlan> {
+    const info = await this.getSchemaById(topic, id)
     const subject = this.subjectName(topic, info)
     const readerMeta = await this.getReaderSchema(subject)
+    const key = planKey(subject, id, readerMeta)
+
+    let plan = this.planCache.get(key)
+    if (plan == null) {
+      plan = await this.compilePlan(subject, info, readerMeta)
+      this.planCache.set(key, plan)
+    }
+    this.planSubjectCache.set(`${topic}:${id}`, subject)
+    return plan
+  }
+
+  private async compilePlan(subject: string, info: SchemaInfo,
+                            readerMeta: SchemaMetadata | null): Promise<AvroDeserializerPlan> {
     let migrations: Migration[] = []
     if (readerMeta != null) {
       migrations = await this.getMigrations(subject, info, readerMeta)
     }
     const [writer, deps] = await this.toType(info)
 
-    let msg: any
-    const msgBytes = payload.subarray(5)
-    if (migrations.length > 0) {
-      msg = writer.fromBuffer(msgBytes)
-      msg = await this.executeMigrations(migrations, subject, topic, msg)
-    } else {
-      if (readerMeta != null) {
-        const [reader, ] = await this.toType(readerMeta)
-        if (reader.equals(writer)) {
-          msg = reader.fromBuffer(msgBytes)
-        } else {
-          msg = reader.fromBuffer(msgBytes, reader.createResolver(writer))
-        }
+    let decode = (msgBytes: Buffer) => writer.fromBuffer(msgBytes)
+    if (migrations.length === 0 && readerMeta != null) {
+      const [reader, ] = await this.toType(readerMeta)
+      if (reader.equals(writer)) {
+        decode = (msgBytes: Buffer) => reader.fromBuffer(msgBytes)
       } else {
-        msg = writer.fromBuffer(msgBytes)
+        const resolver = reader.createResolver(writer)
+        decode = (msgBytes: Buffer) => reader.fromBuffer(msgBytes, resolver)
       }
     }
-    let target: SchemaInfo
-    if (readerMeta != null) {
-      target = readerMeta
-    } else {
-      target = info
+    const target = readerMeta ?? info
+    return {
+      info,
+      subject,
+      target,
+      migrations,
+      writer,
+      decode,
+      inlineTags: getInlineTags(info, deps),
+      hasRules: this.hasActiveRules(RuleMode.READ, target),
     }
-    msg = await this.executeRules(
-      subject, topic, RuleMode.READ, null, target, msg, getInlineTags(info, deps))
-    return msg
+  }
+
+  private hasReaderSchema(): boolean {
+    const useLatestWithMetadata = this.config().useLatestWithMetadata
+    return Boolean(this.config().useLatestVersion) ||
+      (useLatestWithMetadata != null && Object.keys(useLatestWithMetadata).length !== 0)
   }
 
   async fieldTransform(ctx: RuleContext, fieldTransform: FieldTransform, msg: any): Promise<any> {
@@ -230,7 +401,7 @@ async function toType(
   info: SchemaInfo,
   refResolver: RefResolver,
 ): Promise<[Type, Map<string, string>]> {
-  let tuple = serde.schemaToTypeCache.get(stringify(info.schema))
+  let tuple = serde.schemaToTypeCache.get(info.schema)
   if (tuple != null) {
     return tuple
   }
@@ -257,11 +428,20 @@ async function toType(
     ...avroOpts,
     typeHook: addReferencedSchemas(avroOpts?.typeHook),
   })
-  serde.schemaToTypeCache.set(stringify(info.schema), [type, deps])
+  serde.schemaToTypeCache.set(info.schema, [type, deps])
   return [type, deps]
 }
 
 async function transform(ctx: RuleContext, schema: Type, msg: any, fieldTransform: FieldTransform): Promise<any> {
+  const plan = ctx.fieldRulePlan(ruleTags => taggedFields(ctx, schema, ruleTags))
+  if (plan.fields != null && plan.fields.size === 0) {
+    return msg
+  }
+  return await transformValue(ctx, plan, schema, msg, fieldTransform)
+}
+
+async function transformValue(ctx: RuleContext, plan: FieldRulePlan, schema: Type, msg: any,
+                              fieldTransform: FieldTransform): Promise<any> {
   if (msg == null || schema == null) {
     return msg
   }
@@ -276,31 +456,31 @@ async function transform(ctx: RuleContext, schema: Type, msg: any, fieldTransfor
       if (subschema == null) {
         return null
       }
-      return await transform(ctx, subschema, msg, fieldTransform)
+      return await transformValue(ctx, plan, subschema, msg, fieldTransform)
     case 'array':
       const arraySchema = schema as ArrayType
       const array = msg as any[]
-      return await Promise.all(array.map(item => transform(ctx, arraySchema.itemsType, item, fieldTransform)))
+      return await Promise.all(array.map(item => transformValue(ctx, plan, arraySchema.itemsType, item, fieldTransform)))
     case 'map':
       const mapSchema = schema as MapType
       const map = msg as { [key: string]: any }
       for (const key of Object.keys(map)) {
-        map[key] = await transform(ctx, mapSchema.valuesType, map[key], fieldTransform)
+        map[key] = await transformValue(ctx, plan, mapSchema.valuesType, map[key], fieldTransform)
       }
       return map
     case 'record':
       const recordSchema = schema as RecordType
       const record = msg as Record<string, any>
       for (const field of recordSchema.fields) {
-        await transformField(ctx, recordSchema, field, record, fieldTransform)
+        if (plan.fields != null && !plan.fields.has(recordSchema.name + '.' + field.name)) {
+          continue
+        }
+        await transformField(ctx, plan, recordSchema, field, record, fieldTransform)
       }
       return record
     default:
-      if (fieldCtx != null) {
-        const ruleTags = ctx.rule.tags ?? []
-        if (ruleTags == null || ruleTags.length === 0 || !disjoint(new Set<string>(ruleTags), fieldCtx.tags)) {
-          return await fieldTransform.transform(ctx, fieldCtx, msg)
-        }
+      if (ctx.appliesTo(plan)) {
+        return await fieldTransform.transform(ctx, fieldCtx!, msg)
       }
       return msg
   }
@@ -308,6 +488,7 @@ async function transform(ctx: RuleContext, schema: Type, msg: any, fieldTransfor
 
 async function transformField(
   ctx: RuleContext,
+  plan: FieldRulePlan,
   recordSchema: RecordType,
   field: Field,
   record: Record<string, any>,
@@ -322,7 +503,7 @@ async function transformField(
       getType(field.type),
       null
     )
-    const newVal = await transform(ctx, field.type, record[field.name], fieldTransform)
+    const newVal = await transformValue(ctx, plan, field.type, record[field.name], fieldTransform)
     if (ctx.rule.kind === 'CONDITION') {
       if (!newVal) {
         throw new RuleConditionError(ctx.rule)
@@ -372,6 +553,80 @@ function getType(schema: Type): FieldType {
   }
 }
 
+// taggedFields returns the full names of the record fields that carry one of
+// the rule tags, or whose type leads to a record with such fields
+function taggedFields(ctx: RuleContext, schema: Type, ruleTags: Set<string>): Set<string> {
+  const records = new Map<string, RecordType>()
+  collectRecords(schema, records)
+  const fields = new Set<string>()
+  const taggedRecords = new Set<string>()
+  // Repeat until no more fields are found, for records that refer to each other
+  let changed = true
+  while (changed) {
+    changed = false
+    for (const [name, record] of records) {
+      for (const field of record.fields) {
+        const fullName = name + '.' + field.name
+        if (fields.has(fullName)) {
+          continue
+        }
+        if (hasRuleTag(ctx, fullName, ruleTags) || leadsToRecord(field.type, taggedRecords)) {
+          fields.add(fullName)
+          taggedRecords.add(name)
+          changed = true
+        }
+      }
+    }
+  }
+  return fields
+}
+
+function collectRecords(schema: Type, records: Map<string, RecordType>): void {
+  switch (schema.typeName) {
+    case 'union:unwrapped':
+    case 'union:wrapped':
+      for (const type of (schema as UnwrappedUnionType | WrappedUnionType).types) {
+        collectRecords(type, records)
+      }
+      break
+    case 'array':
+      collectRecords((schema as ArrayType).itemsType, records)
+      break
+    case 'map':
+      collectRecords((schema as MapType).valuesType, records)
+      break
+    case 'record':
+      const recordSchema = schema as RecordType
+      if (!records.has(recordSchema.name!)) {
+        records.set(recordSchema.name!, recordSchema)
+        for (const field of recordSchema.fields) {
+          collectRecords(field.type, records)
+        }
+      }
+      break
+  }
+}
+
+function leadsToRecord(schema: Type, records: Set<string>): boolean {
+  switch (schema.typeName) {
+    case 'union:unwrapped':
+    case 'union:wrapped':
+      return (schema as UnwrappedUnionType | WrappedUnionType).types.some(type => leadsToRecord(type, records))
+    case 'array':
+      return leadsToRecord((schema as ArrayType).itemsType, records)
+    case 'map':
+      return leadsToRecord((schema as MapType).valuesType, records)
+    case 'record':
+      return records.has((schema as RecordType).name!)
+    default:
+      return false
+  }
+}
+
+function hasRuleTag(ctx: RuleContext, fullName: string, ruleTags: Set<string>): boolean {
+  return !disjoint(ruleTags, ctx.getInlineTags(fullName)) || !disjoint(ruleTags, ctx.getTags(fullName))
+}
+
 function disjoint(slice1: Set<string>, map1: Set<string>): boolean {
   for (const v of slice1) {
     if (map1.has(v)) {
@@ -400,12 +655,25 @@ function resolveUnion(schema: Type, msg: any): Type | null {
   return null
 }
 
+function planKey(subject: string, id: number, readerMeta: SchemaMetadata | null): string {
+  return `${subject}:${id}:${readerMeta?.id ?? -1}:${readerMeta?.version ?? -1}`
+}
+
+// inline tags per writer schema, so that field rule plans, which are kept
+// per inline tags, are compiled once per schema
+const inlineTagsCache = new WeakMap<SchemaInfo, { schema: string, inlineTags: Map<string, Set<string>> }>()
+
 function getInlineTags(info: SchemaInfo, deps: Map<string, string>): Map<string, Set<string>> {
+  const cached = inlineTagsCache.get(info)
+  if (cached != null && cached.schema === info.schema) {
+    return cached.inlineTags
+  }
   const inlineTags = new Map<string, Set<string>>()
   getInlineTagsRecursively('', '', JSON.parse(info.schema), inlineTags)
   for (const depSchema of deps.values()) {
     getInlineTagsRecursively('', '', JSON.parse(depSchema), inlineTags)
   }
+  inlineTagsCache.set(info, { schema: info.schema, inlineTags })
   return inlineTags
 }
 
@@ -1,10 +1,11 @@
 import {
   Deserializer, DeserializerConfig,
+  FieldRulePlan,
   FieldTransform,
-  FieldType, Migration, RefResolver, RuleConditionError,
+  FieldType, HEADER_SIZE, Migration, RefResolver, RuleConditionError,
   RuleContext,
   SerdeType, SerializationError,
-  Serializer, SerializerConfig
+  Serializer, SerializerConfig, WireHeader
 } from "./serde";
 import {
   Client, RuleMode,
@@ -29,7 +30,6 @@ import { validateJSON } from '@criteria/json-schema-validation'
 import { LRUCache } from "lru-cache";
 import { generateSchema } from "./json-util";
 import {RuleRegistry} from "./rule-registry";
-import stringify from "json-stringify-deterministic";
 
 export interface ValidateFunction {
   (this: any, data: any): boolean
@@ -104,15 +104,84 @@ export class JsonSerializer extends Serializer implements JsonSerde {
     }
     const [id, info] = await this.getId(topic, msg, schema)
     const subject = this.subjectName(topic, info)
-    msg = await this.executeRules(subject, topic, RuleMode.WRITE, null, info, msg, null)
-    const msgBytes = Buffer.from(JSON.stringify(msg))
+    if (this.hasActiveRules(RuleMode.WRITE, info)) {
+      msg = await this.executeRules(subject, topic, RuleMode.WRITE, null, info, msg, null)
+    }
+    const msgJson = JSON.stringify(msg)
     if ((this.conf as JsonSerdeConfig).validate) {
       const validate = await this.toValidateFunction(info)
       if (validate != null && !validate(msg)) {
         throw new SerializationError('Invalid message')
       }
     }
-    return this.writeBytes(id, msgBytes)
+    return this.encode(id, msgJson)
+  }
+
+  // encode writes the JSON text straight behind the wire format header
+  private encode(id: number, msgJson: string): Buffer {
+    const buffer = this.allocMessage(id, Buffer.byteLength(msgJson))
+    buffer.write(msgJson, HEADER_SIZE)
+    return buffer
+  }
+
+  /**
+   * Serializes several messages. Messages are grouped by schema, which is
+   * looked up once per group.
+   * @param topic - the topic
+   * @param msgs - the messages
+   */
+  override async serializeBatch(topic: string, msgs: any[]): Promise<Buffer[]> {
+    if (this.client == null) {
+      throw new Error('client is not initialized')
+    }
+
+    // Don't derive the schema if it is being looked up in the following ways
+    const deriveSchema = this.config().useSchemaId == null &&
+      !this.config().useLatestVersion &&
+      this.config().useLatestWithMetadata == null
+    const groups = new Map<string, number[]>()
+    for (let i = 0; i < msgs.length; i++) {
+      if (msgs[i] == null) {
+        throw new Error('message is empty')
+      }
+      const key = deriveSchema ? JSON.stringify(JsonSerializer.messageToSchema(msgs[i])) : ''
+      let indexes = groups.get(key)
+      if (indexes == null) {
+        indexes = []
+        groups.set(key, indexes)
+      }
+      indexes.push(i)
+    }
+
+    const result = new Array<Buffer>(msgs.length)
+    for (const [key, indexes] of groups) {
+      let schema: SchemaInfo | undefined = undefined
+      if (deriveSchema) {
+        schema = {
+          schemaType: 'JSON',
+          schema: key,
+        }
+      }
+      const [id, info] = await this.getId(topic, msgs[indexes[0]], schema)
+      const subject = this.subjectName(topic, info)
+      const hasRules = this.hasActiveRules(RuleMode.WRITE, info)
+      let validate: ValidateFunction | undefined
+      if ((this.conf as JsonSerdeConfig).validate) {
+        validate = await this.toValidateFunction(info)
+      }
+      for (const i of indexes) {
+        let msg = msgs[i]
+        if (hasRules) {
+          msg = await this.executeRules(subject, topic, RuleMode.WRITE, null, info, msg, null)
+        }
+        const msgJson = JSON.stringify(msg)
+        if (validate != null && !validate(msg)) {
+          throw new SerializationError('Invalid message')
+        }
+        result[i] = this.encode(id, msgJson)
+      }
+    }
+    return result
   }
 
   async fieldTransform(ctx: RuleContext, fieldTransform: FieldTransform, msg: any): Promise<any> {
@@ -180,22 +249,25 @@ export class JsonDeserializer extends Deserializer implements JsonSerde {
    * Deserializes a message.
    * @param topic - the topic
    * @param payload - the message payload
+   * @param header - the already parsed wire format header, if any
    */
-  override async deserialize(topic: string, payload: Buffer): Promise<any> {
+  override async deserialize(topic: string, payload: Buffer, header?: WireHeader): Promise<any> {
     if (!Buffer.isBuffer(payload)) {
       throw new Error('Invalid buffer')
     }
-    if (payload.length === 0) {
+    if (payload.length === 0 && header?.schemaId == null) {
       return null
     }
 
-    const info = await this.getSchema(topic, payload)
+    const [id, msgBytes] = this.splitPayload(payload, header)
+    const info = await this.getSchemaById(topic, id)
+    // The payload is decoded once, and validated as the returned message
+    let msg = JSON.parse(msgBytes.toString())
     if ((this.conf as JsonSerdeConfig).validate) {
       const validate = await this.toValidateFunction(info)
-      if (validate != null && !validate(JSON.parse(payload.subarray(5).toString()))) {
+      if (validate != null && !validate(msg)) {
         throw new SerializationError('Invalid message')
       }
-
     }
     const subject = this.subjectName(topic, info)
     const readerMeta = await this.getReaderSchema(subject)
@@ -203,8 +275,6 @@ export class JsonDeserializer extends Deserializer implements JsonSerde {
     if (readerMeta != null) {
       migrations = await this.getMigrations(subject, info, readerMeta)
     }
-    const msgBytes = payload.subarray(5)
-    let msg = JSON.parse(msgBytes.toString())
     if (migrations.length > 0) {
       msg = await this.executeMigrations(migrations, subject, topic, msg)
     }
@@ -214,10 +284,53 @@ export class JsonDeserializer extends Deserializer implements JsonSerde {
     } else {
       target = info
     }
-    msg = this.executeRules(subject, topic, RuleMode.READ, null, target, msg, null)
+    if (this.hasActiveRules(RuleMode.READ, target)) {
+      msg = await this.executeRules(subject, topic, RuleMode.READ, null, target, msg, null)
+    }
     return msg
   }
 
+  /**
+   * Deserializes several messages. Messages are grouped by schema ID, and the
+   * schema, validation function and migrations are resolved once per group.
+   * @param topic - the topic
+   * @param payloads - the message payloads
+   * @param headers - the already parsed wire format headers, if any
+   */
+  override async deserializeBatch(topic: string, payloads: Buffer[], headers?: WireHeader[]): Promise<any[]> {
+    const msgs = new Array<any>(payloads.length).fill(null)
+    for (const [id, indexes] of this.groupBySchemaId(payloads, headers)) {
+      const info = await this.getSchemaById(topic, id)
+      let validate: ValidateFunction | undefined
+      if ((this.conf as JsonSerdeConfig).validate) {
+        validate = await this.toValidateFunction(info)
+      }
+      const subject = this.subjectName(topic, info)
+      const readerMeta = await this.getReaderSchema(subject)
+      let migrations: Migration[] = []
+      if (readerMeta != null) {
+        migrations = await this.getMigrations(subject, info, readerMeta)
+      }
+      const target: SchemaInfo = readerMeta ?? info
+      const hasRules = this.hasActiveRules(RuleMode.READ, target)
+
+      for (const i of indexes) {
+        let msg = JSON.parse(this.splitPayload(payloads[i], headers?.[i])[1].toString())
+        if (validate != null && !validate(msg)) {
+          throw new SerializationError('Invalid message')
+        }
+        if (migrations.length > 0) {
+          msg = await this.executeMigrations(migrations, subject, topic, msg)
+        }
+        if (hasRules) {
+          msg = await this.executeRules(subject, topic, RuleMode.READ, null, target, msg, null)
+        }
+        msgs[i] = msg
+      }
+    }
+    return msgs
+  }
+
   async fieldTransform(ctx: RuleContext, fieldTransform: FieldTransform, msg: any): Promise<any> {
     const schema = await this.toType(ctx.target)
     return await transform(ctx, schema, '$', msg, fieldTransform)
@@ -248,7 +361,7 @@ async function toValidateFunction(
     info: SchemaInfo,
     refResolver: RefResolver,
 ): Promise<ValidateFunction | undefined> {
-  let fn = serde.schemaToValidateCache.get(stringify(info.schema))
+  let fn = serde.schemaToValidateCache.get(info.schema)
   if (fn != null) {
     return fn
   }
@@ -275,7 +388,7 @@ async function toValidateFunction(
     })
     fn = ajv.compile(json)
   }
-  serde.schemaToValidateCache.set(stringify(info.schema), fn)
+  serde.schemaToValidateCache.set(info.schema, fn)
   return fn
 }
 
@@ -286,7 +399,7 @@ async function toType(
   info: SchemaInfo,
   refResolver: RefResolver,
 ): Promise<DereferencedJSONSchema> {
-  let type = serde.schemaToTypeCache.get(stringify(info.schema))
+  let type = serde.schemaToTypeCache.get(info.schema)
   if (type != null) {
     return type
   }
@@ -310,11 +423,20 @@ async function toType(
   } else {
     schema = await dereferenceJSONSchemaDraft07(json, { retrieve })
   }
-  serde.schemaToTypeCache.set(stringify(info.schema), schema)
+  serde.schemaToTypeCache.set(info.schema, schema)
   return schema
 }
 
 async function transform(ctx: RuleContext, schema: DereferencedJSONSchema, path:string, msg: any, fieldTransform: FieldTransform): Promise<any> {
+  const plan = ctx.fieldRulePlan(ruleTags => taggedFields(ctx, schema, path, ruleTags))
+  if (plan.fields != null && plan.fields.size === 0) {
+    return msg
+  }
+  return await transformValue(ctx, plan, schema, path, msg, fieldTransform)
+}
+
+async function transformValue(ctx: RuleContext, plan: FieldRulePlan, schema: DereferencedJSONSchema, path: string,
+                              msg: any, fieldTransform: FieldTransform): Promise<any> {
   if (msg == null || schema == null || typeof schema === 'boolean') {
     return msg
   }
@@ -325,38 +447,41 @@ async function transform(ctx: RuleContext, schema: DereferencedJSONSchema, path:
   if (schema.allOf != null && schema.allOf.length > 0) {
     let subschema = validateSubschemas(schema.allOf, msg)
     if (subschema != null) {
-      return await transform(ctx, subschema, path, msg, fieldTransform)
+      return await transformValue(ctx, plan, subschema, path, msg, fieldTransform)
     }
   }
   if (schema.anyOf != null && schema.anyOf.length > 0) {
     let subschema = validateSubschemas(schema.anyOf, msg)
     if (subschema != null) {
-      return await transform(ctx, subschema, path, msg, fieldTransform)
+      return await transformValue(ctx, plan, subschema, path, msg, fieldTransform)
     }
   }
   if (schema.oneOf != null && schema.oneOf.length > 0) {
     let subschema = validateSubschemas(schema.oneOf, msg)
     if (subschema != null) {
-      return await transform(ctx, subschema, path, msg, fieldTransform)
+      return await transformValue(ctx, plan, subschema, path, msg, fieldTransform)
     }
   }
   if (schema.items != null) {
     if (Array.isArray(msg)) {
       for (let i = 0; i < msg.length; i++) {
-        msg[i] = await transform(ctx, schema.items, path, msg[i], fieldTransform)
+        msg[i] = await transformValue(ctx, plan, schema.items, path, msg[i], fieldTransform)
       }
       return msg
     }
   }
   if (schema.$ref != null) {
-    return await transform(ctx, schema.$ref, path, msg, fieldTransform)
+    return await transformValue(ctx, plan, schema.$ref, path, msg, fieldTransform)
   }
   let type = getType(schema)
   switch (type) {
     case FieldType.RECORD:
       if (schema.properties != null) {
         for (let [propName, propSchema] of Object.entries(schema.properties)) {
-          await transformField(ctx, path, propName, msg, propSchema, fieldTransform)
+          if (plan.fields != null && !plan.fields.has(path + '.' + propName)) {
+            continue
+          }
+          await transformField(ctx, plan, path, propName, msg, propSchema, fieldTransform)
         }
       }
       return msg
@@ -365,25 +490,22 @@ async function transform(ctx: RuleContext, schema: DereferencedJSONSchema, path:
     case FieldType.INT:
     case FieldType.DOUBLE:
     case FieldType.BOOLEAN:
-      if (fieldCtx != null) {
-        const ruleTags = ctx.rule.tags
-        if (ruleTags == null || ruleTags.length === 0 || !disjoint(new Set<string>(ruleTags), fieldCtx.tags)) {
-          return await fieldTransform.transform(ctx, fieldCtx, msg)
-        }
+      if (ctx.appliesTo(plan)) {
+        return await fieldTransform.transform(ctx, fieldCtx!, msg)
       }
   }
 
   return msg
 }
 
-async function transformField(ctx: RuleContext, path: string, propName: string, msg: any,
+async function transformField(ctx: RuleContext, plan: FieldRulePlan, path: string, propName: string, msg: any,
                               propSchema: DereferencedJSONSchema,
                               fieldTransform: FieldTransform): Promise<void> {
   const fullName = path + '.' + propName
   try {
     ctx.enterField(msg, fullName, propName, getType(propSchema), getInlineTags(propSchema))
     let value = msg[propName]
-    const newVal = await transform(ctx, propSchema, fullName, value, fieldTransform)
+    const newVal = await transformValue(ctx, plan, propSchema, fullName, value, fieldTransform)
     if (ctx.rule.kind === 'CONDITION') {
       if (newVal === false) {
         throw new RuleConditionError(ctx.rule)
@@ -449,6 +571,64 @@ function getInlineTags(schema: DereferencedJSONSchema): Set<string> {
   return new Set<string>(schema[tagsKey])
 }
 
+// taggedFields returns the full names of the properties that carry one of the
+// rule tags, or lead to properties that do. It returns null for recursive
+// schemas, whose paths are unbounded.
+function taggedFields(ctx: RuleContext, schema: DereferencedJSONSchema, path: string,
+                      ruleTags: Set<string>): Set<string> | null {
+  const fields = new Set<string>()
+  if (collectTaggedFields(ctx, schema, path, ruleTags, fields, new Set<object>()) == null) {
+    return null
+  }
+  return fields
+}
+
+// collectTaggedFields returns whether the schema leads to tagged properties,
+// or null if it is recursive
+function collectTaggedFields(ctx: RuleContext, schema: DereferencedJSONSchema, path: string,
+                             ruleTags: Set<string>, fields: Set<string>, ancestors: Set<object>): boolean | null {
+  if (schema == null || typeof schema === 'boolean') {
+    return false
+  }
+  if (ancestors.has(schema)) {
+    return null
+  }
+  ancestors.add(schema)
+  try {
+    const subschemas: DereferencedJSONSchema[] = [
+      ...(schema.allOf ?? []), ...(schema.anyOf ?? []), ...(schema.oneOf ?? []),
+    ]
+    if (schema.items != null) {
+      subschemas.push(schema.items as DereferencedJSONSchema)
+    }
+    if (schema.$ref != null) {
+      subschemas.push(schema.$ref as DereferencedJSONSchema)
+    }
+    let found = false
+    for (const subschema of subschemas) {
+      const result = collectTaggedFields(ctx, subschema, path, ruleTags, fields, ancestors)
+      if (result == null) {
+        return null
+      }
+      found = found || result
+    }
+    for (const [propName, propSchema] of Object.entries(schema.properties ?? {})) {
+      const fullName = path + '.' + propName
+      const result = collectTaggedFields(ctx, propSchema, fullName, ruleTags, fields, ancestors)
+      if (result == null) {
+        return null
+      }
+      if (result || !disjoint(ruleTags, getInlineTags(propSchema)) || !disjoint(ruleTags, ctx.getTags(fullName))) {
+        fields.add(fullName)
+        found = true
+      }
+    }
+    return found
+  } finally {
+    ancestors.delete(schema)
+  }
+}
+
 function disjoint(tags1: Set<string>, tags2: Set<string>): boolean {
   for (let tag of tags1) {
     if (tags2.has(tag)) {
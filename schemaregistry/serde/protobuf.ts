@@ -1,12 +1,14 @@
 import {
   Deserializer,
   DeserializerConfig,
+  FieldRulePlan,
   FieldTransform,
-  FieldType, RuleConditionError,
+  FieldType, HEADER_SIZE, RuleConditionError,
   RuleContext,
   SerdeType, SerializationError,
   Serializer,
-  SerializerConfig
+  SerializerConfig,
+  WireHeader
 } from "./serde";
 import {
   Client, Reference, RuleMode,
@@ -42,7 +44,6 @@ import { BufferWrapper, MAX_VARINT_LEN_64 } from "./buffer-wrapper";
 import { LRUCache } from "lru-cache";
 import {field_meta, file_confluent_meta, Meta} from "../confluent/meta_pb";
 import {RuleRegistry} from "./rule-registry";
-import stringify from "json-stringify-deterministic";
 import {file_confluent_types_decimal} from "../confluent/types/decimal_pb";
 import {file_google_type_calendar_period} from "../google/type/calendar_period_pb";
 import {file_google_type_color} from "../google/type/color_pb";
@@ -106,6 +107,8 @@ export class ProtobufSerializer extends Serializer implements ProtobufSerde {
   fileRegistry: FileRegistry
   schemaToDescCache: LRUCache<string, DescFile>
   descToSchemaCache: LRUCache<string, SchemaInfo>
+  // the encoded message indexes of each message type
+  private msgIndexBytesCache: WeakMap<DescMessage, Buffer> = new WeakMap()
 
   /**
    * Creates a new ProtobufSerializer.
@@ -160,10 +163,75 @@ export class ProtobufSerializer extends Serializer implements ProtobufSerde {
     }
     const [id, info] = await this.getId(topic, msg, schema, 'serialized')
     const subject = this.subjectName(topic, info)
-    msg = await this.executeRules(subject, topic, RuleMode.WRITE, null, info, msg, null)
-    const msgIndexBytes = this.toMessageIndexBytes(messageDesc)
-    const msgBytes = Buffer.from(toBinary(messageDesc, msg))
-    return this.writeBytes(id, Buffer.concat([msgIndexBytes, msgBytes]))
+    if (this.hasActiveRules(RuleMode.WRITE, info)) {
+      msg = await this.executeRules(subject, topic, RuleMode.WRITE, null, info, msg, null)
+    }
+    return this.encode(id, this.toMessageIndexBytes(messageDesc), messageDesc, msg)
+  }
+
+  // encode writes the message indexes and the message straight behind the wire format header
+  private encode(id: number, msgIndexBytes: Buffer, messageDesc: DescMessage, msg: any): Buffer {
+    const msgBytes = toBinary(messageDesc, msg)
+    const buffer = this.allocMessage(id, msgIndexBytes.length + msgBytes.length)
+    msgIndexBytes.copy(buffer, HEADER_SIZE)
+    buffer.set(msgBytes, HEADER_SIZE + msgIndexBytes.length)
+    return buffer
+  }
+
+  /**
+   * Serializes several messages. Messages are grouped by message type, whose
+   * schema and message indexes are looked up once per group.
+   * @param topic - the topic
+   * @param msgs - the messages
+   */
+  override async serializeBatch(topic: string, msgs: any[]): Promise<Buffer[]> {
+    if (this.client == null) {
+      throw new Error('client is not initialized')
+    }
+
+    const groups = new Map<string, number[]>()
+    for (let i = 0; i < msgs.length; i++) {
+      if (msgs[i] == null) {
+        throw new Error('message is empty')
+      }
+      const typeName = msgs[i].$typeName
+      if (typeName == null) {
+        throw new SerializationError('message type name is empty')
+      }
+      let indexes = groups.get(typeName)
+      if (indexes == null) {
+        indexes = []
+        groups.set(typeName, indexes)
+      }
+      indexes.push(i)
+    }
+
+    const result = new Array<Buffer>(msgs.length)
+    for (const [typeName, indexes] of groups) {
+      const messageDesc = this.registry.getMessage(typeName)
+      if (messageDesc == null) {
+        throw new SerializationError('message descriptor not in registry')
+      }
+      let schema: SchemaInfo | undefined = undefined
+      // Don't derive the schema if it is being looked up in the following ways
+      if (this.config().useSchemaId == null &&
+        !this.config().useLatestVersion &&
+        this.config().useLatestWithMetadata == null) {
+        schema = await this.getSchemaInfo(messageDesc.file)
+      }
+      const [id, info] = await this.getId(topic, msgs[indexes[0]], schema, 'serialized')
+      const subject = this.subjectName(topic, info)
+      const hasRules = this.hasActiveRules(RuleMode.WRITE, info)
+      const msgIndexBytes = this.toMessageIndexBytes(messageDesc)
+      for (const i of indexes) {
+        let msg = msgs[i]
+        if (hasRules) {
+          msg = await this.executeRules(subject, topic, RuleMode.WRITE, null, info, msg, null)
+        }
+        result[i] = this.encode(id, msgIndexBytes, messageDesc, msg)
+      }
+    }
+    return result
   }
 
   async getSchemaInfo(fileDesc: DescFile): Promise<SchemaInfo> {
@@ -246,6 +314,16 @@ export class ProtobufSerializer extends Serializer implements ProtobufSerde {
   }
 
   toMessageIndexBytes(messageDesc: DescMessage): Buffer {
+    let value = this.msgIndexBytesCache.get(messageDesc)
+    if (value != null) {
+      return value
+    }
+    value = this.computeMessageIndexBytes(messageDesc)
+    this.msgIndexBytesCache.set(messageDesc, value)
+    return value
+  }
+
+  private computeMessageIndexBytes(messageDesc: DescMessage): Buffer {
     const msgIndexes: number[] = this.toMessageIndexes(messageDesc, 0)
     const buffer = Buffer.alloc((1 + msgIndexes.length) * MAX_VARINT_LEN_64)
     const bw = new BufferWrapper(buffer)
@@ -300,7 +378,7 @@ export class ProtobufSerializer extends Serializer implements ProtobufSerde {
   }
 
   async toFileDesc(client: Client, info: SchemaInfo): Promise<DescFile> {
-    const value = this.schemaToDescCache.get(stringify(info.schema))
+    const value = this.schemaToDescCache.get(info.schema)
     if (value != null) {
       return value
     }
@@ -308,7 +386,7 @@ export class ProtobufSerializer extends Serializer implements ProtobufSerde {
     if (fileDesc == null) {
       throw new SerializationError('file descriptor not found')
     }
-    this.schemaToDescCache.set(stringify(info.schema), fileDesc)
+    this.schemaToDescCache.set(info.schema, fileDesc)
     return fileDesc
   }
 
@@ -342,6 +420,8 @@ export type ProtobufDeserializerConfig = DeserializerConfig
 export class ProtobufDeserializer extends Deserializer implements ProtobufSerde {
   fileRegistry: FileRegistry
   schemaToDescCache: LRUCache<string, DescFile>
+  // message descriptors of writer schemas by schema ID and message index path
+  idToDescCache: LRUCache<number, SchemaDescs>
 
   /**
    * Creates a new ProtobufDeserializer.
@@ -354,6 +434,7 @@ export class ProtobufDeserializer extends Deserializer implements ProtobufSerde
     super(client, serdeType, conf, ruleRegistry)
     this.fileRegistry = createFileRegistry()
     this.schemaToDescCache = new LRUCache<string, DescFile>({ max: this.config().cacheCapacity ?? 1000 } )
+    this.idToDescCache = new LRUCache<number, SchemaDescs>({ max: this.config().cacheCapacity ?? 1000 } )
     this.fieldTransformer = async (ctx: RuleContext, fieldTransform: FieldTransform, msg: any) => {
       return await this.fieldTransform(ctx, fieldTransform, msg)
     }
@@ -366,24 +447,24 @@ export class ProtobufDeserializer extends Deserializer implements ProtobufSerde
    * Deserializes a message.
    * @param topic - the topic
    * @param payload - the message payload
+   * @param header - the already parsed wire format header, if any
    */
-  override async deserialize(topic: string, payload: Buffer): Promise<any> {
+  override async deserialize(topic: string, payload: Buffer, header?: WireHeader): Promise<any> {
     if (!Buffer.isBuffer(payload)) {
       throw new Error('Invalid buffer')
     }
-    if (payload.length === 0) {
+    if (payload.length === 0 && header?.schemaId == null) {
       return null
     }
 
-    const info = await this.getSchema(topic, payload, 'serialized')
-    const fd = await this.toFileDesc(this.client, info)
-    const [bytesRead, msgIndexes] = this.readMessageIndexes(payload.subarray(5))
-    const messageDesc = this.toMessageDescFromIndexes(fd, msgIndexes)
+    const [id, body] = this.splitPayload(payload, header)
+    const info = await this.getSchemaById(topic, id, 'serialized')
+    const [msgIndexes, msgBytes] = this.splitMessageIndexes(body, header)
+    const messageDesc = await this.toMessageDescById(id, info, msgIndexes)
 
     const subject = this.subjectName(topic, info)
     const readerMeta = await this.getReaderSchema(subject, 'serialized')
 
-    const msgBytes = payload.subarray(5 + bytesRead)
     let msg = fromBinary(messageDesc, msgBytes)
 
     // Currently JavaScript does not support migration rules
@@ -394,10 +475,43 @@ export class ProtobufDeserializer extends Deserializer implements ProtobufSerde
     } else {
       target = info
     }
-    msg = await this.executeRules(subject, topic, RuleMode.READ, null, target, msg, null)
+    if (this.hasActiveRules(RuleMode.READ, target)) {
+      msg = await this.executeRules(subject, topic, RuleMode.READ, null, target, msg, null)
+    }
     return msg
   }
 
+  /**
+   * Deserializes several messages. Messages are grouped by schema ID, whose
+   * file descriptor and reader schema are resolved once per group.
+   * @param topic - the topic
+   * @param payloads - the message payloads
+   * @param headers - the already parsed wire format headers, if any
+   */
+  override async deserializeBatch(topic: string, payloads: Buffer[], headers?: WireHeader[]): Promise<any[]> {
+    const msgs = new Array<any>(payloads.length).fill(null)
+    for (const [id, indexes] of this.groupBySchemaId(payloads, headers)) {
+      const info = await this.getSchemaById(topic, id, 'serialized')
+      const subject = this.subjectName(topic, info)
+      const readerMeta = await this.getReaderSchema(subject, 'serialized')
+      // Currently JavaScript does not support migration rules
+      // because of lack of support for DynamicMessage
+      const target: SchemaInfo = readerMeta ?? info
+      const hasRules = this.hasActiveRules(RuleMode.READ, target)
+
+      for (const i of indexes) {
+        const [, body] = this.splitPayload(payloads[i], headers?.[i])
+        const [msgIndexes, msgBytes] = this.splitMessageIndexes(body, headers?.[i])
+        let msg = fromBinary(await this.toMessageDescById(id, info, msgIndexes), msgBytes)
+        if (hasRules) {
+          msg = await this.executeRules(subject, topic, RuleMode.READ, null, target, msg, null)
+        }
+        msgs[i] = msg
+      }
+    }
+    return msgs
+  }
+
   async fieldTransform(ctx: RuleContext, fieldTransform: FieldTransform, msg: any): Promise<any> {
     const fileDesc = await this.toFileDesc(this.client, ctx.target)
     const typeName = msg.$typeName
@@ -406,7 +520,7 @@ export class ProtobufDeserializer extends Deserializer implements ProtobufSerde
   }
 
   async toFileDesc(client: Client, info: SchemaInfo): Promise<DescFile> {
-    const value = this.schemaToDescCache.get(stringify(info.schema))
+    const value = this.schemaToDescCache.get(info.schema)
     if (value != null) {
       return value
     }
@@ -414,7 +528,7 @@ export class ProtobufDeserializer extends Deserializer implements ProtobufSerde
     if (fileDesc == null) {
       throw new SerializationError('file descriptor not found')
     }
-    this.schemaToDescCache.set(stringify(info.schema), fileDesc)
+    this.schemaToDescCache.set(info.schema, fileDesc)
     return fileDesc
   }
 
@@ -436,9 +550,24 @@ export class ProtobufDeserializer extends Deserializer implements ProtobufSerde
     throw new SerializationError('message descriptor not found')
   }
 
+  // splitMessageIndexes returns the message indexes and the message bytes of
+  // the given payload, which starts after the schema ID, reading the indexes
+  // unless they were already parsed
+  splitMessageIndexes(payload: Buffer, header?: WireHeader): [number[], Buffer] {
+    if (header?.schemaId != null && header.messageIndexes != null) {
+      return [header.messageIndexes, payload]
+    }
+    const [bytesRead, msgIndexes] = this.readMessageIndexes(payload)
+    return [msgIndexes, payload.subarray(bytesRead)]
+  }
+
   readMessageIndexes(payload: Buffer): [number, number[]] {
     const bw = new BufferWrapper(payload)
     const count = bw.readVarInt()
+    if (count === 0) {
+      // A count of zero is the shorthand for the first message
+      return [bw.pos, [0]]
+    }
     const msgIndexes = []
     for (let i = 0; i < count; i++) {
       msgIndexes.push(bw.readVarInt())
@@ -446,6 +575,32 @@ export class ProtobufDeserializer extends Deserializer implements ProtobufSerde
     return [bw.pos, msgIndexes]
   }
 
+  /**
+   * Returns the descriptor of the message with the given indexes in the
+   * writer schema with the given ID, so that messages of a known schema and
+   * type are decoded after a single lookup.
+   * @param id - the schema ID
+   * @param info - the schema with that ID
+   * @param msgIndexes - the message indexes
+   */
+  async toMessageDescById(id: number, info: SchemaInfo, msgIndexes: number[]): Promise<DescMessage> {
+    let descs = this.idToDescCache.get(id)
+    if (descs == null) {
+      descs = { fileDesc: await this.toFileDesc(this.client, info), messages: new Map() }
+      this.idToDescCache.set(id, descs)
+    }
+    const key = msgIndexes.length === 1 ? msgIndexes[0] : msgIndexes.join(',')
+    let messageDesc = descs.messages.get(key)
+    if (messageDesc == null) {
+      messageDesc = this.toMessageDescFromIndexes(descs.fileDesc, msgIndexes)
+      if (messageDesc == null) {
+        throw new SerializationError('message descriptor not found')
+      }
+      descs.messages.set(key, messageDesc)
+    }
+    return messageDesc
+  }
+
   toMessageDescFromIndexes(fd: DescFile, msgIndexes: number[]): DescMessage {
     let index = msgIndexes[0]
     if (msgIndexes.length === 1) {
@@ -463,6 +618,12 @@ export class ProtobufDeserializer extends Deserializer implements ProtobufSerde
   }
 }
 
+interface SchemaDescs {
+  fileDesc: DescFile
+  // keyed by the message index, or the comma-separated path for nested messages
+  messages: Map<number | string, DescMessage>
+}
+
 function newFileRegistry(fileDesc: FileDescriptorProto, deps: Map<string, string>): FileRegistry {
   const resolve = (depName: string) => {
     if (isBuiltin(depName)) {
@@ -485,12 +646,21 @@ function newFileRegistry(fileDesc: FileDescriptorProto, deps: Map<string, string
 }
 
 async function transform(ctx: RuleContext, descriptor: DescMessage, msg: any, fieldTransform: FieldTransform): Promise<any> {
+  const plan = ctx.fieldRulePlan(ruleTags => taggedFields(ctx, descriptor, ruleTags))
+  if (plan.fields != null && plan.fields.size === 0) {
+    return msg
+  }
+  return await transformValue(ctx, plan, descriptor, msg, fieldTransform)
+}
+
+async function transformValue(ctx: RuleContext, plan: FieldRulePlan, descriptor: DescMessage, msg: any,
+                              fieldTransform: FieldTransform): Promise<any> {
   if (msg == null || descriptor == null) {
     return msg
   }
   if (Array.isArray(msg)) {
     for (let i = 0; i < msg.length; i++) {
-      msg[i] = await transform(ctx, descriptor, msg[i], fieldTransform)
+      msg[i] = await transformValue(ctx, plan, descriptor, msg[i], fieldTransform)
     }
   }
   if (msg instanceof Map) {
@@ -501,21 +671,20 @@ async function transform(ctx: RuleContext, descriptor: DescMessage, msg: any, fi
     const fields = descriptor.fields
     for (let i = 0; i < fields.length; i++) {
       const fd = fields[i]
-      await transformField(ctx, fd, descriptor, msg, fieldTransform)
+      if (plan.fields != null && !plan.fields.has(descriptor.typeName + '.' + fd.name)) {
+        continue
+      }
+      await transformField(ctx, plan, fd, descriptor, msg, fieldTransform)
     }
     return msg
   }
-  const fieldCtx = ctx.currentField()
-  if (fieldCtx != null) {
-    const ruleTags = ctx.rule.tags ?? []
-    if (ruleTags == null || ruleTags.length === 0 || !disjoint(new Set<string>(ruleTags), fieldCtx.tags)) {
-      return await fieldTransform.transform(ctx, fieldCtx, msg)
-    }
+  if (ctx.appliesTo(plan)) {
+    return await fieldTransform.transform(ctx, ctx.currentField()!, msg)
   }
   return msg
 }
 
-async function transformField(ctx: RuleContext, fd: DescField, desc: DescMessage,
+async function transformField(ctx: RuleContext, plan: FieldRulePlan, fd: DescField, desc: DescMessage,
                               msg: any, fieldTransform: FieldTransform) {
   try {
     ctx.enterField(
@@ -526,7 +695,7 @@ async function transformField(ctx: RuleContext, fd: DescField, desc: DescMessage
       getInlineTags(fd)
     )
     const value = msg[fd.name]
-    const newValue = await transform(ctx, desc, value, fieldTransform)
+    const newValue = await transformValue(ctx, plan, fieldMessage(fd) ?? desc, value, fieldTransform)
     if (ctx.rule.kind === 'CONDITION') {
       if (newValue === false) {
         throw new RuleConditionError(ctx.rule)
@@ -591,6 +760,61 @@ function getInlineTags(fd: DescField): Set<string> {
   return new Set<string>()
 }
 
+// fieldMessage returns the descriptor of the messages held by the field, if any
+function fieldMessage(fd: DescField): DescMessage | undefined {
+  switch (fd.fieldKind) {
+    case 'message':
+      return fd.message
+    case 'list':
+      return fd.listKind === 'message' ? fd.message : undefined
+    default:
+      return undefined
+  }
+}
+
+// taggedFields returns the full names of the fields that carry one of the
+// rule tags, or hold messages with such fields
+function taggedFields(ctx: RuleContext, descriptor: DescMessage, ruleTags: Set<string>): Set<string> {
+  const messages = new Map<string, DescMessage>()
+  collectMessages(descriptor, messages)
+  const fields = new Set<string>()
+  const taggedMessages = new Set<string>()
+  // Repeat until no more fields are found, for messages that refer to each other
+  let changed = true
+  while (changed) {
+    changed = false
+    for (const [typeName, desc] of messages) {
+      for (const fd of desc.fields) {
+        const fullName = typeName + '.' + fd.name
+        if (fields.has(fullName)) {
+          continue
+        }
+        const fieldMsg = fieldMessage(fd)
+        if (!disjoint(ruleTags, getInlineTags(fd)) || !disjoint(ruleTags, ctx.getTags(fullName)) ||
+            (fieldMsg != null && taggedMessages.has(fieldMsg.typeName))) {
+          fields.add(fullName)
+          taggedMessages.add(typeName)
+          changed = true
+        }
+      }
+    }
+  }
+  return fields
+}
+
+function collectMessages(descriptor: DescMessage, messages: Map<string, DescMessage>): void {
+  if (messages.has(descriptor.typeName)) {
+    return
+  }
+  messages.set(descriptor.typeName, descriptor)
+  for (const fd of descriptor.fields) {
+    const fieldMsg = fieldMessage(fd)
+    if (fieldMsg != null) {
+      collectMessages(fieldMsg, messages)
+    }
+  }
+}
+
 function disjoint(tags1: Set<string>, tags2: Set<string>): boolean {
   for (let tag of tags1) {
     if (tags2.has(tag)) {
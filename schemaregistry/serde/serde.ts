@@ -17,6 +17,9 @@ export enum SerdeType {
 
 export const MAGIC_BYTE = Buffer.alloc(1)
 
+// HEADER_SIZE is the size of the magic byte and schema ID in front of every message
+export const HEADER_SIZE = 5
+
 /**
  * SerializationError represents a serialization error
  */
@@ -53,6 +56,7 @@ export abstract class Serde {
   conf: SerdeConfig
   fieldTransformer: FieldTransformer | null = null
   ruleRegistry: RuleRegistry
+  private rulePlans = new WeakMap<SchemaInfo, Map<RuleMode, RulePlan>>()
 
   protected constructor(client: Client, serdeType: SerdeType, conf: SerdeConfig, ruleRegistry?: RuleRegistry) {
     this.client = client
@@ -90,16 +94,89 @@ export abstract class Serde {
     if (msg == null || target == null) {
       return msg
     }
+    const plan = this.getRulePlan(ruleMode, source, target)
+    if (plan.steps.length === 0) {
+      return msg
+    }
+    const isKey = this.serdeType === SerdeType.KEY
+    for (const step of plan.steps) {
+      const rule = step.rule
+      let ctx = new RuleContext(source, target, subject, topic,
+        isKey, ruleMode, rule, step.index, plan.rules, inlineTags, this.fieldTransformer!)
+      let ruleExecutor = step.executor ?? this.ruleRegistry.getExecutor(rule.type)
+      if (ruleExecutor == null) {
+        await this.runRuleAction(ctx, step.onFailure, msg,
+          new Error(`could not find rule executor of type ${rule.type}`))
+        return msg
+      }
+      try {
+        let result = await ruleExecutor.transform(ctx, msg)
+        switch (rule.kind) {
+          case 'CONDITION':
+            if (result === false) {
+              throw new RuleConditionError(rule)
+            }
+            break
+          case 'TRANSFORM':
+            msg = result
+            break
+        }
+        if (msg == null) {
+          await this.runRuleAction(ctx, step.onFailure, msg, null)
+        } else if (step.onSuccess.action !== noneAction) {
+          await this.runRuleAction(ctx, step.onSuccess, msg, null)
+        }
+      } catch (error) {
+        if (error instanceof SerializationError) {
+          throw error
+        }
+        await this.runRuleAction(ctx, step.onFailure, msg, error as Error)
+      }
+    }
+    return msg
+  }
+
+  /**
+   * hasActiveRules returns whether any enabled rule of the schema runs in the
+   * given mode, so that callers can skip executeRules and its inputs
+   * @param ruleMode - the rule mode
+   * @param target - the schema
+   */
+  hasActiveRules(ruleMode: RuleMode, target: SchemaInfo): boolean {
+    return this.getRulePlan(ruleMode, null, target).steps.length > 0
+  }
+
+  // getRulePlan returns the rules to run for the given mode, compiling them
+  // on first use for the schema that carries them
+  private getRulePlan(ruleMode: RuleMode, source: SchemaInfo | null, target: SchemaInfo): RulePlan {
+    const info = ruleMode === RuleMode.DOWNGRADE ? source : target
+    if (info == null) {
+      return emptyRulePlan
+    }
+    let plans = this.rulePlans.get(info)
+    if (plans == null) {
+      plans = new Map<RuleMode, RulePlan>()
+      this.rulePlans.set(info, plans)
+    }
+    let plan = plans.get(ruleMode)
+    if (plan == null) {
+      plan = this.compileRulePlan(ruleMode, info)
+      plans.set(ruleMode, plan)
+    }
+    return plan
+  }
+
+  private compileRulePlan(ruleMode: RuleMode, info: SchemaInfo): RulePlan {
     let rules: Rule[] | undefined
     switch (ruleMode) {
       case RuleMode.UPGRADE:
-        rules = target.ruleSet?.migrationRules
+        rules = info.ruleSet?.migrationRules
         break
       case RuleMode.DOWNGRADE:
-        rules = source?.ruleSet?.migrationRules?.map(x => x).reverse()
+        rules = info.ruleSet?.migrationRules?.map(x => x).reverse()
         break
       default:
-        rules = target.ruleSet?.domainRules
+        rules = info.ruleSet?.domainRules
         if (ruleMode === RuleMode.READ) {
           // Execute read rules in reverse order for symmetry
           rules = rules?.map(x => x).reverse()
@@ -107,8 +184,9 @@ export abstract class Serde {
         break
     }
     if (rules == null) {
-      return msg
+      return emptyRulePlan
     }
+    const steps: RuleStep[] = []
     for (let i = 0; i < rules.length; i++ ) {
       let rule = rules[i]
       if (rule.disabled) {
@@ -132,47 +210,60 @@ export abstract class Serde {
           }
           break
       }
-      let ctx = new RuleContext(source, target, subject, topic,
-        this.serdeType === SerdeType.KEY, ruleMode, rule, i, rules, inlineTags, this.fieldTransformer!)
-      let ruleExecutor = this.ruleRegistry.getExecutor(rule.type)
-      if (ruleExecutor == null) {
-        await this.runAction(ctx, ruleMode, rule, rule.onFailure, msg,
-          new Error(`could not find rule executor of type ${rule.type}`), 'ERROR')
-        return msg
-      }
-      try {
-        let result = await ruleExecutor.transform(ctx, msg)
-        switch (rule.kind) {
-          case 'CONDITION':
-            if (result === false) {
-              throw new RuleConditionError(rule)
-            }
-            break
-          case 'TRANSFORM':
-            msg = result
-            break
-        }
-        await this.runAction(ctx, ruleMode, rule, msg != null ? rule.onSuccess : rule.onFailure,
-          msg, null, msg != null ? 'NONE' : 'ERROR')
-      } catch (error) {
-        if (error instanceof SerializationError) {
-          throw error
-        }
-        await this.runAction(ctx, ruleMode, rule, rule.onFailure, msg, error as Error, 'ERROR')
+      steps.push({
+        rule,
+        index: i,
+        executor: this.ruleRegistry.getExecutor(rule.type),
+        onSuccess: this.resolveRuleAction(rule, ruleMode, rule.onSuccess, 'NONE'),
+        onFailure: this.resolveRuleAction(rule, ruleMode, rule.onFailure, 'ERROR'),
+      })
+    }
+    return { rules, steps }
+  }
+
+  hasRules(ruleSet: RuleSet, mode: RuleMode): boolean {
+    switch (mode) {
+      case RuleMode.UPGRADE:
+      case RuleMode.DOWNGRADE:
+        return this.checkRules(ruleSet?.migrationRules, (ruleMode: RuleMode): boolean =>
+          ruleMode === mode || ruleMode === RuleMode.UPDOWN)
+      case RuleMode.UPDOWN:
+        return this.checkRules(ruleSet?.migrationRules, (ruleMode: RuleMode): boolean =>
+          ruleMode === mode)
+      case RuleMode.WRITE:
+      case RuleMode.READ:
+        return this.checkRules(ruleSet?.domainRules, (ruleMode: RuleMode): boolean =>
+          ruleMode === mode || ruleMode === RuleMode.WRITEREAD)
+      case RuleMode.WRITEREAD:
+        return this.checkRules(ruleSet?.domainRules, (ruleMode: RuleMode): boolean =>
+          ruleMode === mode)
+    }
+  }
+
+  checkRules(rules: Rule[] | undefined, filter: (ruleMode: RuleMode) => boolean): boolean {
+    if (rules == null) {
+      return false
+    }
+    for (let rule of rules) {
+      let ruleMode = rule.mode
+      if (ruleMode && filter(ruleMode)) {
+        return true
       }
     }
-    return msg
+    return false
   }
 
   async runAction(ctx: RuleContext, ruleMode: RuleMode, rule: Rule, action: string | undefined,
             msg: any, err: Error | null, defaultAction: string): Promise<void> {
-    let actionName = this.getRuleActionName(rule, ruleMode, action)
-    if (actionName == null) {
-      actionName = defaultAction
-    }
-    let ruleAction = this.getRuleAction(ctx, actionName)
+    await this.runRuleAction(ctx, this.resolveRuleAction(rule, ruleMode, action, defaultAction), msg, err)
+  }
+
+  private async runRuleAction(ctx: RuleContext, resolved: ResolvedRuleAction,
+                              msg: any, err: Error | null): Promise<void> {
+    // Actions registered after the plan was compiled are looked up here
+    let ruleAction = resolved.action ?? this.lookupRuleAction(resolved.name)
     if (ruleAction == null) {
-      throw new RuleError(`Could not find rule action of type ${actionName}`)
+      throw new RuleError(`Could not find rule action of type ${resolved.name}`)
     }
     try {
       await ruleAction.run(ctx, msg, err)
@@ -180,8 +271,17 @@ export abstract class Serde {
       if (error instanceof SerializationError) {
         throw error
       }
-      console.warn("could not run post-rule action %s: %s", actionName, error)
+      console.warn("could not run post-rule action %s: %s", resolved.name, error)
+    }
+  }
+
+  private resolveRuleAction(rule: Rule, ruleMode: RuleMode, action: string | undefined,
+                            defaultAction: string): ResolvedRuleAction {
+    let actionName = this.getRuleActionName(rule, ruleMode, action)
+    if (actionName == null) {
+      actionName = defaultAction
     }
+    return { name: actionName, action: this.lookupRuleAction(actionName) }
   }
 
   getRuleActionName(rule: Rule, ruleMode: RuleMode, actionName: string | undefined): string | null {
@@ -203,15 +303,47 @@ export abstract class Serde {
   }
 
   getRuleAction(ctx: RuleContext, actionName: string): RuleAction | undefined {
+    return this.lookupRuleAction(actionName)
+  }
+
+  private lookupRuleAction(actionName: string): RuleAction | undefined {
     if (actionName === 'ERROR') {
-      return new ErrorAction();
+      return errorAction
     } else if (actionName === 'NONE') {
-      return new NoneAction()
+      return noneAction
     }
     return this.ruleRegistry.getAction(actionName)
   }
 }
 
+/**
+ * RulePlan lists the rules of a schema that run in one rule mode, with their
+ * executors and actions already looked up
+ */
+interface RulePlan {
+  // all rules of the mode, in the order they run, as seen by RuleContext
+  rules: Rule[]
+  // the enabled rules that apply to the mode
+  steps: RuleStep[]
+}
+
+interface RuleStep {
+  rule: Rule
+  // index of the rule in RulePlan.rules
+  index: number
+  // undefined if no executor was registered when the plan was compiled
+  executor: RuleExecutor | undefined
+  onSuccess: ResolvedRuleAction
+  onFailure: ResolvedRuleAction
+}
+
+interface ResolvedRuleAction {
+  name: string
+  action: RuleAction | undefined
+}
+
+const emptyRulePlan: RulePlan = { rules: [], steps: [] }
+
 /**
  * SerializerConfig represents a serializer configuration
  */
@@ -243,6 +375,19 @@ export abstract class Serializer extends Serde {
    */
   abstract serialize(topic: string, msg: any): Promise<Buffer>
 
+  /**
+   * SerializeBatch serializes several messages for the same topic
+   * @param topic - the topic
+   * @param msgs - the messages
+   */
+  async serializeBatch(topic: string, msgs: any[]): Promise<Buffer[]> {
+    const result: Buffer[] = []
+    for (const msg of msgs) {
+      result.push(await this.serialize(topic, msg))
+    }
+    return result
+  }
+
   // GetID returns a schema ID for the given schema
   async getId(topic: string, msg: any, info?: SchemaInfo, format?: string): Promise<[number, SchemaInfo]> {
     let autoRegister = this.config().autoRegisterSchemas
@@ -272,10 +417,20 @@ export abstract class Serializer extends Serde {
     return [id, info!]
   }
 
-  writeBytes(id: number, msgBytes: Buffer): Buffer {
-    const idBuffer = Buffer.alloc(4)
-    idBuffer.writeInt32BE(id, 0)
-    return Buffer.concat([MAGIC_BYTE, idBuffer, msgBytes])
+  writeBytes(id: number, msgBytes: Uint8Array): Buffer {
+    const buffer = this.allocMessage(id, msgBytes.length)
+    buffer.set(msgBytes, HEADER_SIZE)
+    return buffer
+  }
+
+  // allocMessage returns a buffer with room for a message body of the given size,
+  // with the magic byte and schema ID already written. Small buffers are carved
+  // out of Node's shared buffer pool.
+  allocMessage(id: number, bodySize: number): Buffer {
+    const buffer = Buffer.allocUnsafe(HEADER_SIZE + bodySize)
+    buffer[0] = MAGIC_BYTE[0]
+    buffer.writeInt32BE(id, 1)
+    return buffer
   }
 }
 
@@ -293,6 +448,17 @@ export interface Migration {
   target: SchemaMetadata | null
 }
 
+/**
+ * WireHeader holds a Confluent wire format header that was already parsed,
+ * such as the `schemaId` and `messageIndexes` set on consumed messages by
+ * KafkaConsumer.setWireFormatParsing. When a header with a schema ID is given,
+ * the payload holds only the message after the header.
+ */
+export interface WireHeader {
+  schemaId?: number
+  messageIndexes?: number[]
+}
+
 /**
  * Deserializer represents a deserializer
  */
@@ -309,10 +475,68 @@ export abstract class Deserializer extends Serde {
    * Deserialize deserializes a message
    * @param topic - the topic
    * @param payload - the payload
+   * @param header - the already parsed wire format header, if any
+   */
+  abstract deserialize(topic: string, payload: Buffer, header?: WireHeader): Promise<any>
+
+  /**
+   * DeserializeBatch deserializes several messages of the same topic
+   * @param topic - the topic
+   * @param payloads - the payloads
+   * @param headers - the already parsed wire format headers, if any
    */
-  abstract deserialize(topic: string, payload: Buffer): Promise<any>
+  async deserializeBatch(topic: string, payloads: Buffer[], headers?: WireHeader[]): Promise<any[]> {
+    const result: any[] = []
+    for (let i = 0; i < payloads.length; i++) {
+      result.push(await this.deserialize(topic, payloads[i], headers?.[i]))
+    }
+    return result
+  }
+
+  // groupBySchemaId returns the indexes of the payloads that are not null
+  // messages, grouped by schema ID. A payload with a parsed header may be
+  // empty, as the header was already removed.
+  groupBySchemaId(payloads: Buffer[], headers?: WireHeader[]): Map<number, number[]> {
+    const groups = new Map<number, number[]>()
+    for (let i = 0; i < payloads.length; i++) {
+      const payload = payloads[i]
+      if (!Buffer.isBuffer(payload)) {
+        throw new Error('Invalid buffer')
+      }
+      if (payload.length === 0 && headers?.[i]?.schemaId == null) {
+        continue
+      }
+      const id = headers?.[i]?.schemaId ?? this.getSchemaId(payload)
+      let indexes = groups.get(id)
+      if (indexes == null) {
+        indexes = []
+        groups.set(id, indexes)
+      }
+      indexes.push(i)
+    }
+    return groups
+  }
 
   async getSchema(topic: string, payload: Buffer, format?: string): Promise<SchemaInfo> {
+    return await this.getSchemaById(topic, this.getSchemaId(payload), format)
+  }
+
+  async getSchemaById(topic: string, id: number, format?: string): Promise<SchemaInfo> {
+    let subject = this.subjectName(topic)
+    return await this.client.getBySubjectAndId(subject, id, format)
+  }
+
+  // splitPayload returns the schema ID and the message bytes of the given
+  // payload, parsing its header unless it was already parsed
+  splitPayload(payload: Buffer, header?: WireHeader): [number, Buffer] {
+    if (header?.schemaId != null) {
+      return [header.schemaId, payload]
+    }
+    return [this.getSchemaId(payload), payload.subarray(HEADER_SIZE)]
+  }
+
+  // getSchemaId returns the schema ID of the given payload, checking its magic byte
+  getSchemaId(payload: Buffer): number {
     const magicByte = payload.subarray(0, 1)
     if (!magicByte.equals(MAGIC_BYTE)) {
       throw new SerializationError(
@@ -321,9 +545,7 @@ export abstract class Deserializer extends Serde {
         )}`,
       )
     }
-    const id = payload.subarray(1, 5).readInt32BE(0)
-    let subject = this.subjectName(topic)
-    return await this.client.getBySubjectAndId(subject, id, format)
+    return payload.subarray(1, 5).readInt32BE(0)
   }
 
   async getReaderSchema(subject: string, format?: string): Promise<SchemaMetadata | null> {
@@ -338,38 +560,6 @@ export abstract class Deserializer extends Serde {
     return null
   }
 
-  hasRules(ruleSet: RuleSet, mode: RuleMode): boolean {
-    switch (mode) {
-      case RuleMode.UPGRADE:
-      case RuleMode.DOWNGRADE:
-        return this.checkRules(ruleSet?.migrationRules, (ruleMode: RuleMode): boolean =>
-          ruleMode === mode || ruleMode === RuleMode.UPDOWN)
-      case RuleMode.UPDOWN:
-        return this.checkRules(ruleSet?.migrationRules, (ruleMode: RuleMode): boolean =>
-          ruleMode === mode)
-      case RuleMode.WRITE:
-      case RuleMode.READ:
-        return this.checkRules(ruleSet?.domainRules, (ruleMode: RuleMode): boolean =>
-          ruleMode === mode || ruleMode === RuleMode.WRITEREAD)
-      case RuleMode.WRITEREAD:
-        return this.checkRules(ruleSet?.domainRules, (ruleMode: RuleMode): boolean =>
-          ruleMode === mode)
-    }
-  }
-
-  checkRules(rules: Rule[] | undefined, filter: (ruleMode: RuleMode) => boolean): boolean {
-    if (rules == null) {
-      return false
-    }
-    for (let rule of rules) {
-      let ruleMode = rule.mode
-      if (ruleMode && filter(ruleMode)) {
-        return true
-      }
-    }
-    return false
-  }
-
   async getMigrations(subject: string, sourceInfo: SchemaInfo,
                 target: SchemaMetadata, format?: string): Promise<Migration[]> {
     let version = await this.client.getVersion(subject, sourceInfo, false, true)
@@ -436,13 +626,12 @@ export abstract class Deserializer extends Serde {
     }
     let version1 = first.version!
     let version2 = last.version!
-    let result = [first]
+    // The versions in between are fetched concurrently
+    let between: Promise<SchemaMetadata>[] = []
     for (let i = version1 + 1; i < version2; i++) {
-      let meta = await this.client.getSchemaMetadata(subject, i, true, format)
-      result.push(meta)
+      between.push(this.client.getSchemaMetadata(subject, i, true, format))
     }
-    result.push(last)
-    return result
+    return [first, ...await Promise.all(between), last]
   }
 
   async executeMigrations(migrations: Migration[], subject: string, topic: string, msg: any): Promise<any> {
@@ -561,8 +750,19 @@ export class RuleContext {
     return fieldContext
   }
 
+  // getTags returns the tags that the metadata of the target schema gives the
+  // field with the given full name. The result is shared, do not modify it.
   getTags(fullName: string): Set<string> {
-    let tags = new Set<string>()
+    let cache = fieldTagsCache.get(this.target)
+    if (cache == null) {
+      cache = new Map<string, Set<string>>()
+      fieldTagsCache.set(this.target, cache)
+    }
+    let tags = cache.get(fullName)
+    if (tags != null) {
+      return tags
+    }
+    tags = new Set<string>()
     let metadata = this.target.metadata
     if (metadata?.tags != null) {
       for (let [k, v] of Object.entries(metadata.tags)) {
@@ -573,15 +773,83 @@ export class RuleContext {
         }
       }
     }
+    cache.set(fullName, tags)
     return tags
   }
 
   leaveField(): void {
-    let size = this.fieldContexts.length - 1
-    this.fieldContexts = this.fieldContexts.slice(0, size)
+    this.fieldContexts.pop()
+  }
+
+  /**
+   * fieldRulePlan returns the plan of the rule for the target schema and
+   * inline tags, compiling it on first use
+   * @param compile - lists the fields on the paths to the fields with the rule tags
+   */
+  fieldRulePlan(compile: (ruleTags: Set<string>) => Set<string> | null): FieldRulePlan {
+    let plansByTags = fieldRulePlanCache.get(this.target)
+    if (plansByTags == null) {
+      plansByTags = new WeakMap<object, WeakMap<Rule, FieldRulePlan>>()
+      fieldRulePlanCache.set(this.target, plansByTags)
+    }
+    // Inline tags can come from a writer schema other than the target, so
+    // the same target can have different plans
+    const tagsKey = this.inlineTags ?? noInlineTags
+    let plans = plansByTags.get(tagsKey)
+    if (plans == null) {
+      plans = new WeakMap<Rule, FieldRulePlan>()
+      plansByTags.set(tagsKey, plans)
+    }
+    let plan = plans.get(this.rule)
+    if (plan == null) {
+      const ruleTags = new Set<string>(this.rule.tags ?? [])
+      // Conditions are evaluated on every field, and rules without tags
+      // apply to every field
+      const fields = this.rule.kind === 'TRANSFORM' && ruleTags.size > 0 ? compile(ruleTags) : null
+      plan = { ruleTags, fields }
+      plans.set(this.rule, plan)
+    }
+    return plan
+  }
+
+  /**
+   * appliesTo returns whether the rule applies to the current field
+   * @param plan - the plan of the rule
+   */
+  appliesTo(plan: FieldRulePlan): boolean {
+    const fieldCtx = this.currentField()
+    if (fieldCtx == null) {
+      return false
+    }
+    if (plan.ruleTags.size === 0) {
+      return true
+    }
+    for (const tag of plan.ruleTags) {
+      if (fieldCtx.tags.has(tag)) {
+        return true
+      }
+    }
+    return false
   }
 }
 
+/**
+ * FieldRulePlan is what a field rule needs to know about a schema to walk
+ * only the parts of a message that it can apply to
+ */
+export interface FieldRulePlan {
+  // tags of the rule
+  ruleTags: Set<string>
+  // full names of the fields that carry the rule tags or lead to fields that
+  // do, or null if every field has to be visited
+  fields: Set<string> | null
+}
+
+const fieldTagsCache = new WeakMap<SchemaInfo, Map<string, Set<string>>>()
+// plans keyed by target schema, inline tags and rule
+const fieldRulePlanCache = new WeakMap<SchemaInfo, WeakMap<object, WeakMap<Rule, FieldRulePlan>>>()
+const noInlineTags = {}
+
 export interface RuleBase {
   configure(clientConfig: ClientConfig, config: Map<string, string>): void
 
@@ -753,6 +1021,9 @@ export class NoneAction implements RuleAction {
   }
 }
 
+const errorAction = new ErrorAction()
+const noneAction = new NoneAction()
+
 /**
  * RuleError represents a rule error
  */
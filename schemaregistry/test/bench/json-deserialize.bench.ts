@@ -0,0 +1,91 @@
+/*
+ * Measures validated JSON deserialization of 1 KB to 1 MB payloads:
+ * decoding and parsing the payload twice, once to validate it and once for
+ * the returned message, as JsonDeserializer did before, against parsing it
+ * once and validating the result, and the whole deserializer.
+ *
+ *   ../node_modules/.bin/ts-node test/bench/json-deserialize.bench.ts [totalMB]
+ */
+import { JsonDeserializer, JsonSerializer } from '../../serde/json';
+import { SerdeType } from '../../serde/serde';
+import { SchemaRegistryClient } from '../../schemaregistry-client';
+
+const totalBytes = (parseInt(process.argv[2], 10) || 64) * 1024 * 1024;
+const sizes = [1024, 16 * 1024, 256 * 1024, 1024 * 1024];
+const topic = 'bench';
+
+const schema = JSON.stringify({
+  type: 'object',
+  properties: {
+    items: {
+      type: 'array',
+      items: {
+        type: 'object',
+        properties: {
+          id: { type: 'integer' },
+          name: { type: 'string' },
+          price: { type: 'number' },
+          tags: { type: 'array', items: { type: 'string' } },
+        },
+        required: ['id', 'name'],
+      },
+    },
+  },
+  required: ['items'],
+});
+
+// Builds a message whose JSON encoding is about the given size.
+function newMessage(size: number): any {
+  const items = [];
+  let length = 0;
+  for (let i = 0; length < size; i++) {
+    const item = { id: i, name: 'item-' + i, price: i * 1.5, tags: ['a', 'b', 'c'] };
+    items.push(item);
+    length += JSON.stringify(item).length + 1;
+  }
+  return { items };
+}
+
+async function run(label: string, size: number, deserialize: () => Promise<unknown>): Promise<void> {
+  const iterations = Math.max(10, Math.floor(totalBytes / size));
+  for (let i = 0; i < Math.min(iterations, 100); i++) {
+    await deserialize();
+  }
+  const start = process.hrtime.bigint();
+  for (let i = 0; i < iterations; i++) {
+    await deserialize();
+  }
+  const seconds = Number(process.hrtime.bigint() - start) / 1e9;
+  console.log('%s, %d KB: %d msgs/s, %d MB/s', label, size / 1024,
+    Math.round(iterations / seconds), Math.round(iterations * size / seconds / 1024 / 1024));
+}
+
+async function main(): Promise<void> {
+  const client = SchemaRegistryClient.newClient({ baseURLs: ['mock://'] });
+  await client.register(topic + '-value', { schemaType: 'JSON', schema }, false);
+  const ser = new JsonSerializer(client, SerdeType.VALUE, { useLatestVersion: true });
+  const deser = new JsonDeserializer(client, SerdeType.VALUE, { validate: true });
+
+  for (const size of sizes) {
+    const payload = await ser.serialize(topic, newMessage(size));
+    const info = await client.getBySubjectAndId(topic + '-value', payload.readInt32BE(1));
+    const validate = (await deser.toValidateFunction(info))!;
+
+    await run('parse twice', size, async () => {
+      if (!validate(JSON.parse(payload.subarray(5).toString()))) {
+        throw new Error('Invalid message');
+      }
+      return JSON.parse(payload.subarray(5).toString());
+    });
+    await run('parse once', size, async () => {
+      const msg = JSON.parse(payload.subarray(5).toString());
+      if (!validate(msg)) {
+        throw new Error('Invalid message');
+      }
+      return msg;
+    });
+    await run('JsonDeserializer.deserialize', size, () => deser.deserialize(topic, payload));
+  }
+}
+
+main();
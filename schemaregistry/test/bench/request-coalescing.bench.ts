@@ -0,0 +1,60 @@
+/*
+ * Measures how many HTTP requests SchemaRegistryClient sends, and how long
+ * it takes, when many concurrent lookups miss its caches at once, as on cold
+ * start or cache expiry. Runs against a local mock registry over HTTP which
+ * answers schema ID lookups after a fixed delay.
+ *
+ *   ../node_modules/.bin/ts-node test/bench/request-coalescing.bench.ts [lookups] [ids] [delayMs]
+ */
+import http from 'http';
+import { AddressInfo } from 'net';
+import { SchemaRegistryClient } from '../../schemaregistry-client';
+
+const lookups = parseInt(process.argv[2], 10) || 1000;
+const ids = parseInt(process.argv[3], 10) || 10;
+const delayMs = parseInt(process.argv[4], 10) || 20;
+
+const schema = JSON.stringify({
+  type: 'record',
+  name: 'User',
+  fields: [{ name: 'name', type: 'string' }],
+});
+
+let requests = 0;
+
+const server = http.createServer((req, res) => {
+  requests++;
+  const match = /^\/schemas\/ids\/(\d+)/.exec(req.url ?? '');
+  setTimeout(() => {
+    if (match == null) {
+      res.writeHead(404, { 'Content-Type': 'application/json' });
+      res.end(JSON.stringify({ error_code: 40401, message: 'Not found' }));
+      return;
+    }
+    res.writeHead(200, { 'Content-Type': 'application/vnd.schemaregistry.v1+json' });
+    res.end(JSON.stringify({ schemaType: 'AVRO', schema }));
+  }, delayMs);
+});
+
+async function run(client: SchemaRegistryClient, label: string): Promise<void> {
+  requests = 0;
+  const start = process.hrtime.bigint();
+  await Promise.all(Array.from({ length: lookups },
+    (_, i) => client.getBySubjectAndId('bench-value', i % ids)));
+  const elapsedMs = Number(process.hrtime.bigint() - start) / 1e6;
+  console.log('%s: %d lookups of %d IDs, %d HTTP requests, %s ms',
+    label, lookups, ids, requests, elapsedMs.toFixed(1));
+}
+
+server.listen(0, '127.0.0.1', async () => {
+  const port = (server.address() as AddressInfo).port;
+  const client = new SchemaRegistryClient({ baseURLs: [`http://127.0.0.1:${port}`] });
+  try {
+    await run(client, 'cold');
+    await run(client, 'warm');
+    client.clearCaches();
+    await run(client, 'after clearCaches');
+  } finally {
+    server.close();
+  }
+});
@@ -4,6 +4,8 @@ import MockAdapter from 'axios-mock-adapter';
 import { RestService } from '../rest-service';
 import * as retryHelper from '@confluentinc/schemaregistry/retry-helper';
 import { maxRetries, retriesWaitMs, retriesMaxWaitMs } from './test-constants';
+import http from 'http';
+import { AddressInfo } from 'net';
 
 describe('RestService Retry Policy', () => {
   let restService: RestService;
@@ -69,3 +71,81 @@ describe('RestService Retry Policy', () => {
     expect(retryHelper.isRetriable).toHaveBeenCalledWith(500);
   });
 });
+
+describe('RestService connection pooling', () => {
+  let server: http.Server;
+  let baseURL: string;
+  let restService: RestService;
+  let connections: number;
+  let inFlight: number;
+  let maxInFlight: number;
+
+  // The default adapter may be replaced by axios-mock-adapter above
+  const newRestService = (maxConnections?: number, maxConcurrentRequests?: number): RestService =>
+    new RestService([baseURL], false, { adapter: 'http' }, undefined, undefined,
+      0, retriesWaitMs, retriesMaxWaitMs, maxConnections, maxConcurrentRequests);
+
+  beforeEach(async () => {
+    connections = 0;
+    inFlight = 0;
+    maxInFlight = 0;
+    server = http.createServer((req, res) => {
+      inFlight++;
+      maxInFlight = Math.max(maxInFlight, inFlight);
+      setTimeout(() => {
+        inFlight--;
+        if (req.url === '/missing') {
+          res.writeHead(404, { 'Content-Type': 'application/json' });
+          res.end(JSON.stringify({ error_code: 40401, message: 'Not found' }));
+          return;
+        }
+        res.writeHead(200, { 'Content-Type': 'application/json' });
+        res.end(JSON.stringify({ url: req.url }));
+      }, 10);
+    });
+    server.on('connection', () => connections++);
+    await new Promise<void>(resolve => server.listen(0, '127.0.0.1', resolve));
+    baseURL = `http://127.0.0.1:${(server.address() as AddressInfo).port}`;
+  });
+
+  afterEach(async () => {
+    restService.close();
+    server.closeAllConnections();
+    await new Promise(resolve => server.close(resolve));
+  });
+
+  it('should reuse kept-alive connections', async () => {
+    restService = newRestService(2);
+    await Promise.all(Array.from({ length: 10 }, () => restService.handleRequest('/test', 'GET')));
+    for (let i = 0; i < 5; i++) {
+      await restService.handleRequest('/test', 'GET');
+    }
+    expect(connections).toBeLessThanOrEqual(2);
+  });
+
+  it('should limit concurrent requests', async () => {
+    restService = newRestService(undefined, 3);
+    const responses = await Promise.all(Array.from({ length: 10 },
+      (_, i) => restService.handleRequest<{ url: string }>(`/test/${i}`, 'GET')));
+    expect(responses.map(response => response.data.url)).toEqual(Array.from({ length: 10 }, (_, i) => `/test/${i}`));
+    expect(maxInFlight).toBeLessThanOrEqual(3);
+  });
+
+  it('should record latency per endpoint', async () => {
+    restService = newRestService();
+    await restService.handleRequest('/subjects/a/versions/1', 'GET');
+    await restService.handleRequest('/subjects/b/versions/2', 'GET');
+    await restService.handleRequest('/schemas/ids/3?subject=a', 'GET');
+    await expect(restService.handleRequest('/missing', 'GET')).rejects.toThrowError('Not found');
+
+    const metrics = restService.getMetrics();
+    expect(Array.from(metrics.keys()).sort()).toEqual(
+      ['GET /missing', 'GET /schemas/ids/{}', 'GET /subjects/{}/versions/{}']);
+    const versions = metrics.get('GET /subjects/{}/versions/{}')!;
+    expect(versions.count).toBe(2);
+    expect(versions.errors).toBe(0);
+    expect(versions.totalMs).toBeGreaterThanOrEqual(versions.maxMs);
+    expect(versions.maxMs).toBeGreaterThan(0);
+    expect(metrics.get('GET /missing')!.errors).toBe(1);
+  });
+});
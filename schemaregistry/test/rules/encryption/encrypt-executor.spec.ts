@@ -0,0 +1,148 @@
+import {describe, expect, it, jest} from '@jest/globals';
+import * as crypto from 'crypto';
+import {
+  Clock,
+  Cryptor,
+  DekFormat,
+  FieldEncryptionExecutor
+} from "../../../rules/encryption/encrypt-executor";
+import {LocalKmsDriver} from "../../../rules/encryption/localkms/local-driver";
+import {AvroSerializer} from "../../../serde/avro";
+import {SerdeType} from "../../../serde/serde";
+import {RuleRegistry} from "../../../serde/rule-registry";
+import {Rule, RuleMode, SchemaRegistryClient} from "../../../schemaregistry-client";
+
+LocalKmsDriver.register()
+
+const schema = `
+{
+  "name": "DemoSchema",
+  "type": "record",
+  "fields": [
+    {
+      "name": "stringField",
+      "type": "string",
+      "confluent:tags": [ "PII" ]
+    }
+  ]
+}
+`
+
+const encRule: Rule = {
+  name: 'test-encrypt',
+  kind: 'TRANSFORM',
+  mode: RuleMode.WRITEREAD,
+  type: 'ENCRYPT',
+  tags: ['PII'],
+  params: {
+    'encrypt.kek.name': 'kek1',
+    'encrypt.kms.type': 'local-kms',
+    'encrypt.kms.key.id': 'mykey',
+  },
+  onFailure: 'ERROR,NONE'
+}
+
+class FakeClock extends Clock {
+  fixedNow: number = 0
+
+  override now() {
+    return this.fixedNow
+  }
+}
+
+describe('Cryptor', () => {
+  for (const dekFormat of [DekFormat.AES128_GCM, DekFormat.AES256_GCM, DekFormat.AES256_SIV]) {
+    it(`encrypts and decrypts with ${dekFormat}`, async () => {
+      const cryptor = new Cryptor(dekFormat)
+      const dek = cryptor.generateKey()
+      const plaintexts = ['a', '', 'a longer value than the others'].map(v => Buffer.from(v))
+
+      for (const plaintext of plaintexts) {
+        expect(await cryptor.decrypt(dek, await cryptor.encrypt(dek, plaintext))).toEqual(plaintext)
+      }
+      expect(cryptor.getAead(dek)).toBe(new Cryptor(dekFormat).getAead(dek))
+    })
+  }
+
+  it('encrypts and decrypts with raw keys', async () => {
+    const cryptor = new Cryptor(DekFormat.AES256_GCM)
+    const plaintext = Buffer.from('secret')
+
+    const gcmKey = crypto.getRandomValues(new Uint8Array(32))
+    const gcmCiphertext = await cryptor.encryptWithAesGcm(gcmKey, plaintext)
+    expect(Buffer.from(await cryptor.decryptWithAesGcm(gcmKey, gcmCiphertext))).toEqual(plaintext)
+
+    const sivKey = crypto.getRandomValues(new Uint8Array(64))
+    const sivCiphertext = await cryptor.encryptWithAesSiv(sivKey, plaintext)
+    expect(Buffer.from(await cryptor.decryptWithAesSiv(sivKey, sivCiphertext))).toEqual(plaintext)
+    // AES-SIV is deterministic
+    expect(await cryptor.encryptWithAesSiv(sivKey, plaintext)).toEqual(sivCiphertext)
+  })
+
+  it('rejects tampered ciphertexts', async () => {
+    const cryptor = new Cryptor(DekFormat.AES256_GCM)
+    const dek = cryptor.generateKey()
+    const ciphertext = await cryptor.encrypt(dek, Buffer.from('secret'))
+    ciphertext[ciphertext.length - 1] ^= 1
+    await expect(cryptor.decrypt(dek, ciphertext)).rejects.toThrow()
+  })
+})
+
+describe('FieldEncryptionExecutor', () => {
+  // newSerializer returns a serializer encrypting with a new executor, for
+  // a new mock registry with the encryption rule on the given topics
+  async function newSerializer(clock: Clock, cacheCapacity: number, topics: string[]) {
+    const client = SchemaRegistryClient.newClient({ baseURLs: ['mock://'], cacheCapacity })
+    for (const topic of topics) {
+      await client.register(topic + '-value', {
+        schemaType: 'AVRO',
+        schema,
+        ruleSet: { domainRules: [encRule] }
+      }, false)
+    }
+    const executor = new FieldEncryptionExecutor(clock)
+    const registry = new RuleRegistry()
+    registry.registerExecutor(executor)
+    const ser = new AvroSerializer(client, SerdeType.VALUE, {
+      useLatestVersion: true,
+      ruleConfig: {
+        secret: 'mysecret',
+        'encrypt.cache.ttl.secs': '100'
+      }
+    }, registry)
+    return { ser, executor }
+  }
+
+  it('refreshes KEKs and DEKs from the registry', async () => {
+    const clock = new FakeClock()
+    const topic = 'executor-refresh'
+    const { ser, executor } = await newSerializer(clock, 1000, [topic])
+    await ser.serialize(topic, { stringField: 'hi' })
+
+    const getKek = jest.spyOn(executor.client!, 'getKek')
+    const getDek = jest.spyOn(executor.client!, 'getDek')
+    await ser.serialize(topic, { stringField: 'hi' })
+    expect(getKek).not.toHaveBeenCalled()
+    expect(getDek).not.toHaveBeenCalled()
+
+    // In the last tenth of the TTL, the keys are refreshed past the client's cache
+    clock.fixedNow = 95 * 1000
+    await ser.serialize(topic, { stringField: 'hi' })
+    expect(getKek).toHaveBeenCalledWith('kek1', false, true)
+    expect(getDek).toHaveBeenCalledWith('kek1', topic + '-value', DekFormat.AES256_GCM, 1, false, true)
+  })
+
+  it('keeps at most the client cache capacity of keys', async () => {
+    const clock = new FakeClock()
+    const topics = ['executor-bound-1', 'executor-bound-2']
+    const { ser, executor } = await newSerializer(clock, 1, topics)
+    for (const topic of topics) {
+      await ser.serialize(topic, { stringField: 'hi' })
+    }
+
+    // The DEK of the first subject was evicted by the one of the second
+    const getDek = jest.spyOn(executor.client!, 'getDek')
+    await ser.serialize(topics[0], { stringField: 'hi' })
+    expect(getDek).toHaveBeenCalledTimes(1)
+  })
+})
@@ -0,0 +1,94 @@
+import {beforeEach, describe, expect, it, jest} from '@jest/globals';
+import {KeyCache} from "../../../rules/encryption/key-cache";
+
+class FakeClock {
+  fixedNow: number = 1000
+
+  now() {
+    return this.fixedNow
+  }
+}
+
+describe('KeyCache', () => {
+  let clock: FakeClock
+  let cache: KeyCache<string>
+
+  beforeEach(() => {
+    clock = new FakeClock()
+    cache = new KeyCache<string>(clock, 100, 10, 5)
+  })
+
+  it('shares concurrent loads', async () => {
+    const load = jest.fn(async () => 'dek')
+    const values = await Promise.all([cache.get('k', load), cache.get('k', load), cache.get('k', load)])
+    expect(values).toEqual(['dek', 'dek', 'dek'])
+    expect(load).toHaveBeenCalledTimes(1)
+  })
+
+  it('refreshes in the background before the value expires', async () => {
+    let version = 1
+    const load = jest.fn(async () => 'dek' + version)
+    expect(await cache.get('k', load)).toEqual('dek1')
+
+    clock.fixedNow += 95
+    version = 2
+    // The cached value is returned while the refresh is in flight
+    expect(await cache.get('k', load)).toEqual('dek1')
+    expect(load).toHaveBeenCalledTimes(2)
+    await new Promise(resolve => setImmediate(resolve))
+    expect(await cache.get('k', load)).toEqual('dek2')
+    expect(load).toHaveBeenCalledTimes(2)
+  })
+
+  it('waits for the refresh once the value is too old', async () => {
+    let version = 1
+    const load = async () => 'dek' + version
+    await cache.get('k', load)
+    clock.fixedNow += 200
+    version = 2
+    expect(await cache.get('k', load)).toEqual('dek2')
+  })
+
+  it('caches missing keys for the negative TTL', async () => {
+    const load = jest.fn(async (): Promise<string | null> => null)
+    expect(await cache.get('k', load)).toBeNull()
+    expect(await cache.get('k', load)).toBeNull()
+    expect(load).toHaveBeenCalledTimes(1)
+
+    clock.fixedNow += 5
+    expect(await cache.get('k', load)).toBeNull()
+    expect(load).toHaveBeenCalledTimes(2)
+
+    cache.set('k', 'dek')
+    expect(await cache.get('k', load)).toEqual('dek')
+  })
+
+  it('does not cache failed loads', async () => {
+    const load = jest.fn(async () => 'dek')
+    load.mockRejectedValueOnce(new Error('unavailable'))
+    await expect(cache.get('k', load)).rejects.toThrow('unavailable')
+    expect(await cache.get('k', load)).toEqual('dek')
+
+    // A failed refresh keeps the cached value
+    clock.fixedNow += 95
+    load.mockRejectedValueOnce(new Error('unavailable'))
+    expect(await cache.get('k', load)).toEqual('dek')
+    await new Promise(resolve => setImmediate(resolve))
+    expect(await cache.get('k', load)).toEqual('dek')
+  })
+
+  it('evicts the least recently used keys', async () => {
+    cache = new KeyCache<string>(clock, 100, 10, 5, 2)
+    const load = jest.fn(async () => 'dek')
+    await cache.get('k1', load)
+    await cache.get('k2', load)
+    await cache.get('k1', load)
+    await cache.get('k3', load)
+    expect(load).toHaveBeenCalledTimes(3)
+
+    await cache.get('k1', load)
+    expect(load).toHaveBeenCalledTimes(3)
+    await cache.get('k2', load)
+    expect(load).toHaveBeenCalledTimes(4)
+  })
+})
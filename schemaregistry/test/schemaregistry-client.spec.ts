@@ -1,5 +1,6 @@
 import {
   SchemaRegistryClient,
+  schemaFingerprint,
   Metadata,
   Compatibility,
   SchemaInfo,
@@ -269,6 +270,83 @@ describe('SchemaRegistryClient-Get-ID', () => {
     expect(cachedResponse2).toMatchObject(expectedResponse2);
     expect(restService.handleRequest).toHaveBeenCalledTimes(2);
   });
+
+  it('Should return id from cache when GetId is called with an equal schema', async () => {
+    restService.handleRequest.mockResolvedValue({ data: { id: 1 } } as AxiosResponse);
+
+    expect(await client.getId(mockSubject, schemaInfo)).toEqual(1);
+    expect(await client.getId(mockSubject, { ...schemaInfo })).toEqual(1);
+    expect(restService.handleRequest).toHaveBeenCalledTimes(1);
+
+    restService.handleRequest.mockResolvedValue({ data: { id: 2 } } as AxiosResponse);
+    expect(await client.getId(mockSubject, schemaInfoMetadata)).toEqual(2);
+    expect(restService.handleRequest).toHaveBeenCalledTimes(2);
+  });
+
+  it('Should fingerprint the minimized schema', () => {
+    const schemaMetadata: SchemaMetadata = { ...schemaInfo, id: 1, version: 2 };
+
+    expect(schemaFingerprint(schemaInfo)).toEqual(schemaFingerprint({ ...schemaInfo }));
+    expect(schemaFingerprint(schemaMetadata)).toEqual(schemaFingerprint(schemaInfo));
+    expect(schemaFingerprint(schemaInfoMetadata)).not.toEqual(schemaFingerprint(schemaInfo));
+    expect(schemaFingerprint(schemaInfoMetadata)).not.toEqual(schemaFingerprint(schemaInfoMetadata2));
+    expect(schemaFingerprint({ ...schemaInfo, schemaType: 'JSON' })).not.toEqual(schemaFingerprint(schemaInfo));
+  });
+
+  it('Should look up a schema again after it is modified', async () => {
+    const info: SchemaInfo = { ...schemaInfo };
+    restService.handleRequest.mockResolvedValue({ data: { id: 1 } } as AxiosResponse);
+    expect(await client.getId(mockSubject, info)).toEqual(1);
+
+    info.references = [{ name: 'ref', subject: mockSubject2, version: 1 }];
+    restService.handleRequest.mockResolvedValue({ data: { id: 2 } } as AxiosResponse);
+    expect(await client.getId(mockSubject, info)).toEqual(2);
+
+    info.schema = schemaString2;
+    restService.handleRequest.mockResolvedValue({ data: { id: 3 } } as AxiosResponse);
+    expect(await client.getId(mockSubject, info)).toEqual(3);
+    expect(await client.getId(mockSubject, info)).toEqual(3);
+    expect(restService.handleRequest).toHaveBeenCalledTimes(3);
+  });
+
+  it('Should share one request between concurrent GetBySubjectAndId calls', async () => {
+    const expectedResponse = {
+      id: 1,
+      version: 1,
+      schema: schemaString,
+      metadata: metadata,
+    };
+
+    restService.handleRequest.mockImplementation(async () => {
+      await sleep(10);
+      return { data: expectedResponse } as AxiosResponse;
+    });
+
+    const responses: SchemaInfo[] = await Promise.all([
+      ...Array.from({ length: 10 }, () => client.getBySubjectAndId(mockSubject, 1)),
+      client.getBySubjectAndId(mockSubject2, 1),
+    ]);
+    responses.forEach(response => expect(response).toMatchObject(expectedResponse));
+    expect(restService.handleRequest).toHaveBeenCalledTimes(2);
+  });
+
+  it('Should not cache a failed request shared by concurrent GetId calls', async () => {
+    restService.handleRequest.mockImplementationOnce(async () => {
+      await sleep(10);
+      throw new Error('unavailable');
+    });
+
+    const results = await Promise.allSettled([
+      client.getId(mockSubject, schemaInfo),
+      client.getId(mockSubject, schemaInfo),
+    ]);
+    expect(results.map(result => result.status)).toEqual(['rejected', 'rejected']);
+    expect(restService.handleRequest).toHaveBeenCalledTimes(1);
+
+    restService.handleRequest.mockResolvedValue({ data: { id: 1 } } as AxiosResponse);
+    expect(await client.getId(mockSubject, schemaInfo)).toEqual(1);
+    expect(restService.handleRequest).toHaveBeenCalledTimes(2);
+  });
 });
 
 describe('SchemaRegistryClient-Get-Schema-Metadata', () => {
@@ -505,6 +583,47 @@ describe('SchemaRegistryClient-Subjects', () => {
     expect(response).toEqual([1]);
     expect(restService.handleRequest).toHaveBeenCalledTimes(1);
   });
+
+  it('Should not cache a schema fetched while its subject is deleted', async () => {
+    const expectedResponse = {
+      id: 1,
+      version: 1,
+      schema: schemaString,
+      metadata: metadata,
+    };
+
+    restService.handleRequest.mockImplementation(async (url: string, method: string) => {
+      if (method === 'DELETE') {
+        return { data: [1] } as AxiosResponse;
+      }
+      await sleep(10);
+      return { data: expectedResponse } as AxiosResponse;
+    });
+
+    const before = client.getBySubjectAndId(mockSubject, 1);
+    await client.deleteSubject(mockSubject);
+    // Does not join the request started before the delete
+    const after = client.getBySubjectAndId(mockSubject, 1);
+    expect(restService.handleRequest).toHaveBeenCalledTimes(3);
+
+    expect(await before).toMatchObject(expectedResponse);
+    expect(await client.getIdToSchemaInfoCacheSize()).toEqual(0);
+
+    expect(await after).toMatchObject(expectedResponse);
+    expect(await client.getIdToSchemaInfoCacheSize()).toEqual(1);
+  });
+
+  it('Should not cache a version fetched while the caches are cleared', async () => {
+    restService.handleRequest.mockImplementation(async () => {
+      await sleep(10);
+      return { data: { version: 1 } } as AxiosResponse;
+    });
+
+    const before = client.getVersion(mockSubject, schemaInfo);
+    client.clearCaches();
+    expect(await before).toEqual(1);
+    expect(await client.getSchemaToVersionCacheSize()).toEqual(0);
+  });
 });
 
 describe('SchemaRegistryClient-Compatibility', () => {
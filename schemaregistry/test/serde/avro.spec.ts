@@ -1,4 +1,4 @@
-import {afterEach, describe, expect, it} from '@jest/globals';
+import {afterEach, describe, expect, it, jest} from '@jest/globals';
 import {ClientConfig} from "../../rest-service";
 import {
   AvroDeserializer,
@@ -215,6 +215,24 @@ const schemaEvolution2 = `
   ]
 }
 `
+const schemaEvolution3 = `
+{
+  "name": "SchemaEvolution",
+  "type": "record",
+  "fields": [
+    {
+      "name": "newOptionalField",
+      "type": ["string", "null"],
+      "default": "optional"
+    },
+    {
+      "name": "otherOptionalField",
+      "type": ["string", "null"],
+      "default": "other"
+    }
+  ]
+}
+`
 const complexSchema = `
 {
   "name": "ComplexSchema",
@@ -301,6 +319,69 @@ describe('AvroSerializer', () => {
     expect(obj2.boolField).toEqual(obj.boolField);
     expect(obj2.bytesField).toEqual(obj.bytesField);
   })
+  it('serialize large message', async () => {
+    let conf: ClientConfig = {
+      baseURLs: [baseURL],
+      cacheCapacity: 1000
+    }
+    let client = SchemaRegistryClient.newClient(conf)
+    let ser = new AvroSerializer(client, SerdeType.VALUE, {autoRegisterSchemas: true})
+    let small = {
+      intField: 1,
+      bytesField: Buffer.from([1, 2]),
+    }
+    let large = {
+      intField: 2,
+      bytesField: Buffer.alloc(100000, 7),
+    }
+    let bytes = await ser.serialize(topic, small)
+    let largeBytes = await ser.serialize(topic, large)
+    let smallBytes = await ser.serialize(topic, small)
+    expect(smallBytes).toEqual(bytes)
+    expect(largeBytes.readInt32BE(1)).toEqual(bytes.readInt32BE(1))
+
+    let deser = new AvroDeserializer(client, SerdeType.VALUE, {})
+    expect(await deser.deserialize(topic, largeBytes)).toEqual(large)
+    expect(await deser.deserialize(topic, smallBytes)).toEqual(small)
+  })
+  it('serialize batch', async () => {
+    let conf: ClientConfig = {
+      baseURLs: [baseURL],
+      cacheCapacity: 1000
+    }
+    let client = SchemaRegistryClient.newClient(conf)
+    let ser = new AvroSerializer(client, SerdeType.VALUE, {autoRegisterSchemas: true})
+    let objs = [1, 2, 3].map(i => ({
+      intField: i,
+      stringField: 'hi ' + i,
+      boolField: i % 2 === 0,
+    }))
+    let bytes = await ser.serializeBatch(topic, objs)
+    expect(bytes[2]).toEqual(await ser.serialize(topic, objs[2]))
+
+    let deser = new AvroDeserializer(client, SerdeType.VALUE, {})
+    let objs2 = await deser.deserializeBatch(topic, [Buffer.alloc(0), ...bytes])
+    expect(objs2).toEqual([null, ...objs])
+  })
+  it('deserialize with a parsed header', async () => {
+    let conf: ClientConfig = {
+      baseURLs: [baseURL],
+      cacheCapacity: 1000
+    }
+    let client = SchemaRegistryClient.newClient(conf)
+    let ser = new AvroSerializer(client, SerdeType.VALUE, {autoRegisterSchemas: true})
+    let obj = {
+      intField: 123,
+      stringField: 'hi',
+    }
+    let bytes = await ser.serialize(topic, obj)
+    let header = { schemaId: bytes.readInt32BE(1) }
+
+    let deser = new AvroDeserializer(client, SerdeType.VALUE, {})
+    expect(await deser.deserialize(topic, bytes.subarray(5), header)).toEqual(obj)
+    expect(await deser.deserializeBatch(topic, [bytes.subarray(5), bytes], [header, {}]))
+      .toEqual([obj, obj])
+  })
   it('serialize nested', async () => {
     let conf: ClientConfig = {
       baseURLs: [baseURL],
@@ -407,6 +488,75 @@ describe('AvroSerializer', () => {
     expect(obj2.fieldToDelete).toEqual(undefined);
     expect(obj2.newOptionalField).toEqual("optional");
   })
+  it('schema evolution reuses the deserialization plan', async () => {
+    let conf: ClientConfig = {
+      baseURLs: [baseURL],
+      cacheCapacity: 1000
+    }
+    let client = SchemaRegistryClient.newClient(conf)
+    let ser = new AvroSerializer(client, SerdeType.VALUE, {useLatestVersion: true})
+
+    let info: SchemaInfo = {
+      schemaType: 'AVRO',
+      schema: schemaEvolution1,
+    }
+    await client.register(subject, info, false)
+    let bytes = await ser.serialize(topic, { fieldToDelete: "bye" })
+
+    info = {
+      schemaType: 'AVRO',
+      schema: schemaEvolution2,
+    }
+    await client.register(subject, info, false)
+    client.clearLatestCaches()
+
+    let deser = new AvroDeserializer(client, SerdeType.VALUE, {useLatestVersion: true})
+    let obj2 = await deser.deserialize(topic, bytes)
+    expect(obj2.newOptionalField).toEqual("optional");
+
+    let getSchema = jest.spyOn(client, 'getBySubjectAndId')
+    let getMigrations = jest.spyOn(deser, 'getMigrations')
+    let obj3 = await deser.deserialize(topic, bytes)
+    expect(obj3).toEqual(obj2);
+    expect(getSchema).not.toHaveBeenCalled();
+    expect(getMigrations).not.toHaveBeenCalled();
+  })
+  it('schema evolution picks up a new latest version', async () => {
+    let conf: ClientConfig = {
+      baseURLs: [baseURL],
+      cacheCapacity: 1000
+    }
+    let client = SchemaRegistryClient.newClient(conf)
+    let ser = new AvroSerializer(client, SerdeType.VALUE, {useLatestVersion: true})
+
+    let info: SchemaInfo = {
+      schemaType: 'AVRO',
+      schema: schemaEvolution1,
+    }
+    await client.register(subject, info, false)
+    let bytes = await ser.serialize(topic, { fieldToDelete: "bye" })
+
+    info = {
+      schemaType: 'AVRO',
+      schema: schemaEvolution2,
+    }
+    await client.register(subject, info, false)
+    client.clearLatestCaches()
+
+    let deser = new AvroDeserializer(client, SerdeType.VALUE, {useLatestVersion: true})
+    let obj2 = await deser.deserialize(topic, bytes)
+    expect(obj2).toEqual({ newOptionalField: "optional" });
+
+    info = {
+      schemaType: 'AVRO',
+      schema: schemaEvolution3,
+    }
+    await client.register(subject, info, false)
+    client.clearLatestCaches()
+
+    let obj3 = await deser.deserialize(topic, bytes)
+    expect(obj3).toEqual({ newOptionalField: "optional", otherOptionalField: "other" });
+  })
   it('basic encryption', async () => {
     let conf: ClientConfig = {
       baseURLs: [baseURL],
@@ -482,6 +632,190 @@ describe('AvroSerializer', () => {
     expect(obj2.stringField).not.toEqual(obj.stringField);
     expect(obj2.bytesField).not.toEqual(obj.bytesField);
   })
+  it('encryption only visits tagged fields', async () => {
+    let conf: ClientConfig = {
+      baseURLs: [baseURL],
+      cacheCapacity: 1000
+    }
+    let client = SchemaRegistryClient.newClient(conf)
+    let serConfig: AvroSerializerConfig = {
+      useLatestVersion: true,
+      ruleConfig: {
+        secret: 'mysecret'
+      }
+    }
+    let ser = new AvroSerializer(client, SerdeType.VALUE, serConfig)
+    let dekClient = fieldEncryptionExecutor.client!
+
+    let encRule: Rule = {
+      name: 'test-encrypt',
+      kind: 'TRANSFORM',
+      mode: RuleMode.WRITEREAD,
+      type: 'ENCRYPT',
+      tags: ['PII'],
+      params: {
+        'encrypt.kek.name': 'kek1',
+        'encrypt.kms.type': 'local-kms',
+        'encrypt.kms.key.id': 'mykey',
+      },
+      onFailure: 'ERROR,NONE'
+    }
+    let otherRule: Rule = {
+      ...encRule,
+      name: 'test-encrypt-other',
+      tags: ['OTHER'],
+    }
+    let ruleSet: RuleSet = {
+      domainRules: [encRule, otherRule]
+    }
+
+    let info: SchemaInfo = {
+      schemaType: 'AVRO',
+      schema: demoSchema,
+      ruleSet
+    }
+
+    await client.register(subject, info, false)
+
+    let newObj = () => ({
+      intField: 123,
+      doubleField: 45.67,
+      stringField: 'hi',
+      boolField: true,
+      bytesField: Buffer.from([1, 2]),
+    })
+    // Both tagged fields share one DEK lookup, and no field has the other tag
+    let getDek = jest.spyOn(dekClient, 'getDek')
+    await ser.serialize(topic, newObj())
+    expect(getDek).toHaveBeenCalledTimes(1)
+
+    // The DEK is cached by the executor
+    let bytes = await ser.serialize(topic, newObj())
+    expect(getDek).toHaveBeenCalledTimes(1)
+
+    let deserConfig: AvroDeserializerConfig = {
+      ruleConfig: {
+        secret: 'mysecret'
+      }
+    }
+    let deser = new AvroDeserializer(client, SerdeType.VALUE, deserConfig)
+    fieldEncryptionExecutor.client = dekClient
+    expect(await deser.deserialize(topic, bytes)).toEqual(newObj())
+    getDek.mockRestore()
+  })
+  it('encryption follows the tags of each writer schema', async () => {
+    let conf: ClientConfig = {
+      baseURLs: [baseURL],
+      cacheCapacity: 1000
+    }
+    let client = SchemaRegistryClient.newClient(conf)
+    let serConfig: AvroSerializerConfig = {
+      useLatestVersion: true,
+      ruleConfig: {
+        secret: 'mysecret'
+      }
+    }
+    let ser = new AvroSerializer(client, SerdeType.VALUE, serConfig)
+    let dekClient = fieldEncryptionExecutor.client!
+
+    let encRule: Rule = {
+      name: 'test-encrypt',
+      kind: 'TRANSFORM',
+      mode: RuleMode.WRITEREAD,
+      type: 'ENCRYPT',
+      tags: ['PII'],
+      params: {
+        'encrypt.kek.name': 'kek1',
+        'encrypt.kms.type': 'local-kms',
+        'encrypt.kms.key.id': 'mykey',
+      },
+      onFailure: 'ERROR,NONE'
+    }
+    let ruleSet: RuleSet = {
+      domainRules: [encRule]
+    }
+
+    let newObj = () => ({
+      intField: 123,
+      doubleField: 45.67,
+      stringField: 'hi',
+      boolField: true,
+      bytesField: Buffer.from([1, 2]),
+    })
+
+    // The first writer tags one field, the second one both
+    await client.register(subject, { schemaType: 'AVRO', schema: demoSchemaSingleTag, ruleSet }, false)
+    let bytes1 = await ser.serialize(topic, newObj())
+    await client.register(subject, { schemaType: 'AVRO', schema: demoSchema, ruleSet }, false)
+    client.clearLatestCaches()
+    let bytes2 = await ser.serialize(topic, newObj())
+
+    // Both are read into the latest schema, with the tags of their writer
+    let deserConfig: AvroDeserializerConfig = {
+      useLatestVersion: true,
+      ruleConfig: {
+        secret: 'mysecret'
+      }
+    }
+    let deser = new AvroDeserializer(client, SerdeType.VALUE, deserConfig)
+    fieldEncryptionExecutor.client = dekClient
+    expect(await deser.deserialize(topic, bytes1)).toEqual(newObj())
+    expect(await deser.deserialize(topic, bytes2)).toEqual(newObj())
+  })
+  it('rule plans are compiled once per schema', async () => {
+    let conf: ClientConfig = {
+      baseURLs: [baseURL],
+      cacheCapacity: 1000
+    }
+    let client = SchemaRegistryClient.newClient(conf)
+    let transform = jest.fn(async (ctx: any, msg: any) => ({ ...msg, stringField: msg.stringField + '!' }))
+    let registry = new RuleRegistry()
+    registry.registerExecutor({
+      configure: () => {},
+      type: () => 'APPEND',
+      close: () => {},
+      transform,
+    })
+    let ser = new AvroSerializer(client, SerdeType.VALUE, { useLatestVersion: true }, registry)
+    let getExecutor = jest.spyOn(registry, 'getExecutor')
+
+    let appendRule: Rule = {
+      name: 'test-append',
+      kind: 'TRANSFORM',
+      mode: RuleMode.WRITE,
+      type: 'APPEND',
+    }
+    let disabledRule: Rule = {
+      ...appendRule,
+      name: 'test-append-disabled',
+      disabled: true,
+    }
+    let info: SchemaInfo = {
+      schemaType: 'AVRO',
+      schema: demoSchema,
+      ruleSet: {
+        domainRules: [appendRule, disabledRule]
+      }
+    }
+    await client.register(subject, info, false)
+
+    let obj = {
+      intField: 123,
+      doubleField: 45.67,
+      stringField: 'hi',
+      boolField: true,
+      bytesField: Buffer.from([1, 2]),
+    }
+    await ser.serialize(topic, obj)
+    let bytes = await ser.serialize(topic, obj)
+    expect(transform).toHaveBeenCalledTimes(2)
+    expect(getExecutor).toHaveBeenCalledTimes(1)
+
+    let deser = new AvroDeserializer(client, SerdeType.VALUE, {}, registry)
+    let obj2 = await deser.deserialize(topic, bytes)
+    expect(obj2.stringField).toEqual('hi!')
+    expect(transform).toHaveBeenCalledTimes(2)
+  })
   it('basic encryption with logical type', async () => {
     let conf: ClientConfig = {
       baseURLs: [baseURL],
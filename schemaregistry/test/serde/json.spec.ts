@@ -1,4 +1,4 @@
-import {afterEach, describe, expect, it} from '@jest/globals';
+import {afterEach, describe, expect, it, jest} from '@jest/globals';
 import {ClientConfig} from "../../rest-service";
 import {SerdeType, SerializationError, Serializer} from "../../serde/serde";
 import {
@@ -179,6 +179,53 @@ describe('JsonSerializer', () => {
     let obj2 = await deser.deserialize(topic, bytes)
     expect(obj2).toEqual(obj)
   })
+  it('serialize batch', async () => {
+    let conf: ClientConfig = {
+      baseURLs: [baseURL],
+      cacheCapacity: 1000
+    }
+    let client = SchemaRegistryClient.newClient(conf)
+    let ser = new JsonSerializer(client, SerdeType.VALUE, {
+      autoRegisterSchemas: true,
+      validate: true
+    })
+    let objs = [
+      { intField: 1, stringField: 'a' },
+      { intField: 2, stringField: 'b' },
+      { boolField: true },
+    ]
+    let bytes = await ser.serializeBatch(topic, objs)
+    expect(bytes[0].readInt32BE(1)).toEqual(bytes[1].readInt32BE(1))
+
+    let deser = new JsonDeserializer(client, SerdeType.VALUE, { validate: true })
+    let objs2 = await deser.deserializeBatch(topic, [bytes[0], Buffer.alloc(0), bytes[1], bytes[2]])
+    expect(objs2).toEqual([objs[0], null, objs[1], objs[2]])
+  })
+  it('validates the deserialized message', async () => {
+    let conf: ClientConfig = {
+      baseURLs: [baseURL],
+      cacheCapacity: 1000
+    }
+    let client = SchemaRegistryClient.newClient(conf)
+    let ser = new JsonSerializer(client, SerdeType.VALUE, {
+      autoRegisterSchemas: true,
+      validate: true
+    })
+    let obj = { intField: 1, stringField: 'a' }
+    let bytes = await ser.serialize(topic, obj)
+
+    let deser = new JsonDeserializer(client, SerdeType.VALUE, { validate: true })
+    let validate = jest.fn((data: any) => true)
+    jest.spyOn(deser, 'toValidateFunction').mockResolvedValue(validate)
+    let obj2 = await deser.deserialize(topic, bytes)
+    expect(obj2).toEqual(obj)
+    // The payload is parsed once, and that message is validated
+    expect(validate).toHaveBeenCalledTimes(1)
+    expect(validate.mock.calls[0][0]).toBe(obj2)
+
+    validate.mockReturnValue(false)
+    await expect(deser.deserialize(topic, bytes)).rejects.toThrow(SerializationError)
+  })
   it('basic serialization 2020-12', async () => {
     let conf: ClientConfig = {
       baseURLs: [baseURL],
@@ -431,6 +478,75 @@ describe('JsonSerializer', () => {
     obj2 = await deser.deserialize(topic, bytes)
     expect(obj2).not.toEqual(obj);
   })
+  it('encryption only visits tagged fields', async () => {
+    let conf: ClientConfig = {
+      baseURLs: [baseURL],
+      cacheCapacity: 1000
+    }
+    let client = SchemaRegistryClient.newClient(conf)
+    let serConfig: JsonSerializerConfig = {
+      useLatestVersion: true,
+      ruleConfig: {
+        secret: 'mysecret'
+      }
+    }
+    let ser = new JsonSerializer(client, SerdeType.VALUE, serConfig)
+    let dekClient = fieldEncryptionExecutor.client!
+
+    let encRule: Rule = {
+      name: 'test-encrypt',
+      kind: 'TRANSFORM',
+      mode: RuleMode.WRITEREAD,
+      type: 'ENCRYPT',
+      tags: ['PII'],
+      params: {
+        'encrypt.kek.name': 'kek1',
+        'encrypt.kms.type': 'local-kms',
+        'encrypt.kms.key.id': 'mykey',
+      },
+      onFailure: 'ERROR,NONE'
+    }
+    let otherRule: Rule = {
+      ...encRule,
+      name: 'test-encrypt-other',
+      tags: ['OTHER'],
+    }
+    let ruleSet: RuleSet = {
+      domainRules: [encRule, otherRule]
+    }
+
+    let info: SchemaInfo = {
+      schemaType: 'JSON',
+      schema: demoSchema,
+      ruleSet
+    }
+
+    await client.register(subject, info, false)
+
+    let newObj = () => ({
+      intField: 123,
+      doubleField: 45.67,
+      stringField: 'hi',
+      boolField: true,
+      bytesField: Buffer.from([0, 0, 0, 1]).toString('base64')
+    })
+    await ser.serialize(topic, newObj())
+
+    // Both tagged fields share one DEK lookup, and no field has the other tag
+    let getDek = jest.spyOn(dekClient, 'getDek')
+    let bytes = await ser.serialize(topic, newObj())
+    expect(getDek).toHaveBeenCalledTimes(1)
+
+    let deserConfig: JsonDeserializerConfig = {
+      ruleConfig: {
+        secret: 'mysecret'
+      }
+    }
+    let deser = new JsonDeserializer(client, SerdeType.VALUE, deserConfig)
+    fieldEncryptionExecutor.client = dekClient
+    expect(await deser.deserialize(topic, bytes)).toEqual(newObj())
+    getDek.mockRestore()
+  })
   it('basic encryption 2020-12', async () => {
     let conf: ClientConfig = {
       baseURLs: [baseURL],
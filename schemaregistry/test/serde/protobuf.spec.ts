@@ -1,4 +1,4 @@
-import {afterEach, describe, expect, it} from '@jest/globals';
+import {afterEach, describe, expect, it, jest} from '@jest/globals';
 import {ClientConfig} from "../../rest-service";
 import {
   ProtobufDeserializer, ProtobufDeserializerConfig,
@@ -18,7 +18,9 @@ import {AuthorSchema, file_test_schemaregistry_serde_example, PizzaSchema} from
 import {create, toBinary} from "@bufbuild/protobuf";
 import {FileDescriptorProtoSchema} from "@bufbuild/protobuf/wkt";
 import {
-  NestedMessage_InnerMessageSchema
+  file_test_schemaregistry_serde_nested,
+  NestedMessage_InnerMessageSchema,
+  NestedMessageSchema
 } from "./test/nested_pb";
 import {TestMessageSchema} from "./test/test_pb";
 import {DependencyMessageSchema} from "./test/dep_pb";
@@ -83,6 +85,107 @@ describe('ProtobufSerializer', () => {
     let obj2 = await deser.deserialize(topic, bytes)
     expect(obj2).toEqual(obj)
   })
+  it('serialize batch', async () => {
+    let conf: ClientConfig = {
+      baseURLs: [baseURL],
+      cacheCapacity: 1000
+    }
+    let client = SchemaRegistryClient.newClient(conf)
+    let ser = new ProtobufSerializer(client, SerdeType.VALUE, {autoRegisterSchemas: true})
+    ser.registry.add(AuthorSchema)
+    ser.registry.add(PizzaSchema)
+    let objs = [
+      create(AuthorSchema, {
+        name: 'Kafka',
+        id: 123,
+        works: ['The Castle', 'The Trial']
+      }),
+      create(PizzaSchema, {
+        size: 'Extra extra large',
+        toppings: ['anchovies', 'mushrooms']
+      }),
+      create(AuthorSchema, {
+        name: 'Woolf',
+        id: 456,
+        works: ['The Waves']
+      }),
+    ]
+    let bytes = await ser.serializeBatch(topic, objs)
+    expect(bytes[0]).toEqual(await ser.serialize(topic, objs[0]))
+
+    let deser = new ProtobufDeserializer(client, SerdeType.VALUE, {})
+    let objs2 = await deser.deserializeBatch(topic, [bytes[0], bytes[1], Buffer.alloc(0), bytes[2]])
+    expect(objs2).toEqual([objs[0], objs[1], null, objs[2]])
+  })
+  it('deserialize with parsed message indexes', async () => {
+    let conf: ClientConfig = {
+      baseURLs: [baseURL],
+      cacheCapacity: 1000
+    }
+    let client = SchemaRegistryClient.newClient(conf)
+    let ser = new ProtobufSerializer(client, SerdeType.VALUE, {autoRegisterSchemas: true})
+    ser.registry.add(PizzaSchema)
+    let obj = create(PizzaSchema, {
+      size: 'Extra extra large',
+      toppings: ['anchovies', 'mushrooms']
+    })
+    let bytes = await ser.serialize(topic, obj)
+
+    let deser = new ProtobufDeserializer(client, SerdeType.VALUE, {})
+    let [bytesRead, messageIndexes] = deser.readMessageIndexes(bytes.subarray(5))
+    let header = { schemaId: bytes.readInt32BE(1), messageIndexes }
+    expect(await deser.deserialize(topic, bytes.subarray(5 + bytesRead), header)).toEqual(obj)
+    // Without the indexes, the payload still starts with them
+    expect(await deser.deserialize(topic, bytes.subarray(5), { schemaId: header.schemaId })).toEqual(obj)
+    // A count of zero is the shorthand for the first message
+    expect(deser.readMessageIndexes(Buffer.from([0]))).toEqual([1, [0]])
+  })
+  it('deserialize an empty message with a parsed header', async () => {
+    let conf: ClientConfig = {
+      baseURLs: [baseURL],
+      cacheCapacity: 1000
+    }
+    let client = SchemaRegistryClient.newClient(conf)
+    let ser = new ProtobufSerializer(client, SerdeType.VALUE, {autoRegisterSchemas: true})
+    ser.registry.add(PizzaSchema)
+    // All fields are defaults, so the message has no bytes
+    let obj = create(PizzaSchema, {})
+    let bytes = await ser.serialize(topic, obj)
+
+    let deser = new ProtobufDeserializer(client, SerdeType.VALUE, {})
+    let [bytesRead, messageIndexes] = deser.readMessageIndexes(bytes.subarray(5))
+    let header = { schemaId: bytes.readInt32BE(1), messageIndexes }
+    let body = bytes.subarray(5 + bytesRead)
+    expect(body.length).toEqual(0)
+    expect(await deser.deserialize(topic, body, header)).toEqual(obj)
+    expect(await deser.deserializeBatch(topic, [body, Buffer.alloc(0)], [header, {}]))
+      .toEqual([obj, null])
+  })
+  it('deserialize caches message descriptors by schema ID', async () => {
+    let conf: ClientConfig = {
+      baseURLs: [baseURL],
+      cacheCapacity: 1000
+    }
+    let client = SchemaRegistryClient.newClient(conf)
+    let ser = new ProtobufSerializer(client, SerdeType.VALUE, {autoRegisterSchemas: true})
+    ser.registry.add(NestedMessage_InnerMessageSchema)
+    let obj = create(NestedMessage_InnerMessageSchema, {
+      id: "inner"
+    })
+    let bytes = await ser.serialize(topic, obj)
+
+    let deser = new ProtobufDeserializer(client, SerdeType.VALUE, {})
+    let toMessageDesc = jest.spyOn(deser, 'toMessageDescFromIndexes')
+    expect(await deser.deserialize(topic, bytes)).toEqual(obj)
+    expect(await deser.deserialize(topic, bytes)).toEqual(obj)
+    expect(await deser.deserializeBatch(topic, [bytes, bytes])).toEqual([obj, obj])
+    expect(toMessageDesc).toHaveBeenCalledTimes(1)
+
+    // Unknown message indexes are not cached
+    let id = bytes.readInt32BE(1)
+    let info = await client.getBySubjectAndId(subject, id, 'serialized')
+    await expect(deser.toMessageDescById(id, info, [100])).rejects.toThrow('message descriptor not found')
+  })
   it('serialize nested messsage', async () => {
     let conf: ClientConfig = {
       baseURLs: [baseURL],
@@ -233,4 +336,147 @@ describe('ProtobufSerializer', () => {
     obj2 = await deser.deserialize(topic, bytes)
     expect(obj2).not.toEqual(obj);
   })
+  it('encryption only visits tagged fields', async () => {
+    let conf: ClientConfig = {
+      baseURLs: [baseURL],
+      cacheCapacity: 1000
+    }
+    let client = SchemaRegistryClient.newClient(conf)
+    let serConfig: ProtobufSerializerConfig = {
+      useLatestVersion: true,
+      ruleConfig: {
+        secret: 'mysecret'
+      }
+    }
+    let ser = new ProtobufSerializer(client, SerdeType.VALUE, serConfig)
+    ser.registry.add(AuthorSchema)
+    let dekClient = fieldEncryptionExecutor.client!
+
+    let encRule: Rule = {
+      name: 'test-encrypt',
+      kind: 'TRANSFORM',
+      mode: RuleMode.WRITEREAD,
+      type: 'ENCRYPT',
+      tags: ['PII'],
+      params: {
+        'encrypt.kek.name': 'kek1',
+        'encrypt.kms.type': 'local-kms',
+        'encrypt.kms.key.id': 'mykey',
+      },
+      onFailure: 'ERROR,NONE'
+    }
+    let otherRule: Rule = {
+      ...encRule,
+      name: 'test-encrypt-other',
+      tags: ['OTHER'],
+    }
+    let ruleSet: RuleSet = {
+      domainRules: [encRule, otherRule]
+    }
+
+    let info: SchemaInfo = {
+      schemaType: 'PROTOBUF',
+      schema: Buffer.from(toBinary(FileDescriptorProtoSchema, file_test_schemaregistry_serde_example.proto)).toString('base64'),
+      ruleSet
+    }
+
+    await client.register(subject, info, false)
+
+    let newObj = () => create(AuthorSchema, {
+      name: 'Kafka',
+      id: 123,
+      picture: Buffer.from([1, 2]),
+      works: ['The Castle', 'The Trial']
+    })
+    await ser.serialize(topic, newObj())
+
+    // Both tagged fields share one DEK lookup, and no field has the other tag
+    let getDek = jest.spyOn(dekClient, 'getDek')
+    let bytes = await ser.serialize(topic, newObj())
+    expect(getDek).toHaveBeenCalledTimes(1)
+
+    let deserConfig: ProtobufDeserializerConfig = {
+      ruleConfig: {
+        secret: 'mysecret'
+      }
+    }
+    let deser = new ProtobufDeserializer(client, SerdeType.VALUE, deserConfig)
+    fieldEncryptionExecutor.client = dekClient
+    expect(await deser.deserialize(topic, bytes)).toEqual(newObj())
+    getDek.mockRestore()
+  })
+  it('encryption of a nested message', async () => {
+    let conf: ClientConfig = {
+      baseURLs: [baseURL],
+      cacheCapacity: 1000
+    }
+    let client = SchemaRegistryClient.newClient(conf)
+    let serConfig: ProtobufSerializerConfig = {
+      useLatestVersion: true,
+      ruleConfig: {
+        secret: 'mysecret'
+      }
+    }
+    let ser = new ProtobufSerializer(client, SerdeType.VALUE, serConfig)
+    ser.registry.add(NestedMessageSchema)
+    let dekClient = fieldEncryptionExecutor.client!
+
+    let encRule: Rule = {
+      name: 'test-encrypt',
+      kind: 'TRANSFORM',
+      mode: RuleMode.WRITEREAD,
+      type: 'ENCRYPT',
+      tags: ['PII'],
+      params: {
+        'encrypt.kek.name': 'kek1',
+        'encrypt.kms.type': 'local-kms',
+        'encrypt.kms.key.id': 'mykey',
+      },
+      onFailure: 'ERROR,NONE'
+    }
+    let ruleSet: RuleSet = {
+      domainRules: [encRule]
+    }
+
+    // The tagged field is only found with the descriptor of the inner message
+    let info: SchemaInfo = {
+      schemaType: 'PROTOBUF',
+      schema: Buffer.from(toBinary(FileDescriptorProtoSchema, file_test_schemaregistry_serde_nested.proto)).toString('base64'),
+      metadata: {
+        tags: {
+          'test.NestedMessage.InnerMessage.id': ['PII']
+        }
+      },
+      ruleSet
+    }
+
+    await client.register(subject, info, false)
+
+    let newObj = () => create(NestedMessageSchema, {
+      isActive: true,
+      inner: {
+        id: 'inner',
+        ids: [1, 2]
+      }
+    })
+    let bytes = await ser.serialize(topic, newObj())
+
+    let deserConfig: ProtobufDeserializerConfig = {
+      ruleConfig: {
+        secret: 'mysecret'
+      }
+    }
+    let deser = new ProtobufDeserializer(client, SerdeType.VALUE, deserConfig)
+    fieldEncryptionExecutor.client = dekClient
+    let obj2 = await deser.deserialize(topic, bytes)
+    expect(obj2).toEqual(newObj())
+
+    clearKmsClients()
+    let registry = new RuleRegistry()
+    registry.registerExecutor(new FieldEncryptionExecutor())
+    deser = new ProtobufDeserializer(client, SerdeType.VALUE, {}, registry)
+    obj2 = await deser.deserialize(topic, bytes)
+    expect(obj2.inner.id).not.toEqual('inner')
+    expect(obj2.inner.ids).toEqual([1, 2])
+  })
 })
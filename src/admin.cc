@@ -14,6 +14,7 @@
 #include <string>
 #include <vector>
 
+#include "src/per-isolate-data.h"
 #include "src/workers.h"
 
 using Nan::FunctionCallbackInfo;
@@ -83,6 +84,12 @@ Baton AdminClient::Connect() {
   return baton;
 }
 
+void AdminClient::Teardown() {
+  // Dispatchers are deactivated by Disconnect(), and dependent clients leave
+  // the underlying connection to its owner.
+  Disconnect();
+}
+
 Baton AdminClient::Disconnect() {
   /* Dependent AdminClients don't need to do anything. We block the call to
    * disconnect in JavaScript, but the destructor of AdminClient might trigger
@@ -103,8 +110,6 @@ Baton AdminClient::Disconnect() {
   return Baton(RdKafka::ERR_NO_ERROR);
 }
 
-Nan::Persistent<v8::Function> AdminClient::constructor;
-
 void AdminClient::Init(v8::Local<v8::Object> exports) {
   Nan::HandleScope scope;
 
@@ -133,12 +138,20 @@ void AdminClient::Init(v8::Local<v8::Object> exports) {
   Nan::SetPrototypeMethod(tpl, "connect", NodeConnect);
   Nan::SetPrototypeMethod(tpl, "disconnect", NodeDisconnect);
   Nan::SetPrototypeMethod(tpl, "setSaslCredentials", NodeSetSaslCredentials);
+  Nan::SetPrototypeMethod(tpl, "mockBootstrapServers", NodeMockBootstrapServers);  // NOLINT
+  Nan::SetPrototypeMethod(tpl, "mockBrokerSetRtt", NodeMockBrokerSetRtt);
+  Nan::SetPrototypeMethod(tpl, "mockBrokerSetUp", NodeMockBrokerSetUp);
+  Nan::SetPrototypeMethod(tpl, "mockPartitionSetLeader", NodeMockPartitionSetLeader);  // NOLINT
+  Nan::SetPrototypeMethod(tpl, "mockPushRequestErrors", NodeMockPushRequestErrors);  // NOLINT
+  Nan::SetPrototypeMethod(tpl, "mockClearRequestErrors", NodeMockClearRequestErrors);  // NOLINT
+  Nan::SetPrototypeMethod(tpl, "mockTopicCreate", NodeMockTopicCreate);
   Nan::SetPrototypeMethod(tpl, "getMetadata", NodeGetMetadata);
   Nan::SetPrototypeMethod(tpl, "setOAuthBearerToken", NodeSetOAuthBearerToken);
   Nan::SetPrototypeMethod(tpl, "setOAuthBearerTokenFailure",
                           NodeSetOAuthBearerTokenFailure);
 
-  constructor.Reset(
+  PerIsolateData* data = PerIsolateData::For(v8::Isolate::GetCurrent());
+  data->admin_client_constructor.Reset(
     (tpl->GetFunction(Nan::GetCurrentContext())).ToLocalChecked());
   Nan::Set(exports, Nan::New("AdminClient").ToLocalChecked(),
     tpl->GetFunction(Nan::GetCurrentContext()).ToLocalChecked());
@@ -199,7 +212,8 @@ v8::Local<v8::Object> AdminClient::NewInstance(v8::Local<v8::Value> arg) {
   const unsigned argc = 1;
 
   v8::Local<v8::Value> argv[argc] = { arg };
-  v8::Local<v8::Function> cons = Nan::New<v8::Function>(constructor);
+  v8::Local<v8::Function> cons = Nan::New<v8::Function>(
+    PerIsolateData::For(v8::Isolate::GetCurrent())->admin_client_constructor);
   v8::Local<v8::Object> instance =
     Nan::NewInstance(cons, argc, argv).ToLocalChecked();
 
@@ -43,6 +43,7 @@ class AdminClient : public Connection {
 
   void ActivateDispatchers();
   void DeactivateDispatchers();
+  void Teardown();
 
   Baton Connect();
   Baton Disconnect();
@@ -73,7 +74,6 @@ class AdminClient : public Connection {
                        rd_kafka_event_t** event_response);
 
  protected:
-  static Nan::Persistent<v8::Function> constructor;
   static void New(const Nan::FunctionCallbackInfo<v8::Value>& info);
 
   explicit AdminClient(Conf* globalConfig);
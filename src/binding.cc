@@ -62,7 +62,7 @@ void ConstantsInit(v8::Local<v8::Object> exports) {
     Nan::GetFunction(Nan::New<v8::FunctionTemplate>(NodeRdKafkaBuildInFeatures)).ToLocalChecked());  // NOLINT
 }
 
-void Init(v8::Local<v8::Object> exports, v8::Local<v8::Value> m_, void* v_) {
+void Init(v8::Local<v8::Object> exports) {
   KafkaConsumer::Init(exports);
   Producer::Init(exports);
   AdminClient::Init(exports);
@@ -73,4 +73,6 @@ void Init(v8::Local<v8::Object> exports, v8::Local<v8::Value> m_, void* v_) {
       Nan::New(RdKafka::version_str().c_str()).ToLocalChecked());
 }
 
-NODE_MODULE(kafka, Init)
+// The addon keeps no process-wide v8 state (see PerIsolateData), so it is
+// safe to load from multiple worker_threads.
+NAN_MODULE_WORKER_ENABLED(kafka, Init)
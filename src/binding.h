@@ -21,5 +21,6 @@
 #include "src/producer.h"
 #include "src/topic.h"
 #include "src/admin.h"
+#include "src/per-isolate-data.h"
 
 #endif  // SRC_BINDING_H_
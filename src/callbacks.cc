@@ -53,6 +53,10 @@ v8::Local<v8::Array> TopicPartitionListToV8Array(
 
 Dispatcher::Dispatcher() {
   async = NULL;
+  // Dispatchers are always constructed on the JS thread which owns the
+  // client, so capture its loop here. Activate() may later be called from a
+  // threadpool thread, where there is no current environment to ask.
+  loop = Nan::GetCurrentEventLoop();
   uv_mutex_init(&async_lock);
 }
 
@@ -70,7 +74,7 @@ Dispatcher::~Dispatcher() {
 void Dispatcher::Activate() {
   if (!async) {
     async = new uv_async_t;
-    uv_async_init(uv_default_loop(), async, AsyncMessage_);
+    uv_async_init(loop, async, AsyncMessage_);
 
     async->data = this;
   }
@@ -159,6 +163,19 @@ event_t::event_t(const RdKafka::Event &event) {
     break;
   }
 }
+
+/**
+ * @brief A log event raised by the binding itself rather than librdkafka.
+ */
+event_t::event_t(RdKafka::Event::Severity _severity, const std::string &_fac,
+                 const std::string &_message) :
+  type(RdKafka::Event::EVENT_LOG),
+  message(_message),
+  severity(_severity),
+  fac(_fac),
+  throttle_time(0),
+  broker_id(0) {}
+
 event_t::~event_t() {}
 
 // Event callback
@@ -181,6 +198,16 @@ void Event::event_cb(RdKafka::Event &event) {
   dispatcher.Execute();
 }
 
+void Event::Log(RdKafka::Event::Severity severity, const std::string &fac,
+                const std::string &message) {
+  if (!dispatcher.HasCallbacks()) {
+    return;
+  }
+
+  dispatcher.Add(event_t(severity, fac, message));
+  dispatcher.Execute();
+}
+
 EventDispatcher::EventDispatcher() : client_name("") {}
 EventDispatcher::~EventDispatcher() {}
 
@@ -56,6 +56,7 @@ class Dispatcher {
   static void AsyncHandleCloseCallback(uv_handle_t *);
 
   uv_async_t *async;
+  uv_loop_t *loop;
 };
 
 struct event_t {
@@ -70,6 +71,8 @@ struct event_t {
   int broker_id;
 
   explicit event_t(const RdKafka::Event &);
+  event_t(RdKafka::Event::Severity, const std::string &fac,
+          const std::string &message);
   ~event_t();
 };
 
@@ -90,6 +93,8 @@ class Event : public RdKafka::EventCb {
   Event();
   ~Event();
   void event_cb(RdKafka::Event&);
+  void Log(RdKafka::Event::Severity, const std::string &fac,
+           const std::string &message);
   EventDispatcher dispatcher;
 };
 
@@ -164,6 +169,9 @@ struct event_topic_partition_t {
     offset(p_offset) {}
 };
 
+v8::Local<v8::Array> TopicPartitionListToV8Array(
+  std::vector<event_topic_partition_t>);
+
 struct rebalance_event_t {
   RdKafka::ErrorCode err;
   std::vector<event_topic_partition_t> partitions;
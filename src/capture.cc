@@ -0,0 +1,544 @@
+/*
+ * confluent-kafka-javascript - Node.js wrapper  for RdKafka C/C++ library
+ *
+ * Copyright (c) 2024 Confluent, Inc.
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE.txt file for details.
+ */
+
+#include "src/capture.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/common.h"
+
+namespace NodeKafka {
+namespace Capture {
+
+static const char kMagic[] = "CKJSCAP1";
+static const size_t kMagicSize = 8;
+static const uint32_t kVersion = 1;
+static const size_t kFileHeaderSize = kMagicSize + 8;
+
+// Record size, capture time, offset, timestamp, partition, leader epoch and
+// timestamp type.
+static const size_t kRecordFixedSize = 4 + 8 + 8 + 8 + 4 + 4 + 1;
+
+namespace {
+
+void Put(std::string &out, uint64_t value, size_t bytes) {
+  for (size_t i = 0; i < bytes; i++) {
+    out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+uint64_t Get(const uint8_t *in, size_t bytes) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < bytes; i++) {
+    value |= static_cast<uint64_t>(in[i]) << (8 * i);
+  }
+  return value;
+}
+
+void PutBytes(std::string &out, const void *data, size_t len,
+              size_t len_bytes) {
+  if (data == NULL) {
+    Put(out, static_cast<uint32_t>(-1), len_bytes);
+    return;
+  }
+  Put(out, len, len_bytes);
+  out.append(static_cast<const char*>(data), len);
+}
+
+void SleepNs(uint64_t ns) {
+  std::this_thread::sleep_for(std::chrono::nanoseconds(ns));
+}
+
+}  // namespace
+
+/**
+ * @brief Read-only mapping of a whole capture file.
+ */
+class Mapping {
+ public:
+  static std::shared_ptr<Mapping> Open(const std::string &path,
+                                       std::string &errstr) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+      NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+      errstr = "Could not open capture file " + path;
+      return nullptr;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+      CloseHandle(file);
+      errstr = "Capture file " + path + " is empty";
+      return nullptr;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0,
+                                        NULL);
+    CloseHandle(file);
+    if (mapping == NULL) {
+      errstr = "Could not map capture file " + path;
+      return nullptr;
+    }
+    void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (data == NULL) {
+      errstr = "Could not map capture file " + path;
+      return nullptr;
+    }
+    return std::shared_ptr<Mapping>(new Mapping(
+      static_cast<const uint8_t*>(data), static_cast<size_t>(size.QuadPart)));
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      errstr = "Could not open capture file " + path + ": " + strerror(errno);
+      return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+      close(fd);
+      errstr = "Capture file " + path + " is empty";
+      return nullptr;
+    }
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+      errstr = "Could not map capture file " + path + ": " + strerror(errno);
+      return nullptr;
+    }
+    // Replay reads the file front to back.
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+    return std::shared_ptr<Mapping>(new Mapping(
+      static_cast<const uint8_t*>(data), static_cast<size_t>(st.st_size)));
+#endif
+  }
+
+  ~Mapping() {
+#ifdef _WIN32
+    UnmapViewOfFile(m_data);
+#else
+    munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+  }
+
+  const uint8_t *data() const { return m_data; }
+  size_t size() const { return m_size; }
+
+ private:
+  Mapping(const uint8_t *data, size_t size) : m_data(data), m_size(size) {}
+
+  const uint8_t *m_data;
+  size_t m_size;
+};
+
+/**
+ * @brief A message read from a capture file.
+ *
+ * Topic, key and value point into the mapping. Headers are materialized on
+ * first access, like librdkafka does for consumed messages.
+ */
+class CapturedMessage : public RdKafka::Message {
+ public:
+  // Message for a record, which must have been validated.
+  CapturedMessage(std::shared_ptr<Mapping> mapping, const uint8_t *record) :
+    m_mapping(mapping),
+    m_err(RdKafka::ERR_NO_ERROR),
+    m_headers(NULL) {
+    const uint8_t *p = record + 4 + 8;
+    m_offset = static_cast<int64_t>(Get(p, 8)); p += 8;
+    m_timestamp.timestamp = static_cast<int64_t>(Get(p, 8)); p += 8;
+    m_partition = static_cast<int32_t>(Get(p, 4)); p += 4;
+    m_leader_epoch = static_cast<int32_t>(Get(p, 4)); p += 4;
+    m_timestamp.type =
+      static_cast<RdKafka::MessageTimestamp::MessageTimestampType>(*p); p += 1;
+
+    m_topic_len = static_cast<uint16_t>(Get(p, 2)); p += 2;
+    m_topic = p; p += m_topic_len;
+
+    int32_t key_len = static_cast<int32_t>(Get(p, 4)); p += 4;
+    m_key = key_len < 0 ? NULL : p;
+    m_key_len = key_len < 0 ? 0 : key_len;
+    p += m_key_len;
+
+    int32_t value_len = static_cast<int32_t>(Get(p, 4)); p += 4;
+    m_value = value_len < 0 ? NULL : p;
+    m_value_len = value_len < 0 ? 0 : value_len;
+    p += m_value_len;
+
+    m_header_count = static_cast<uint32_t>(Get(p, 4)); p += 4;
+    m_header_data = p;
+  }
+
+  // Message carrying only an error, e.g. a consume timeout.
+  explicit CapturedMessage(RdKafka::ErrorCode err) :
+    m_err(err),
+    m_offset(RdKafka::Topic::OFFSET_INVALID),
+    m_partition(RdKafka::Topic::PARTITION_UA),
+    m_leader_epoch(-1),
+    m_topic(NULL),
+    m_topic_len(0),
+    m_key(NULL),
+    m_key_len(0),
+    m_value(NULL),
+    m_value_len(0),
+    m_header_count(0),
+    m_header_data(NULL),
+    m_headers(NULL) {
+    m_timestamp.type = RdKafka::MessageTimestamp::MSG_TIMESTAMP_NOT_AVAILABLE;
+    m_timestamp.timestamp = -1;
+  }
+
+  ~CapturedMessage() {
+    delete m_headers;
+  }
+
+  std::string errstr() const { return RdKafka::err2str(m_err); }
+  RdKafka::ErrorCode err() const { return m_err; }
+  RdKafka::Topic *topic() const { return NULL; }
+  std::string topic_name() const {
+    if (!m_topic) {
+      return std::string();
+    }
+    return std::string(reinterpret_cast<const char*>(m_topic), m_topic_len);
+  }
+  int32_t partition() const { return m_partition; }
+  void *payload() const { return const_cast<uint8_t*>(m_value); }
+  size_t len() const { return m_value_len; }
+  const std::string *key() const {
+    if (!m_key) {
+      return NULL;
+    }
+    if (!m_key_string) {
+      m_key_string.reset(new std::string(
+        reinterpret_cast<const char*>(m_key), m_key_len));
+    }
+    return m_key_string.get();
+  }
+  const void *key_pointer() const { return m_key; }
+  size_t key_len() const { return m_key_len; }
+  int64_t offset() const { return m_offset; }
+  RdKafka::MessageTimestamp timestamp() const { return m_timestamp; }
+  void *msg_opaque() const { return NULL; }
+  int64_t latency() const { return -1; }
+  struct rd_kafka_message_s *c_ptr() { return NULL; }
+  Status status() const { return MSG_STATUS_PERSISTED; }
+  RdKafka::Headers *headers() {
+    RdKafka::ErrorCode err;
+    return headers(&err);
+  }
+  RdKafka::Headers *headers(RdKafka::ErrorCode *err) {
+    *err = RdKafka::ERR_NO_ERROR;
+    if (m_header_count == 0) {
+      *err = RdKafka::ERR__NOENT;
+      return NULL;
+    }
+    if (!m_headers) {
+      m_headers = RdKafka::Headers::create();
+      const uint8_t *p = m_header_data;
+      for (uint32_t i = 0; i < m_header_count; i++) {
+        uint16_t name_len = static_cast<uint16_t>(Get(p, 2)); p += 2;
+        std::string name(reinterpret_cast<const char*>(p), name_len);
+        p += name_len;
+        int32_t value_len = static_cast<int32_t>(Get(p, 4)); p += 4;
+        if (value_len < 0) {
+          m_headers->add(name, NULL, 0);
+        } else {
+          m_headers->add(name, p, value_len);
+          p += value_len;
+        }
+      }
+    }
+    return m_headers;
+  }
+  int32_t broker_id() const { return -1; }
+  int32_t leader_epoch() const { return m_leader_epoch; }
+  RdKafka::Error *offset_store() { return NULL; }
+
+ private:
+  std::shared_ptr<Mapping> m_mapping;
+  RdKafka::ErrorCode m_err;
+
+  int64_t m_offset;
+  int32_t m_partition;
+  int32_t m_leader_epoch;
+  RdKafka::MessageTimestamp m_timestamp;
+
+  const uint8_t *m_topic;
+  size_t m_topic_len;
+  const uint8_t *m_key;
+  size_t m_key_len;
+  const uint8_t *m_value;
+  size_t m_value_len;
+  uint32_t m_header_count;
+  const uint8_t *m_header_data;
+
+  mutable std::unique_ptr<std::string> m_key_string;
+  RdKafka::Headers *m_headers;
+};
+
+/**
+ * @brief Check that every record lies within the file, so records can be
+ * read without bounds checks during replay.
+ */
+static bool Validate(const Mapping &mapping, std::string &errstr) {
+  const uint8_t *data = mapping.data();
+  const size_t size = mapping.size();
+
+  if (size < kFileHeaderSize || memcmp(data, kMagic, kMagicSize) != 0) {
+    errstr = "Not a capture file";
+    return false;
+  }
+  if (Get(data + kMagicSize, 4) != kVersion) {
+    errstr = "Unsupported capture file version";
+    return false;
+  }
+
+  size_t pos = kFileHeaderSize;
+  while (pos < size) {
+    if (size - pos < kRecordFixedSize) {
+      errstr = "Truncated capture record";
+      return false;
+    }
+    const size_t record_end = pos + 4 + Get(data + pos, 4);
+    if (record_end > size) {
+      errstr = "Truncated capture record";
+      return false;
+    }
+    if (record_end < pos + kRecordFixedSize) {
+      errstr = "Corrupt capture record";
+      return false;
+    }
+
+    // Walk the variable length fields of the record.
+    size_t p = pos + kRecordFixedSize;
+    bool ok = true;
+    auto skip = [&](size_t len_bytes, bool nullable) {
+      if (!ok || record_end - p < len_bytes) {
+        ok = false;
+        return;
+      }
+      uint64_t len = Get(data + p, len_bytes);
+      p += len_bytes;
+      if (nullable && static_cast<int32_t>(len) < 0) {
+        return;
+      }
+      if (record_end - p < len) {
+        ok = false;
+        return;
+      }
+      p += len;
+    };
+
+    skip(2, false);  // topic
+    skip(4, true);   // key
+    skip(4, true);   // value
+    if (ok && record_end - p >= 4) {
+      uint32_t header_count = static_cast<uint32_t>(Get(data + p, 4));
+      p += 4;
+      for (uint32_t i = 0; i < header_count && ok; i++) {
+        skip(2, false);
+        skip(4, true);
+      }
+    } else {
+      ok = false;
+    }
+
+    if (!ok || p != record_end) {
+      errstr = "Corrupt capture record";
+      return false;
+    }
+    pos = record_end;
+  }
+
+  return true;
+}
+
+Writer* Writer::Open(const std::string &path, std::string &errstr) {
+  FILE *file = fopen(path.c_str(), "wb");
+  if (!file) {
+    errstr = "Could not open capture file " + path + ": " + strerror(errno);
+    return NULL;
+  }
+
+  std::string header(kMagic, kMagicSize);
+  Put(header, kVersion, 4);
+  Put(header, 0, 4);
+  if (fwrite(header.data(), 1, header.size(), file) != header.size()) {
+    errstr = "Could not write capture file " + path + ": " + strerror(errno);
+    fclose(file);
+    return NULL;
+  }
+
+  return new Writer(file);
+}
+
+Writer::Writer(FILE *file) :
+  m_file(file),
+  m_start_ns(uv_hrtime()),
+  m_failed(false) {
+  uv_mutex_init(&m_lock);
+}
+
+Writer::~Writer() {
+  if (m_file) {
+    fclose(m_file);
+  }
+  uv_mutex_destroy(&m_lock);
+}
+
+/**
+ * @brief Append a message to the capture file.
+ *
+ * @returns false with `errstr` set if the record could not be written in
+ * full, e.g. when the disk is full.
+ */
+bool Writer::Write(RdKafka::Message &message, std::string &errstr) {
+  const uint64_t now = uv_hrtime();
+  const std::string topic = message.topic_name();
+  RdKafka::Headers *headers = message.headers();
+
+  scoped_mutex_lock lock(m_lock);
+
+  if (m_failed) {
+    errstr = "Capture file is no longer writable";
+    return false;
+  }
+
+  m_record.clear();
+  Put(m_record, 0, 4);  // size, filled in below
+  Put(m_record, now - m_start_ns, 8);
+  Put(m_record, message.offset(), 8);
+  Put(m_record, message.timestamp().timestamp, 8);
+  Put(m_record, message.partition(), 4);
+  Put(m_record, message.leader_epoch(), 4);
+  Put(m_record, message.timestamp().type, 1);
+  PutBytes(m_record, topic.data(), topic.size(), 2);
+  PutBytes(m_record, message.key_pointer(), message.key_len(), 4);
+  PutBytes(m_record, message.payload(), message.len(), 4);
+
+  if (headers) {
+    std::vector<RdKafka::Headers::Header> all = headers->get_all();
+    Put(m_record, all.size(), 4);
+    for (size_t i = 0; i < all.size(); i++) {
+      PutBytes(m_record, all[i].key().data(), all[i].key().size(), 2);
+      PutBytes(m_record, all[i].value(), all[i].value_size(), 4);
+    }
+  } else {
+    Put(m_record, 0, 4);
+  }
+
+  const uint32_t size = static_cast<uint32_t>(m_record.size() - 4);
+  for (size_t i = 0; i < 4; i++) {
+    m_record[i] = static_cast<char>((size >> (8 * i)) & 0xff);
+  }
+
+  if (fwrite(m_record.data(), 1, m_record.size(), m_file) != m_record.size()) {
+    errstr = std::string("Could not write capture file: ") + strerror(errno);
+    m_failed = true;
+    fclose(m_file);
+    m_file = NULL;
+    return false;
+  }
+
+  return true;
+}
+
+Reader* Reader::Open(const std::string &path, double speed, bool loop,
+                     std::string &errstr) {
+  std::shared_ptr<Mapping> mapping = Mapping::Open(path, errstr);
+  if (!mapping) {
+    return NULL;
+  }
+  if (!Validate(*mapping, errstr)) {
+    return NULL;
+  }
+  return new Reader(mapping, speed, loop);
+}
+
+Reader::Reader(std::shared_ptr<Mapping> mapping, double speed, bool loop) :
+  m_mapping(mapping),
+  m_speed(speed),
+  m_loop(loop),
+  m_position(kFileHeaderSize),
+  m_pass_start_ns(0) {
+  uv_mutex_init(&m_lock);
+}
+
+Reader::~Reader() {
+  uv_mutex_destroy(&m_lock);
+}
+
+/**
+ * @brief Get the next captured message, or a timed out message if none is
+ * due within `timeout_ms`.
+ *
+ * Called from the consume threads in place of RdKafka::KafkaConsumer::consume
+ * and honours its timeout semantics, sleeping when pacing the replay.
+ */
+RdKafka::Message* Reader::Next(int timeout_ms) {
+  const uint64_t now = uv_hrtime();
+  const uint64_t timeout_ns = static_cast<uint64_t>(timeout_ms) * 1000000;
+  const uint8_t *record = NULL;
+  uint64_t due_ns = 0;
+
+  {
+    scoped_mutex_lock lock(m_lock);
+
+    const size_t size = m_mapping->size();
+    if (m_position >= size && m_loop && size > kFileHeaderSize) {
+      m_position = kFileHeaderSize;
+      m_pass_start_ns = 0;
+    }
+
+    if (m_position < size) {
+      if (m_pass_start_ns == 0) {
+        m_pass_start_ns = now;
+      }
+
+      const uint8_t *candidate = m_mapping->data() + m_position;
+      if (m_speed > 0) {
+        due_ns = m_pass_start_ns + static_cast<uint64_t>(
+          static_cast<double>(Get(candidate + 4, 8)) / m_speed);
+      }
+
+      if (due_ns <= now + timeout_ns) {
+        record = candidate;
+        m_position += 4 + Get(candidate, 4);
+      }
+    }
+  }
+
+  if (!record) {
+    SleepNs(timeout_ns);
+    return new CapturedMessage(RdKafka::ERR__TIMED_OUT);
+  }
+
+  if (due_ns > now) {
+    SleepNs(due_ns - now);
+  }
+
+  return new CapturedMessage(m_mapping, record);
+}
+
+}  // namespace Capture
+}  // namespace NodeKafka
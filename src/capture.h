@@ -0,0 +1,100 @@
+/*
+ * confluent-kafka-javascript - Node.js wrapper  for RdKafka C/C++ library
+ *
+ * Copyright (c) 2024 Confluent, Inc.
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE.txt file for details.
+ */
+
+#ifndef SRC_CAPTURE_H_
+#define SRC_CAPTURE_H_
+
+#include <uv.h>
+
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include "rdkafkacpp.h" // NOLINT
+
+namespace NodeKafka {
+namespace Capture {
+
+/*
+ * Capture file format. All integers are little-endian.
+ *
+ *   file header: magic "CKJSCAP1" (8 bytes), version (u32), reserved (u32)
+ *   record:      size of the rest of the record (u32)
+ *                capture time in ns since the start of the capture (u64)
+ *                offset (i64), timestamp (i64), partition (i32),
+ *                leader epoch (i32), timestamp type (u8)
+ *                topic length (u16), topic
+ *                key length (i32, -1 for null), key
+ *                value length (i32, -1 for null), value
+ *                header count (u32), then per header:
+ *                  name length (u16), name, value length (i32), value
+ */
+
+/**
+ * @brief Appends consumed messages to a capture file.
+ *
+ * Write may be called concurrently from the consume threads. Once a write
+ * fails, the file is closed and every later write is refused.
+ */
+class Writer {
+ public:
+  static Writer* Open(const std::string &path, std::string &errstr);
+  ~Writer();
+
+  bool Write(RdKafka::Message &message, std::string &errstr);
+
+ private:
+  explicit Writer(FILE *file);
+
+  FILE *m_file;
+  uint64_t m_start_ns;
+  uv_mutex_t m_lock;
+  std::string m_record;
+  bool m_failed;
+};
+
+class Mapping;
+
+/**
+ * @brief Replays a capture file as RdKafka::Message instances.
+ *
+ * The file is memory-mapped; replayed messages reference the mapping, which
+ * stays alive until the last of them is deleted.
+ */
+class Reader {
+ public:
+  /**
+   * @param speed Playback speed relative to the capture. 0 replays as fast
+   *              as possible, 1 at the original pace.
+   * @param loop  Whether to restart from the beginning at the end of the
+   *              capture. Otherwise consume times out once it is exhausted.
+   */
+  static Reader* Open(const std::string &path, double speed, bool loop,
+                      std::string &errstr);
+  ~Reader();
+
+  RdKafka::Message* Next(int timeout_ms);
+
+ private:
+  Reader(std::shared_ptr<Mapping>, double speed, bool loop);
+
+  std::shared_ptr<Mapping> m_mapping;
+  double m_speed;
+  bool m_loop;
+
+  uv_mutex_t m_lock;
+  size_t m_position;
+  // Replay time at which the current pass through the capture started
+  uint64_t m_pass_start_ns;
+};
+
+}  // namespace Capture
+}  // namespace NodeKafka
+
+#endif  // SRC_CAPTURE_H_
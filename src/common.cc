@@ -681,6 +681,107 @@ v8::Local<v8::Object> ToV8Object(RdKafka::Message *message) {
   return ToV8Object(message, true, true);
 }
 
+/**
+ * @brief Parse the Confluent wire format header of a message.
+ *
+ * The header is a zero magic byte and a big-endian schema ID, optionally
+ * followed by the zig-zag varint encoded count and values of the Protobuf
+ * message indexes, where a count of zero stands for the indexes [0].
+ * The result is not valid if the payload is not framed this way.
+ */
+WireFormat ParseWireFormat(RdKafka::Message *message, WireFormatMode mode) {
+  WireFormat wire_format;
+  wire_format.valid = false;
+  wire_format.schema_id = 0;
+  wire_format.header_size = 0;
+  wire_format.has_message_indexes = false;
+
+  const unsigned char* payload =
+    static_cast<const unsigned char*>(message->payload());
+  size_t len = message->len();
+  if (mode == WIRE_FORMAT_NONE || payload == NULL || len < 5 ||
+      payload[0] != 0) {
+    return wire_format;
+  }
+
+  wire_format.schema_id = static_cast<int32_t>(
+    (static_cast<uint32_t>(payload[1]) << 24) |
+    (static_cast<uint32_t>(payload[2]) << 16) |
+    (static_cast<uint32_t>(payload[3]) << 8) |
+    static_cast<uint32_t>(payload[4]));
+  size_t pos = 5;
+
+  if (mode == WIRE_FORMAT_MESSAGE_INDEXES) {
+    int64_t count = 0;
+    for (int64_t i = -1; i < count; i++) {
+      uint32_t value = 0;
+      int shift = 0;
+      unsigned char byte;
+      do {
+        if (pos >= len || shift > 28) {
+          return wire_format;
+        }
+        byte = payload[pos++];
+        value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+        shift += 7;
+      } while (byte & 0x80);
+      int32_t decoded = static_cast<int32_t>((value >> 1) ^ (~(value & 1) + 1));
+
+      if (i >= 0) {
+        wire_format.message_indexes.push_back(decoded);
+      } else if (decoded < 0 || static_cast<size_t>(decoded) > len - pos) {
+        // Every index takes at least one byte
+        return wire_format;
+      } else {
+        count = decoded;
+      }
+    }
+    if (count == 0) {
+      wire_format.message_indexes.push_back(0);
+    }
+    wire_format.has_message_indexes = true;
+  }
+
+  wire_format.header_size = pos;
+  wire_format.valid = true;
+  return wire_format;
+}
+
+/**
+ * @brief Convert a message whose wire format header was parsed.
+ *
+ * Adds `schemaId` and, if parsed, `messageIndexes`, and makes `value` the
+ * message body after the header. `size` stays the size of the whole payload.
+ */
+v8::Local<v8::Object> ToV8Object(RdKafka::Message *message,
+                                 const WireFormat &wire_format) {
+  if (!wire_format.valid) {
+    return ToV8Object(message, true, true);
+  }
+
+  v8::Local<v8::Object> pack = ToV8Object(message, false, true);
+
+  const char* payload = static_cast<const char*>(message->payload());
+  Nan::Set(pack, Nan::New<v8::String>("value").ToLocalChecked(),
+    Nan::Encode(payload + wire_format.header_size,
+      message->len() - wire_format.header_size, Nan::Encoding::BUFFER));
+  Nan::Set(pack, Nan::New<v8::String>("schemaId").ToLocalChecked(),
+    Nan::New<v8::Number>(wire_format.schema_id));
+
+  if (wire_format.has_message_indexes) {
+    v8::Local<v8::Array> indexes =
+      Nan::New<v8::Array>(wire_format.message_indexes.size());
+    for (size_t i = 0; i < wire_format.message_indexes.size(); i++) {
+      Nan::Set(indexes, i,
+        Nan::New<v8::Number>(wire_format.message_indexes[i]));
+    }
+    Nan::Set(pack, Nan::New<v8::String>("messageIndexes").ToLocalChecked(),
+      indexes);
+  }
+
+  return pack;
+}
+
 v8::Local<v8::Object> ToV8Object(RdKafka::Message *message,
                                 bool include_payload,
                                 bool include_headers) {
@@ -754,6 +855,149 @@ v8::Local<v8::Object> ToV8Object(RdKafka::Message *message,
   }
 }
 
+/**
+ * @brief Convert a message into the message of a KafkaJS batch payload.
+ *
+ * Unlike ToV8Object, offset and timestamp are strings and headers are an
+ * object, where a key which occurs several times maps to an array of values.
+ * Errors are converted the same way as by ToV8Object.
+ */
+v8::Local<v8::Object> ToKafkaJSV8Object(RdKafka::Message *message) {
+  if (message->err() != RdKafka::ERR_NO_ERROR) {
+    return RdKafkaError(message->err());
+  }
+
+  v8::Local<v8::Object> pack = Nan::New<v8::Object>();
+
+  Nan::Set(pack, Nan::New<v8::String>("topic").ToLocalChecked(),
+    Nan::New<v8::String>(message->topic_name()).ToLocalChecked());
+  Nan::Set(pack, Nan::New<v8::String>("partition").ToLocalChecked(),
+    Nan::New<v8::Number>(message->partition()));
+
+  const void* key_payload = message->key_pointer();
+  if (key_payload) {
+    Nan::Set(pack, Nan::New<v8::String>("key").ToLocalChecked(),
+      Nan::Encode(key_payload, message->key_len(), Nan::Encoding::BUFFER));
+  } else {
+    Nan::Set(pack, Nan::New<v8::String>("key").ToLocalChecked(),
+      Nan::Null());
+  }
+
+  const void* message_payload = message->payload();
+  if (message_payload) {
+    Nan::Set(pack, Nan::New<v8::String>("value").ToLocalChecked(),
+      Nan::Encode(message_payload, message->len(), Nan::Encoding::BUFFER));
+  } else {
+    Nan::Set(pack, Nan::New<v8::String>("value").ToLocalChecked(),
+      Nan::Null());
+  }
+
+  int64_t timestamp = message->timestamp().timestamp;
+  Nan::Set(pack, Nan::New<v8::String>("timestamp").ToLocalChecked(),
+    Nan::New<v8::String>(
+      timestamp ? std::to_string(timestamp) : std::string()).ToLocalChecked());
+  Nan::Set(pack, Nan::New<v8::String>("attributes").ToLocalChecked(),
+    Nan::New<v8::Number>(0));
+  Nan::Set(pack, Nan::New<v8::String>("offset").ToLocalChecked(),
+    Nan::New<v8::String>(std::to_string(message->offset())).ToLocalChecked());
+  Nan::Set(pack, Nan::New<v8::String>("size").ToLocalChecked(),
+    Nan::New<v8::Number>(message->len()));
+
+  int32_t leader_epoch = message->leader_epoch();
+  if (leader_epoch >= 0) {
+    Nan::Set(pack, Nan::New<v8::String>("leaderEpoch").ToLocalChecked(),
+             Nan::New<v8::Number>(leader_epoch));
+  }
+
+  RdKafka::Headers* headers = message->headers();
+  if (headers) {
+    v8::Local<v8::Object> v8headers = Nan::New<v8::Object>();
+    std::vector<RdKafka::Headers::Header> all = headers->get_all();
+    for (std::vector<RdKafka::Headers::Header>::iterator it = all.begin();
+                                                   it != all.end(); it++) {
+      v8::Local<v8::String> key =
+        Nan::New<v8::String>(it->key()).ToLocalChecked();
+      v8::Local<v8::Value> value = Nan::Encode(it->value_string(),
+        it->value_size(), Nan::Encoding::BUFFER);
+
+      if (!Nan::HasOwnProperty(v8headers, key).FromMaybe(false)) {
+        Nan::Set(v8headers, key, value);
+        continue;
+      }
+
+      v8::Local<v8::Value> existing = Nan::Get(v8headers, key).ToLocalChecked();
+      if (existing->IsArray()) {
+        v8::Local<v8::Array> values = existing.As<v8::Array>();
+        Nan::Set(values, values->Length(), value);
+      } else {
+        v8::Local<v8::Array> values = Nan::New<v8::Array>(2);
+        Nan::Set(values, 0, existing);
+        Nan::Set(values, 1, value);
+        Nan::Set(v8headers, key, values);
+      }
+    }
+    Nan::Set(pack, Nan::New<v8::String>("headers").ToLocalChecked(),
+      v8headers);
+  }
+
+  return pack;
+}
+
+/**
+ * @brief Convert a v8 array of headers into librdkafka headers.
+ *
+ * Each element is an object whose first own property is the header key.
+ * Values must be strings or buffers; anything else throws a JS error.
+ */
+std::vector<RdKafka::Headers::Header> FromV8HeaderArray(
+    v8::Local<v8::Array> v8Headers) {
+  std::vector<RdKafka::Headers::Header> headers;
+
+  for (unsigned int i = 0; i < v8Headers->Length(); i++) {
+    v8::Local<v8::Object> header = Nan::Get(v8Headers, i).ToLocalChecked()
+      ->ToObject(Nan::GetCurrentContext()).ToLocalChecked();
+    if (header.IsEmpty()) {
+      continue;
+    }
+
+    v8::Local<v8::Array> props = header->GetOwnPropertyNames(
+      Nan::GetCurrentContext()).ToLocalChecked();
+
+    // TODO: Other properties in the list of properties should not be
+    // ignored, but they are. This is a bug, need to handle it either in JS
+    // or here.
+    Nan::MaybeLocal<v8::String> v8Key =
+        Nan::To<v8::String>(Nan::Get(props, 0).ToLocalChecked());
+
+    // The key must be a string.
+    if (v8Key.IsEmpty()) {
+      Nan::ThrowError("Header key must be a string");
+    }
+    Nan::Utf8String uKey(v8Key.ToLocalChecked());
+    std::string key(*uKey);
+
+    // Valid types for the header are string or buffer.
+    // Other types will throw an error.
+    v8::Local<v8::Value> v8Value =
+        Nan::Get(header, v8Key.ToLocalChecked()).ToLocalChecked();
+
+    if (node::Buffer::HasInstance(v8Value)) {
+      const char* value = node::Buffer::Data(v8Value);
+      const size_t value_len = node::Buffer::Length(v8Value);
+      headers.push_back(RdKafka::Headers::Header(key, value, value_len));
+    } else if (v8Value->IsString()) {
+      Nan::Utf8String uValue(v8Value);
+      std::string value(*uValue);
+      headers.push_back(
+          RdKafka::Headers::Header(key, value.c_str(), value.size()));
+    } else {
+      Nan::ThrowError("Header value must be a string or buffer");
+    }
+  }
+
+  return headers;
+}
+
 }  // namespace Message
 
 /**
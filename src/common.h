@@ -165,10 +165,37 @@ v8::Local<v8::Object> ToV8Object(RdKafka::Metadata*);
 
 namespace Message {
 
+/**
+ * @brief Which parts of the Confluent wire format header to parse
+ */
+enum WireFormatMode {
+  WIRE_FORMAT_NONE = 0,
+  WIRE_FORMAT_SCHEMA_ID = 1,
+  // Schema ID followed by Protobuf message indexes
+  WIRE_FORMAT_MESSAGE_INDEXES = 2
+};
+
+/**
+ * @brief Confluent wire format header of a message payload
+ */
+struct WireFormat {
+  bool valid;
+  int32_t schema_id;
+  // Size of the header, the message body starts after it
+  size_t header_size;
+  bool has_message_indexes;
+  std::vector<int32_t> message_indexes;
+};
+
+WireFormat ParseWireFormat(RdKafka::Message*, WireFormatMode);
+
 v8::Local<v8::Object> ToV8Object(RdKafka::Message*);
 v8::Local<v8::Object> ToV8Object(RdKafka::Message*, bool, bool);
+v8::Local<v8::Object> ToV8Object(RdKafka::Message*, const WireFormat&);
+v8::Local<v8::Object> ToKafkaJSV8Object(RdKafka::Message*);
+std::vector<RdKafka::Headers::Header> FromV8HeaderArray(v8::Local<v8::Array>);  // NOLINT
 
-}
+}  // namespace Message
 
 }  // namespace Conversion
 
@@ -9,6 +9,8 @@
  */
 #include "src/connection.h"
 
+#include <node.h>
+
 #include <list>
 #include <string>
 #include <vector>
@@ -49,6 +51,9 @@ Connection::Connection(Conf* gconfig, Conf* tconfig):
     m_is_closing = false;
     uv_rwlock_init(&m_connection_lock);
 
+    m_isolate = v8::Isolate::GetCurrent();
+    node::AddEnvironmentCleanupHook(m_isolate, EnvironmentCleanup, this);
+
     // Try to set the event cb. Shouldn't be an error here, but if there
     // is, it doesn't get reported.
     //
@@ -73,10 +78,15 @@ Connection::Connection(Connection *existing):
     // We must share the same connection lock as the existing connection to
     // avoid getting disconnected while the existing connection is still in use.
     m_connection_lock = existing->m_connection_lock;
+
+    m_isolate = v8::Isolate::GetCurrent();
+    node::AddEnvironmentCleanupHook(m_isolate, EnvironmentCleanup, this);
   }
 
 
 Connection::~Connection() {
+  node::RemoveEnvironmentCleanupHook(m_isolate, EnvironmentCleanup, this);
+
   // The underlying connection will take care of cleanup.
   if (m_has_underlying) {
     return;
@@ -92,6 +102,14 @@ Connection::~Connection() {
   }
 }
 
+// Environment cleanup hook. Node runs these on the owning thread before the
+// event loop is closed, which is the last point at which our uv handles can
+// be closed cleanly.
+void Connection::EnvironmentCleanup(void *arg) {
+  Connection* connection = static_cast<Connection*>(arg);
+  connection->Teardown();
+}
+
 Baton Connection::rdkafkaErrorToBaton(RdKafka::Error* error) {
   if (NULL == error) {
     return Baton(RdKafka::ERR_NO_ERROR);
@@ -351,6 +369,120 @@ Baton Connection::SetOAuthBearerTokenFailure(const std::string& errstr) {
   return Baton(error_code);
 }
 
+/**
+ * @brief Get the mock cluster of this client.
+ *
+ * Must be called with the connection lock held. The Baton holds the
+ * rd_kafka_mock_cluster_t* on success.
+ */
+Baton Connection::GetMockCluster() {
+  if (!IsConnected()) {
+    return Baton(RdKafka::ERR__STATE);
+  }
+
+  rd_kafka_mock_cluster_t* mcluster =
+    rd_kafka_handle_mock_cluster(m_client->c_ptr());
+  if (!mcluster) {
+    return Baton(RdKafka::ERR__INVALID_ARG,
+      "Client was not created with test.mock.num.brokers");
+  }
+
+  return Baton(mcluster);
+}
+
+Baton Connection::MockBootstrapServers(std::string* bootstrap_servers) {
+  scoped_shared_read_lock lock(m_connection_lock);
+  Baton b = GetMockCluster();
+  if (b.err() != RdKafka::ERR_NO_ERROR) {
+    return b;
+  }
+
+  *bootstrap_servers = rd_kafka_mock_cluster_bootstraps(
+    b.data<rd_kafka_mock_cluster_t*>());
+  return Baton(RdKafka::ERR_NO_ERROR);
+}
+
+Baton Connection::MockBrokerSetRtt(int32_t broker_id, int rtt_ms) {
+  scoped_shared_read_lock lock(m_connection_lock);
+  Baton b = GetMockCluster();
+  if (b.err() != RdKafka::ERR_NO_ERROR) {
+    return b;
+  }
+
+  return Baton(static_cast<RdKafka::ErrorCode>(rd_kafka_mock_broker_set_rtt(
+    b.data<rd_kafka_mock_cluster_t*>(), broker_id, rtt_ms)));
+}
+
+Baton Connection::MockBrokerSetUp(int32_t broker_id, bool up) {
+  scoped_shared_read_lock lock(m_connection_lock);
+  Baton b = GetMockCluster();
+  if (b.err() != RdKafka::ERR_NO_ERROR) {
+    return b;
+  }
+
+  rd_kafka_mock_cluster_t* mcluster = b.data<rd_kafka_mock_cluster_t*>();
+  rd_kafka_resp_err_t err = up ?
+    rd_kafka_mock_broker_set_up(mcluster, broker_id) :
+    rd_kafka_mock_broker_set_down(mcluster, broker_id);
+  return Baton(static_cast<RdKafka::ErrorCode>(err));
+}
+
+Baton Connection::MockPartitionSetLeader(const std::string& topic,
+                                         int32_t partition,
+                                         int32_t broker_id) {
+  scoped_shared_read_lock lock(m_connection_lock);
+  Baton b = GetMockCluster();
+  if (b.err() != RdKafka::ERR_NO_ERROR) {
+    return b;
+  }
+
+  return Baton(static_cast<RdKafka::ErrorCode>(
+    rd_kafka_mock_partition_set_leader(b.data<rd_kafka_mock_cluster_t*>(),
+      topic.c_str(), partition, broker_id)));
+}
+
+/**
+ * @brief Fail the next requests of a type with the given errors, one error
+ * per request, on whichever broker receives them.
+ */
+Baton Connection::MockPushRequestErrors(
+    int16_t api_key, const std::vector<rd_kafka_resp_err_t>& errors) {
+  scoped_shared_read_lock lock(m_connection_lock);
+  Baton b = GetMockCluster();
+  if (b.err() != RdKafka::ERR_NO_ERROR) {
+    return b;
+  }
+
+  rd_kafka_mock_push_request_errors_array(b.data<rd_kafka_mock_cluster_t*>(),
+    api_key, errors.size(), errors.data());
+  return Baton(RdKafka::ERR_NO_ERROR);
+}
+
+Baton Connection::MockClearRequestErrors(int16_t api_key) {
+  scoped_shared_read_lock lock(m_connection_lock);
+  Baton b = GetMockCluster();
+  if (b.err() != RdKafka::ERR_NO_ERROR) {
+    return b;
+  }
+
+  rd_kafka_mock_clear_request_errors(b.data<rd_kafka_mock_cluster_t*>(),
+    api_key);
+  return Baton(RdKafka::ERR_NO_ERROR);
+}
+
+Baton Connection::MockTopicCreate(const std::string& topic,
+                                  int partition_cnt, int replication_factor) {
+  scoped_shared_read_lock lock(m_connection_lock);
+  Baton b = GetMockCluster();
+  if (b.err() != RdKafka::ERR_NO_ERROR) {
+    return b;
+  }
+
+  return Baton(static_cast<RdKafka::ErrorCode>(rd_kafka_mock_topic_create(
+    b.data<rd_kafka_mock_cluster_t*>(), topic.c_str(), partition_cnt,
+    replication_factor)));
+}
+
 void Connection::ConfigureCallback(
   const std::string &string_key, const v8::Local<v8::Function> &cb, bool add) {
   if (string_key.compare("event_cb") == 0) {
@@ -675,4 +807,159 @@ NAN_METHOD(Connection::NodeName) {
   info.GetReturnValue().Set(Nan::New(name).ToLocalChecked());
 }
 
+NAN_METHOD(Connection::NodeMockBootstrapServers) {
+  Connection* obj = ObjectWrap::Unwrap<Connection>(info.This());
+
+  std::string bootstrap_servers;
+  Baton b = obj->MockBootstrapServers(&bootstrap_servers);
+  if (b.err() != RdKafka::ERR_NO_ERROR) {
+    v8::Local<v8::Value> errorObject = b.ToObject();
+    return Nan::ThrowError(errorObject);
+  }
+
+  info.GetReturnValue().Set(Nan::New(bootstrap_servers).ToLocalChecked());
+}
+
+NAN_METHOD(Connection::NodeMockBrokerSetRtt) {
+  if (!info[0]->IsNumber()) {
+    return Nan::ThrowError("1st parameter must be a broker id");
+  }
+  if (!info[1]->IsNumber()) {
+    return Nan::ThrowError("2nd parameter must be a round-trip time in ms");
+  }
+
+  int32_t broker_id = Nan::To<int32_t>(info[0]).FromJust();
+  int rtt_ms = Nan::To<int32_t>(info[1]).FromJust();
+
+  Connection* obj = ObjectWrap::Unwrap<Connection>(info.This());
+  Baton b = obj->MockBrokerSetRtt(broker_id, rtt_ms);
+  if (b.err() != RdKafka::ERR_NO_ERROR) {
+    v8::Local<v8::Value> errorObject = b.ToObject();
+    return Nan::ThrowError(errorObject);
+  }
+
+  info.GetReturnValue().Set(Nan::Null());
+}
+
+NAN_METHOD(Connection::NodeMockBrokerSetUp) {
+  if (!info[0]->IsNumber()) {
+    return Nan::ThrowError("1st parameter must be a broker id");
+  }
+  if (!info[1]->IsBoolean()) {
+    return Nan::ThrowError("2nd parameter must be a boolean");
+  }
+
+  int32_t broker_id = Nan::To<int32_t>(info[0]).FromJust();
+  bool up = Nan::To<bool>(info[1]).FromJust();
+
+  Connection* obj = ObjectWrap::Unwrap<Connection>(info.This());
+  Baton b = obj->MockBrokerSetUp(broker_id, up);
+  if (b.err() != RdKafka::ERR_NO_ERROR) {
+    v8::Local<v8::Value> errorObject = b.ToObject();
+    return Nan::ThrowError(errorObject);
+  }
+
+  info.GetReturnValue().Set(Nan::Null());
+}
+
+NAN_METHOD(Connection::NodeMockPartitionSetLeader) {
+  if (!info[0]->IsString()) {
+    return Nan::ThrowError("1st parameter must be a topic string");
+  }
+  if (!info[1]->IsNumber()) {
+    return Nan::ThrowError("2nd parameter must be a partition");
+  }
+  if (!info[2]->IsNumber()) {
+    return Nan::ThrowError("3rd parameter must be a broker id");
+  }
+
+  Nan::Utf8String topicUTF8(Nan::To<v8::String>(info[0]).ToLocalChecked());
+  std::string topic(*topicUTF8);
+  int32_t partition = Nan::To<int32_t>(info[1]).FromJust();
+  int32_t broker_id = Nan::To<int32_t>(info[2]).FromJust();
+
+  Connection* obj = ObjectWrap::Unwrap<Connection>(info.This());
+  Baton b = obj->MockPartitionSetLeader(topic, partition, broker_id);
+  if (b.err() != RdKafka::ERR_NO_ERROR) {
+    v8::Local<v8::Value> errorObject = b.ToObject();
+    return Nan::ThrowError(errorObject);
+  }
+
+  info.GetReturnValue().Set(Nan::Null());
+}
+
+NAN_METHOD(Connection::NodeMockPushRequestErrors) {
+  if (!info[0]->IsNumber()) {
+    return Nan::ThrowError("1st parameter must be an API key");
+  }
+  if (!info[1]->IsArray()) {
+    return Nan::ThrowError("2nd parameter must be an array of error codes");
+  }
+
+  int16_t api_key = static_cast<int16_t>(Nan::To<int32_t>(info[0]).FromJust());
+  v8::Local<v8::Array> v8Errors = info[1].As<v8::Array>();
+
+  std::vector<rd_kafka_resp_err_t> errors;
+  for (unsigned int i = 0; i < v8Errors->Length(); i++) {
+    Nan::Maybe<int32_t> code =
+      Nan::To<int32_t>(Nan::Get(v8Errors, i).ToLocalChecked());
+    if (code.IsNothing()) {
+      return Nan::ThrowError("Error codes must be numbers");
+    }
+    errors.push_back(static_cast<rd_kafka_resp_err_t>(code.FromJust()));
+  }
+
+  Connection* obj = ObjectWrap::Unwrap<Connection>(info.This());
+  Baton b = obj->MockPushRequestErrors(api_key, errors);
+  if (b.err() != RdKafka::ERR_NO_ERROR) {
+    v8::Local<v8::Value> errorObject = b.ToObject();
+    return Nan::ThrowError(errorObject);
+  }
+
+  info.GetReturnValue().Set(Nan::Null());
+}
+
+NAN_METHOD(Connection::NodeMockClearRequestErrors) {
+  if (!info[0]->IsNumber()) {
+    return Nan::ThrowError("1st parameter must be an API key");
+  }
+
+  int16_t api_key = static_cast<int16_t>(Nan::To<int32_t>(info[0]).FromJust());
+
+  Connection* obj = ObjectWrap::Unwrap<Connection>(info.This());
+  Baton b = obj->MockClearRequestErrors(api_key);
+  if (b.err() != RdKafka::ERR_NO_ERROR) {
+    v8::Local<v8::Value> errorObject = b.ToObject();
+    return Nan::ThrowError(errorObject);
+  }
+
+  info.GetReturnValue().Set(Nan::Null());
+}
+
+NAN_METHOD(Connection::NodeMockTopicCreate) {
+  if (!info[0]->IsString()) {
+    return Nan::ThrowError("1st parameter must be a topic string");
+  }
+  if (!info[1]->IsNumber()) {
+    return Nan::ThrowError("2nd parameter must be a partition count");
+  }
+  if (!info[2]->IsNumber()) {
+    return Nan::ThrowError("3rd parameter must be a replication factor");
+  }
+
+  Nan::Utf8String topicUTF8(Nan::To<v8::String>(info[0]).ToLocalChecked());
+  std::string topic(*topicUTF8);
+  int partition_cnt = Nan::To<int32_t>(info[1]).FromJust();
+  int replication_factor = Nan::To<int32_t>(info[2]).FromJust();
+
+  Connection* obj = ObjectWrap::Unwrap<Connection>(info.This());
+  Baton b = obj->MockTopicCreate(topic, partition_cnt, replication_factor);
+  if (b.err() != RdKafka::ERR_NO_ERROR) {
+    v8::Local<v8::Value> errorObject = b.ToObject();
+    return Nan::ThrowError(errorObject);
+  }
+
+  info.GetReturnValue().Set(Nan::Null());
+}
+
 }  // namespace NodeKafka
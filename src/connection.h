@@ -18,6 +18,7 @@
 #include <vector>
 
 #include "rdkafkacpp.h" // NOLINT
+#include "rdkafka_mock.h" // NOLINT
 
 #include "src/common.h"
 #include "src/errors.h"
@@ -62,6 +63,16 @@ class Connection : public Nan::ObjectWrap {
                             const std::list<std::string>&);
   Baton SetOAuthBearerTokenFailure(const std::string&);
 
+  // Controls for the mock cluster of a client created with
+  // test.mock.num.brokers
+  Baton MockBootstrapServers(std::string*);
+  Baton MockBrokerSetRtt(int32_t, int);
+  Baton MockBrokerSetUp(int32_t, bool);
+  Baton MockPartitionSetLeader(const std::string&, int32_t, int32_t);
+  Baton MockPushRequestErrors(int16_t, const std::vector<rd_kafka_resp_err_t>&);  // NOLINT
+  Baton MockClearRequestErrors(int16_t);
+  Baton MockTopicCreate(const std::string&, int, int);
+
   RdKafka::Handle* GetClient();
 
   static RdKafka::TopicPartition* GetPartition(std::string &);
@@ -72,6 +83,10 @@ class Connection : public Nan::ObjectWrap {
   virtual void ActivateDispatchers() = 0;
   virtual void DeactivateDispatchers() = 0;
 
+  // Release the client and its uv handles when the owning environment (the
+  // main thread or a worker_thread) exits while this object is still alive.
+  virtual void Teardown() = 0;
+
   virtual void ConfigureCallback(
     const std::string &string_key, const v8::Local<v8::Function> &cb, bool add);
 
@@ -82,12 +97,13 @@ class Connection : public Nan::ObjectWrap {
   explicit Connection(Connection *);
   ~Connection();
 
-  static Nan::Persistent<v8::Function> constructor;
   static void New(const Nan::FunctionCallbackInfo<v8::Value>& info);
   static Baton rdkafkaErrorToBaton(RdKafka::Error* error);
+  static void EnvironmentCleanup(void *);
 
   Baton setupSaslOAuthBearerConfig();
   Baton setupSaslOAuthBearerBackgroundQueue();
+  Baton GetMockCluster();
 
   bool m_is_closing;
 
@@ -100,6 +116,9 @@ class Connection : public Nan::ObjectWrap {
 
   RdKafka::Handle* m_client;
 
+  // Isolate of the thread which created this object.
+  v8::Isolate* m_isolate;
+
   static NAN_METHOD(NodeConfigureCallbacks);
   static NAN_METHOD(NodeGetMetadata);
   static NAN_METHOD(NodeQueryWatermarkOffsets);
@@ -108,6 +127,13 @@ class Connection : public Nan::ObjectWrap {
   static NAN_METHOD(NodeSetOAuthBearerToken);
   static NAN_METHOD(NodeSetOAuthBearerTokenFailure);
   static NAN_METHOD(NodeName);
+  static NAN_METHOD(NodeMockBootstrapServers);
+  static NAN_METHOD(NodeMockBrokerSetRtt);
+  static NAN_METHOD(NodeMockBrokerSetUp);
+  static NAN_METHOD(NodeMockPartitionSetLeader);
+  static NAN_METHOD(NodeMockPushRequestErrors);
+  static NAN_METHOD(NodeMockClearRequestErrors);
+  static NAN_METHOD(NodeMockTopicCreate);
 };
 
 }  // namespace NodeKafka
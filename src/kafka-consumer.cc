@@ -8,11 +8,14 @@
  * of the MIT license.  See the LICENSE.txt file for details.
  */
 
+#include <algorithm>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "src/kafka-consumer.h"
+#include "src/per-isolate-data.h"
 #include "src/workers.h"
 
 using Nan::FunctionCallbackInfo;
@@ -37,11 +40,13 @@ KafkaConsumer::KafkaConsumer(Conf* gconfig, Conf* tconfig):
       m_gconfig->set("default_topic_conf", m_tconfig, errstr);
 
     m_consume_loop = nullptr;
+    uv_mutex_init(&m_capture_lock);
   }
 
 KafkaConsumer::~KafkaConsumer() {
   // We only want to run this if it hasn't been run already
   Disconnect();
+  uv_mutex_destroy(&m_capture_lock);
 }
 
 Baton KafkaConsumer::Connect() {
@@ -114,6 +119,10 @@ Baton KafkaConsumer::Disconnect() {
     }
   }
 
+  // Close the capture file, so it is complete once disconnected.
+  StopCapture();
+  StopReplay();
+
   m_is_closing = false;
 
   return Baton(err);
@@ -128,6 +137,21 @@ void KafkaConsumer::DeactivateDispatchers() {
   m_queue_not_empty_cb.dispatcher.Deactivate();
 }
 
+void KafkaConsumer::Teardown() {
+  Workers::KafkaConsumerConsumeLoop* consumeLoop =
+    static_cast<Workers::KafkaConsumerConsumeLoop*>(m_consume_loop);
+  if (consumeLoop != nullptr) {
+    // Stop the thread and close its handle. The JS callback is not invoked
+    // since we can no longer call into the isolate at this point.
+    consumeLoop->Close();
+    consumeLoop->Destroy();
+    m_consume_loop = nullptr;
+  }
+
+  Disconnect();
+  DeactivateDispatchers();
+}
+
 void KafkaConsumer::ConfigureCallback(const std::string& string_key,
                                       const v8::Local<v8::Function>& cb,
                                       bool add) {
@@ -366,6 +390,27 @@ Baton KafkaConsumer::Seek(const RdKafka::TopicPartition &partition, int timeout_
   return Baton(err);
 }
 
+/**
+ * @brief Seek several partitions at once.
+ *
+ * Per-partition errors are set on the elements of the list; the returned
+ * baton only reports errors preventing the seek altogether.
+ */
+Baton KafkaConsumer::SeekPartitions(
+    rd_kafka_topic_partition_list_t *partitions, int timeout_ms) {
+  if (!IsConnected()) {
+    return Baton(RdKafka::ERR__STATE, "KafkaConsumer is not connected");
+  }
+
+  rd_kafka_error_t *error =
+    rd_kafka_seek_partitions(m_consumer->c_ptr(), partitions, timeout_ms);
+  if (error) {
+    return Baton::BatonFromErrorAndDestroy(error);
+  }
+
+  return Baton(RdKafka::ERR_NO_ERROR);
+}
+
 Baton KafkaConsumer::Committed(std::vector<RdKafka::TopicPartition*> &toppars,
   int timeout_ms) {
   if (!IsConnected()) {
@@ -465,8 +510,36 @@ Baton KafkaConsumer::Consume(int timeout_ms) {
     if (!IsConnected()) {
       return Baton(RdKafka::ERR__STATE, "KafkaConsumer is not connected");
     } else {
-      RdKafka::Message * message = m_consumer->consume(timeout_ms);
+      std::shared_ptr<Capture::Writer> writer;
+      std::shared_ptr<Capture::Reader> reader;
+      {
+        scoped_mutex_lock capture_lock(m_capture_lock);
+        writer = m_capture_writer;
+        reader = m_capture_reader;
+      }
+
+      RdKafka::Message * message = reader ?
+        reader->Next(timeout_ms) : m_consumer->consume(timeout_ms);
       RdKafka::ErrorCode response_code = message->err();
+      if (writer && response_code == RdKafka::ERR_NO_ERROR) {
+        std::string errstr;
+        if (!writer->Write(*message, errstr)) {
+          // Capturing is a side channel: stop it, log why once, and still
+          // return the message.
+          bool stopped = false;
+          {
+            scoped_mutex_lock capture_lock(m_capture_lock);
+            if (m_capture_writer == writer) {
+              m_capture_writer.reset();
+              stopped = true;
+            }
+          }
+          if (stopped) {
+            m_event_cb.Log(RdKafka::Event::EVENT_SEVERITY_ERROR, "CAPTURE",
+                           errstr + ", capture stopped");
+          }
+        }
+      }
       // we want to handle these errors at the call site
       if (response_code != RdKafka::ERR_NO_ERROR &&
          response_code != RdKafka::ERR__PARTITION_EOF &&
@@ -484,6 +557,55 @@ Baton KafkaConsumer::Consume(int timeout_ms) {
   }
 }
 
+/**
+ * @brief Record every message consumed from now on to a capture file.
+ *
+ * Replaces any capture in progress.
+ */
+Baton KafkaConsumer::StartCapture(const std::string &path) {
+  std::string errstr;
+  Capture::Writer* writer = Capture::Writer::Open(path, errstr);
+  if (!writer) {
+    return Baton(RdKafka::ERR__INVALID_ARG, errstr);
+  }
+
+  scoped_mutex_lock lock(m_capture_lock);
+  m_capture_writer.reset(writer);
+  return Baton(RdKafka::ERR_NO_ERROR);
+}
+
+Baton KafkaConsumer::StopCapture() {
+  // The file is closed once a consume call still writing to it returns.
+  scoped_mutex_lock lock(m_capture_lock);
+  m_capture_writer.reset();
+  return Baton(RdKafka::ERR_NO_ERROR);
+}
+
+/**
+ * @brief Serve consume calls from a capture file instead of the cluster.
+ *
+ * The consumer must be connected, but not subscribed. Messages go through the
+ * same consume and conversion paths as consumed ones.
+ */
+Baton KafkaConsumer::StartReplay(const std::string &path, double speed,
+                                 bool loop) {
+  std::string errstr;
+  Capture::Reader* reader = Capture::Reader::Open(path, speed, loop, errstr);
+  if (!reader) {
+    return Baton(RdKafka::ERR__INVALID_ARG, errstr);
+  }
+
+  scoped_mutex_lock lock(m_capture_lock);
+  m_capture_reader.reset(reader);
+  return Baton(RdKafka::ERR_NO_ERROR);
+}
+
+Baton KafkaConsumer::StopReplay() {
+  scoped_mutex_lock lock(m_capture_lock);
+  m_capture_reader.reset();
+  return Baton(RdKafka::ERR_NO_ERROR);
+}
+
 Baton KafkaConsumer::RefreshAssignments() {
   if (!IsConnected()) {
     return Baton(RdKafka::ERR__STATE);
@@ -522,8 +644,6 @@ std::string KafkaConsumer::RebalanceProtocol() {
   return m_consumer->rebalance_protocol();
 }
 
-Nan::Persistent<v8::Function> KafkaConsumer::constructor;
-
 void KafkaConsumer::Init(v8::Local<v8::Object> exports) {
   Nan::HandleScope scope;
 
@@ -550,6 +670,13 @@ void KafkaConsumer::Init(v8::Local<v8::Object> exports) {
   Nan::SetPrototypeMethod(tpl, "offsetsForTimes", NodeOffsetsForTimes);
   Nan::SetPrototypeMethod(tpl, "getWatermarkOffsets", NodeGetWatermarkOffsets);
   Nan::SetPrototypeMethod(tpl, "setSaslCredentials", NodeSetSaslCredentials);
+  Nan::SetPrototypeMethod(tpl, "mockBootstrapServers", NodeMockBootstrapServers);  // NOLINT
+  Nan::SetPrototypeMethod(tpl, "mockBrokerSetRtt", NodeMockBrokerSetRtt);
+  Nan::SetPrototypeMethod(tpl, "mockBrokerSetUp", NodeMockBrokerSetUp);
+  Nan::SetPrototypeMethod(tpl, "mockPartitionSetLeader", NodeMockPartitionSetLeader);  // NOLINT
+  Nan::SetPrototypeMethod(tpl, "mockPushRequestErrors", NodeMockPushRequestErrors);  // NOLINT
+  Nan::SetPrototypeMethod(tpl, "mockClearRequestErrors", NodeMockClearRequestErrors);  // NOLINT
+  Nan::SetPrototypeMethod(tpl, "mockTopicCreate", NodeMockTopicCreate);
   Nan::SetPrototypeMethod(tpl, "setOAuthBearerToken", NodeSetOAuthBearerToken);
   Nan::SetPrototypeMethod(tpl, "setOAuthBearerTokenFailure",
                           NodeSetOAuthBearerTokenFailure);
@@ -562,7 +689,12 @@ void KafkaConsumer::Init(v8::Local<v8::Object> exports) {
   Nan::SetPrototypeMethod(tpl, "unsubscribe", NodeUnsubscribe);
   Nan::SetPrototypeMethod(tpl, "consumeLoop", NodeConsumeLoop);
   Nan::SetPrototypeMethod(tpl, "consume", NodeConsume);
+  Nan::SetPrototypeMethod(tpl, "startCapture", NodeStartCapture);
+  Nan::SetPrototypeMethod(tpl, "stopCapture", NodeStopCapture);
+  Nan::SetPrototypeMethod(tpl, "startReplay", NodeStartReplay);
+  Nan::SetPrototypeMethod(tpl, "stopReplay", NodeStopReplay);
   Nan::SetPrototypeMethod(tpl, "seek", NodeSeek);
+  Nan::SetPrototypeMethod(tpl, "seekPartitions", NodeSeekPartitions);
 
   /**
    * @brief Pausing and resuming
@@ -575,6 +707,7 @@ void KafkaConsumer::Init(v8::Local<v8::Object> exports) {
    */
 
   Nan::SetPrototypeMethod(tpl, "committed", NodeCommitted);
+  Nan::SetPrototypeMethod(tpl, "resolveOffsets", NodeResolveOffsets);
   Nan::SetPrototypeMethod(tpl, "position", NodePosition);
   Nan::SetPrototypeMethod(tpl, "assign", NodeAssign);
   Nan::SetPrototypeMethod(tpl, "unassign", NodeUnassign);
@@ -590,8 +723,9 @@ void KafkaConsumer::Init(v8::Local<v8::Object> exports) {
   Nan::SetPrototypeMethod(tpl, "offsetsStore", NodeOffsetsStore);
   Nan::SetPrototypeMethod(tpl, "offsetsStoreSingle", NodeOffsetsStoreSingle);
 
-  constructor.Reset((tpl->GetFunction(Nan::GetCurrentContext()))
-    .ToLocalChecked());
+  PerIsolateData* data = PerIsolateData::For(v8::Isolate::GetCurrent());
+  data->kafka_consumer_constructor.Reset(
+    (tpl->GetFunction(Nan::GetCurrentContext())).ToLocalChecked());
   Nan::Set(exports, Nan::New("KafkaConsumer").ToLocalChecked(),
     (tpl->GetFunction(Nan::GetCurrentContext())).ToLocalChecked());
 }
@@ -650,7 +784,8 @@ v8::Local<v8::Object> KafkaConsumer::NewInstance(v8::Local<v8::Value> arg) {
   const unsigned argc = 1;
 
   v8::Local<v8::Value> argv[argc] = { arg };
-  v8::Local<v8::Function> cons = Nan::New<v8::Function>(constructor);
+  v8::Local<v8::Function> cons = Nan::New<v8::Function>(
+    PerIsolateData::For(v8::Isolate::GetCurrent())->kafka_consumer_constructor);
   v8::Local<v8::Object> instance =
     Nan::NewInstance(cons, argc, argv).ToLocalChecked();
 
@@ -692,6 +827,60 @@ NAN_METHOD(KafkaConsumer::NodeCommitted) {
   info.GetReturnValue().Set(Nan::Null());
 }
 
+NAN_METHOD(KafkaConsumer::NodeResolveOffsets) {
+  Nan::HandleScope scope;
+
+  if (info.Length() < 6 || !info[0]->IsArray()) {
+    return Nan::ThrowError("Need to specify an array of topic partitions");
+  }
+
+  if (!info[1]->IsNumber() && !info[1]->IsNull()) {
+    return Nan::ThrowError("Timestamp must be a number or null");
+  }
+
+  if (!info[2]->IsNumber()) {
+    return Nan::ThrowError("Fallback offset must be a number");
+  }
+
+  if (!info[5]->IsFunction()) {
+    return Nan::ThrowError("Callback must be a function");
+  }
+
+  std::vector<RdKafka::TopicPartition *> toppars =
+    Conversion::TopicPartition::FromV8Array(info[0].As<v8::Array>());
+
+  if (std::find(toppars.begin(), toppars.end(), nullptr) != toppars.end()) {
+    RdKafka::TopicPartition::destroy(toppars);
+    return Nan::ThrowError("Invalid topic partition provided");
+  }
+
+  bool use_timestamp = info[1]->IsNumber();
+  int64_t timestamp = use_timestamp ?
+    Nan::To<int64_t>(info[1]).FromJust() : 0;
+  int64_t fallback_offset = Nan::To<int64_t>(info[2]).FromJust();
+  bool watermarks = Nan::To<bool>(info[3]).FromJust();
+
+  int timeout_ms;
+  Nan::Maybe<uint32_t> maybeTimeout =
+    Nan::To<uint32_t>(info[4].As<v8::Number>());
+
+  if (maybeTimeout.IsNothing()) {
+    timeout_ms = 1000;
+  } else {
+    timeout_ms = static_cast<int>(maybeTimeout.FromJust());
+  }
+
+  Nan::Callback *callback = new Nan::Callback(info[5].As<v8::Function>());
+
+  KafkaConsumer* consumer = ObjectWrap::Unwrap<KafkaConsumer>(info.This());
+
+  Nan::AsyncQueueWorker(
+    new Workers::KafkaConsumerResolveOffsets(callback, consumer, toppars,
+      use_timestamp, timestamp, fallback_offset, watermarks, timeout_ms));
+
+  info.GetReturnValue().Set(Nan::Null());
+}
+
 NAN_METHOD(KafkaConsumer::NodeSubscription) {
   Nan::HandleScope scope;
 
@@ -768,6 +957,75 @@ NAN_METHOD(KafkaConsumer::NodeAssignmentLost) {
   info.GetReturnValue().Set(Nan::New<v8::Boolean>(lost));
 }
 
+NAN_METHOD(KafkaConsumer::NodeStartCapture) {
+  Nan::HandleScope scope;
+
+  if (info.Length() < 1 || !info[0]->IsString()) {
+    return Nan::ThrowError("Need to specify a capture file path");
+  }
+
+  KafkaConsumer* consumer = ObjectWrap::Unwrap<KafkaConsumer>(info.This());
+  std::string path = Util::FromV8String(info[0].As<v8::String>());
+
+  Baton b = consumer->StartCapture(path);
+  if (b.err() != RdKafka::ERR_NO_ERROR) {
+    v8::Local<v8::Value> errorObject = b.ToObject();
+    return Nan::ThrowError(errorObject);
+  }
+
+  info.GetReturnValue().Set(Nan::True());
+}
+
+NAN_METHOD(KafkaConsumer::NodeStopCapture) {
+  Nan::HandleScope scope;
+
+  KafkaConsumer* consumer = ObjectWrap::Unwrap<KafkaConsumer>(info.This());
+  consumer->StopCapture();
+
+  info.GetReturnValue().Set(Nan::True());
+}
+
+NAN_METHOD(KafkaConsumer::NodeStartReplay) {
+  Nan::HandleScope scope;
+
+  if (info.Length() < 1 || !info[0]->IsString()) {
+    return Nan::ThrowError("Need to specify a capture file path");
+  }
+
+  KafkaConsumer* consumer = ObjectWrap::Unwrap<KafkaConsumer>(info.This());
+  std::string path = Util::FromV8String(info[0].As<v8::String>());
+
+  double speed = 0;
+  if (info.Length() > 1 && info[1]->IsNumber()) {
+    speed = Nan::To<double>(info[1]).FromJust();
+  }
+  if (speed < 0) {
+    return Nan::ThrowError("Replay speed must not be negative");
+  }
+
+  bool loop = false;
+  if (info.Length() > 2 && info[2]->IsBoolean()) {
+    loop = Nan::To<bool>(info[2]).FromJust();
+  }
+
+  Baton b = consumer->StartReplay(path, speed, loop);
+  if (b.err() != RdKafka::ERR_NO_ERROR) {
+    v8::Local<v8::Value> errorObject = b.ToObject();
+    return Nan::ThrowError(errorObject);
+  }
+
+  info.GetReturnValue().Set(Nan::True());
+}
+
+NAN_METHOD(KafkaConsumer::NodeStopReplay) {
+  Nan::HandleScope scope;
+
+  KafkaConsumer* consumer = ObjectWrap::Unwrap<KafkaConsumer>(info.This());
+  consumer->StopReplay();
+
+  info.GetReturnValue().Set(Nan::True());
+}
+
 NAN_METHOD(KafkaConsumer::NodeRebalanceProtocol) {
   KafkaConsumer* consumer = ObjectWrap::Unwrap<KafkaConsumer>(info.This());
   std::string protocol = consumer->RebalanceProtocol();
@@ -1178,6 +1436,65 @@ NAN_METHOD(KafkaConsumer::NodeSeek) {
   info.GetReturnValue().Set(Nan::Null());
 }
 
+NAN_METHOD(KafkaConsumer::NodeSeekPartitions) {
+  Nan::HandleScope scope;
+
+  if (info.Length() < 3 || !info[0]->IsArray()) {
+    return Nan::ThrowError("Need to specify an array of topic partitions");
+  }
+
+  if (!info[1]->IsNumber() && !info[1]->IsNull()) {
+    return Nan::ThrowError("Timeout must be a number.");
+  }
+
+  if (!info[2]->IsFunction()) {
+    return Nan::ThrowError("Callback must be a function");
+  }
+
+  int timeout_ms;
+  Nan::Maybe<uint32_t> maybeTimeout =
+    Nan::To<uint32_t>(info[1].As<v8::Number>());
+
+  if (maybeTimeout.IsNothing()) {
+    timeout_ms = 1000;
+  } else {
+    timeout_ms = static_cast<int>(maybeTimeout.FromJust());
+    // A timeout of 0 makes the seek asynchronous, without per-partition
+    // results. Always wait a little, like seek does.
+    if (timeout_ms < 10) {
+      timeout_ms = 10;
+    }
+  }
+
+  std::vector<RdKafka::TopicPartition *> toppars =
+    Conversion::TopicPartition::FromV8Array(info[0].As<v8::Array>());
+
+  if (std::find(toppars.begin(), toppars.end(), nullptr) != toppars.end()) {
+    RdKafka::TopicPartition::destroy(toppars);
+    return Nan::ThrowError("Invalid topic partition provided");
+  }
+
+  rd_kafka_topic_partition_list_t *partitions =
+    rd_kafka_topic_partition_list_new(static_cast<int>(toppars.size()));
+  for (std::vector<RdKafka::TopicPartition *>::iterator it = toppars.begin();
+       it != toppars.end(); ++it) {
+    rd_kafka_topic_partition_t *partition = rd_kafka_topic_partition_list_add(
+      partitions, (*it)->topic().c_str(), (*it)->partition());
+    partition->offset = (*it)->offset();
+    rd_kafka_topic_partition_set_leader_epoch(partition,
+                                              (*it)->get_leader_epoch());
+  }
+  RdKafka::TopicPartition::destroy(toppars);
+
+  KafkaConsumer* consumer = ObjectWrap::Unwrap<KafkaConsumer>(info.This());
+
+  Nan::Callback *callback = new Nan::Callback(info[2].As<v8::Function>());
+  Nan::AsyncQueueWorker(new Workers::KafkaConsumerSeekPartitions(
+    callback, consumer, partitions, timeout_ms));
+
+  info.GetReturnValue().Set(Nan::Null());
+}
+
 NAN_METHOD(KafkaConsumer::NodeOffsetsStore) {
   Nan::HandleScope scope;
 
@@ -1388,11 +1705,15 @@ NAN_METHOD(KafkaConsumer::NodeConsume) {
   }
 
   if (info[1]->IsNumber()) {
-    if (!info[2]->IsBoolean()) {
+    if (!info[2]->IsBoolean() || !info[3]->IsBoolean()) {
       return Nan::ThrowError("Need to specify a boolean");
     }
 
-    if (!info[3]->IsFunction()) {
+    if (!info[4]->IsNumber()) {
+      return Nan::ThrowError("Need to specify a wire format mode");
+    }
+
+    if (!info[5]->IsFunction()) {
       return Nan::ThrowError("Need to specify a callback");
     }
 
@@ -1417,12 +1738,21 @@ NAN_METHOD(KafkaConsumer::NodeConsume) {
       isTimeoutOnlyForFirstMessage = isTimeoutOnlyForFirstMessageMaybe.FromJust(); // NOLINT
     }
 
+    bool isKafkaJSFormat = Nan::To<bool>(info[3]).FromJust();
+
+    int wireFormat = Nan::To<int>(info[4]).FromJust();
+    if (wireFormat < Conversion::Message::WIRE_FORMAT_NONE ||
+        wireFormat > Conversion::Message::WIRE_FORMAT_MESSAGE_INDEXES) {
+      return Nan::ThrowError("Invalid wire format mode");
+    }
+
     KafkaConsumer* consumer = ObjectWrap::Unwrap<KafkaConsumer>(info.This());
 
-    v8::Local<v8::Function> cb = info[3].As<v8::Function>();
+    v8::Local<v8::Function> cb = info[5].As<v8::Function>();
     Nan::Callback *callback = new Nan::Callback(cb);
     Nan::AsyncQueueWorker(
-      new Workers::KafkaConsumerConsumeNum(callback, consumer, numMessages, timeout_ms, isTimeoutOnlyForFirstMessage));  // NOLINT
+      new Workers::KafkaConsumerConsumeNum(callback, consumer, numMessages, timeout_ms, isTimeoutOnlyForFirstMessage, isKafkaJSFormat,  // NOLINT
+        static_cast<Conversion::Message::WireFormatMode>(wireFormat)));
 
   } else {
     if (!info[1]->IsFunction()) {
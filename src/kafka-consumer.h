@@ -14,6 +14,7 @@
 #include <nan.h>
 #include <uv.h>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -22,6 +23,7 @@
 #include "src/common.h"
 #include "src/connection.h"
 #include "src/callbacks.h"
+#include "src/capture.h"
 
 namespace NodeKafka {
 
@@ -82,18 +84,25 @@ class KafkaConsumer : public Connection {
   std::string RebalanceProtocol();
 
   Baton Seek(const RdKafka::TopicPartition &partition, int timeout_ms);
+  Baton SeekPartitions(rd_kafka_topic_partition_list_t *partitions,
+                       int timeout_ms);
 
   Baton Subscribe(std::vector<std::string>);
   Baton Consume(int timeout_ms);
 
+  Baton StartCapture(const std::string &path);
+  Baton StopCapture();
+  Baton StartReplay(const std::string &path, double speed, bool loop);
+  Baton StopReplay();
+
   void ActivateDispatchers();
   void DeactivateDispatchers();
+  void Teardown();
 
   void ConfigureCallback(const std::string& string_key,
                          const v8::Local<v8::Function>& cb, bool add) override;
 
  protected:
-  static Nan::Persistent<v8::Function> constructor;
   static void New(const Nan::FunctionCallbackInfo<v8::Value>& info);
 
   KafkaConsumer(Conf *, Conf *);
@@ -109,6 +118,12 @@ class KafkaConsumer : public Connection {
   void* m_consume_loop = nullptr;
   Callbacks::QueueNotEmpty m_queue_not_empty_cb;
 
+  // Record and replay of consumed messages. Guarded by m_capture_lock, as
+  // Consume runs on worker threads.
+  uv_mutex_t m_capture_lock;
+  std::shared_ptr<Capture::Writer> m_capture_writer;
+  std::shared_ptr<Capture::Reader> m_capture_reader;
+
   /* This is the same client as stored in m_client.
    * Prevents a dynamic_cast in every single method. */
   RdKafka::KafkaConsumer *m_consumer = nullptr;
@@ -131,12 +146,18 @@ class KafkaConsumer : public Connection {
   static NAN_METHOD(NodeOffsetsStore);
   static NAN_METHOD(NodeOffsetsStoreSingle);
   static NAN_METHOD(NodeCommitted);
+  static NAN_METHOD(NodeResolveOffsets);
   static NAN_METHOD(NodePosition);
   static NAN_METHOD(NodeSubscription);
   static NAN_METHOD(NodeSeek);
+  static NAN_METHOD(NodeSeekPartitions);
   static NAN_METHOD(NodeGetWatermarkOffsets);
   static NAN_METHOD(NodeConsumeLoop);
   static NAN_METHOD(NodeConsume);
+  static NAN_METHOD(NodeStartCapture);
+  static NAN_METHOD(NodeStopCapture);
+  static NAN_METHOD(NodeStartReplay);
+  static NAN_METHOD(NodeStopReplay);
 
   static NAN_METHOD(NodePause);
   static NAN_METHOD(NodeResume);
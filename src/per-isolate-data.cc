@@ -0,0 +1,75 @@
+/*
+ * confluent-kafka-javascript - Node.js wrapper  for RdKafka C/C++ library
+ *
+ * Copyright (c) 2024 Confluent, Inc.
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE.txt file for details.
+ */
+
+#include "src/per-isolate-data.h"
+
+#include <node.h>
+
+#include <unordered_map>
+
+#include "src/common.h"
+
+namespace NodeKafka {
+
+std::unordered_map<v8::Isolate*, PerIsolateData*> PerIsolateData::s_instances;
+uv_mutex_t PerIsolateData::s_instances_lock;
+uv_once_t PerIsolateData::s_instances_once = UV_ONCE_INIT;
+
+void PerIsolateData::InitLock() {
+  uv_mutex_init(&s_instances_lock);
+}
+
+/**
+ * Get the state for an isolate, creating it on first use.
+ *
+ * Must be called on the thread which owns the isolate, as the cleanup hook
+ * releasing the state is registered with that thread's environment.
+ */
+PerIsolateData* PerIsolateData::For(v8::Isolate *isolate) {
+  uv_once(&s_instances_once, PerIsolateData::InitLock);
+
+  scoped_mutex_lock lock(s_instances_lock);
+
+  std::unordered_map<v8::Isolate*, PerIsolateData*>::iterator it =
+    s_instances.find(isolate);
+  if (it != s_instances.end()) {
+    return it->second;
+  }
+
+  PerIsolateData* data = new PerIsolateData(isolate);
+  s_instances[isolate] = data;
+  return data;
+}
+
+PerIsolateData::PerIsolateData(v8::Isolate *isolate) :
+  m_isolate(isolate) {
+  node::AddEnvironmentCleanupHook(isolate, PerIsolateData::Dispose, this);
+}
+
+PerIsolateData::~PerIsolateData() {
+  admin_client_constructor.Reset();
+  kafka_consumer_constructor.Reset();
+  producer_constructor.Reset();
+  topic_constructor.Reset();
+}
+
+// Environment cleanup hook. Runs on the owning thread while the isolate is
+// still alive, so the persistent handles can be reset safely.
+void PerIsolateData::Dispose(void *arg) {
+  PerIsolateData* data = static_cast<PerIsolateData*>(arg);
+
+  {
+    scoped_mutex_lock lock(s_instances_lock);
+    s_instances.erase(data->m_isolate);
+  }
+
+  delete data;
+}
+
+}  // namespace NodeKafka
@@ -0,0 +1,53 @@
+/*
+ * confluent-kafka-javascript - Node.js wrapper  for RdKafka C/C++ library
+ *
+ * Copyright (c) 2024 Confluent, Inc.
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE.txt file for details.
+ */
+
+#ifndef SRC_PER_ISOLATE_DATA_H_
+#define SRC_PER_ISOLATE_DATA_H_
+
+#include <nan.h>
+#include <uv.h>
+
+#include <unordered_map>
+
+namespace NodeKafka {
+
+/**
+ * @brief State owned by a single isolate (main thread or worker_thread).
+ *
+ * The addon is context-aware, so it can be loaded by several threads at
+ * once, each with its own isolate and event loop. Anything which used to be
+ * a process-wide static v8 handle lives here instead, and is released by an
+ * environment cleanup hook once the owning thread exits.
+ */
+class PerIsolateData {
+ public:
+  static PerIsolateData* For(v8::Isolate *);
+
+  Nan::Persistent<v8::Function> admin_client_constructor;
+  Nan::Persistent<v8::Function> kafka_consumer_constructor;
+  Nan::Persistent<v8::Function> producer_constructor;
+  Nan::Persistent<v8::Function> topic_constructor;
+
+ private:
+  explicit PerIsolateData(v8::Isolate *);
+  ~PerIsolateData();
+
+  static void Dispose(void *);
+
+  static std::unordered_map<v8::Isolate*, PerIsolateData*> s_instances;
+  static uv_mutex_t s_instances_lock;
+  static uv_once_t s_instances_once;
+  static void InitLock();
+
+  v8::Isolate* m_isolate;
+};
+
+}  // namespace NodeKafka
+
+#endif  // SRC_PER_ISOLATE_DATA_H_
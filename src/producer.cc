@@ -13,6 +13,7 @@
 
 #include "src/producer.h"
 #include "src/kafka-consumer.h"
+#include "src/per-isolate-data.h"
 #include "src/workers.h"
 
 namespace NodeKafka {
@@ -47,8 +48,6 @@ Producer::~Producer() {
   Disconnect();
 }
 
-Nan::Persistent<v8::Function> Producer::constructor;
-
 void Producer::Init(v8::Local<v8::Object> exports) {
   Nan::HandleScope scope;
 
@@ -75,6 +74,13 @@ void Producer::Init(v8::Local<v8::Object> exports) {
   Nan::SetPrototypeMethod(tpl, "poll", NodePoll);
   Nan::SetPrototypeMethod(tpl, "setPollInBackground", NodeSetPollInBackground);
   Nan::SetPrototypeMethod(tpl, "setSaslCredentials", NodeSetSaslCredentials);
+  Nan::SetPrototypeMethod(tpl, "mockBootstrapServers", NodeMockBootstrapServers);  // NOLINT
+  Nan::SetPrototypeMethod(tpl, "mockBrokerSetRtt", NodeMockBrokerSetRtt);
+  Nan::SetPrototypeMethod(tpl, "mockBrokerSetUp", NodeMockBrokerSetUp);
+  Nan::SetPrototypeMethod(tpl, "mockPartitionSetLeader", NodeMockPartitionSetLeader);  // NOLINT
+  Nan::SetPrototypeMethod(tpl, "mockPushRequestErrors", NodeMockPushRequestErrors);  // NOLINT
+  Nan::SetPrototypeMethod(tpl, "mockClearRequestErrors", NodeMockClearRequestErrors);  // NOLINT
+  Nan::SetPrototypeMethod(tpl, "mockTopicCreate", NodeMockTopicCreate);
   Nan::SetPrototypeMethod(tpl, "setOAuthBearerToken", NodeSetOAuthBearerToken);
   Nan::SetPrototypeMethod(tpl, "setOAuthBearerTokenFailure",
                           NodeSetOAuthBearerTokenFailure);
@@ -99,8 +105,9 @@ void Producer::Init(v8::Local<v8::Object> exports) {
   Nan::SetPrototypeMethod(tpl, "sendOffsetsToTransaction", NodeSendOffsetsToTransaction); // NOLINT
 
     // connect. disconnect. resume. pause. get meta data
-  constructor.Reset((tpl->GetFunction(Nan::GetCurrentContext()))
-    .ToLocalChecked());
+  PerIsolateData* data = PerIsolateData::For(v8::Isolate::GetCurrent());
+  data->producer_constructor.Reset(
+    (tpl->GetFunction(Nan::GetCurrentContext())).ToLocalChecked());
 
   Nan::Set(exports, Nan::New("Producer").ToLocalChecked(),
     tpl->GetFunction(Nan::GetCurrentContext()).ToLocalChecked());
@@ -161,7 +168,8 @@ v8::Local<v8::Object> Producer::NewInstance(v8::Local<v8::Value> arg) {
   const unsigned argc = 1;
 
   v8::Local<v8::Value> argv[argc] = { arg };
-  v8::Local<v8::Function> cons = Nan::New<v8::Function>(constructor);
+  v8::Local<v8::Function> cons = Nan::New<v8::Function>(
+    PerIsolateData::For(v8::Isolate::GetCurrent())->producer_constructor);
   v8::Local<v8::Object> instance =
     Nan::NewInstance(cons, argc, argv).ToLocalChecked();
 
@@ -213,9 +221,18 @@ void Producer::Disconnect() {
     scoped_shared_write_lock lock(m_connection_lock);
     delete m_client;
     m_client = NULL;
+    // A new client polls its own main queue until told otherwise
+    m_is_background_polling = false;
   }
 }
 
+void Producer::Teardown() {
+  // Destroy the client first so no delivery reports arrive once the
+  // dispatchers have closed their handles.
+  Disconnect();
+  DeactivateDispatchers();
+}
+
 /**
  * [Producer::Produce description]
  * @param message - pointer to the message we are sending. This method will
@@ -593,51 +610,8 @@ NAN_METHOD(Producer::NodeProduce) {
 
   std::vector<RdKafka::Headers::Header> headers;
   if (info.Length() > 6 && !info[6]->IsUndefined()) {
-    v8::Local<v8::Array> v8Headers = v8::Local<v8::Array>::Cast(info[6]);
-
-    if (v8Headers->Length() >= 1) {
-      for (unsigned int i = 0; i < v8Headers->Length(); i++) {
-        v8::Local<v8::Object> header = Nan::Get(v8Headers, i).ToLocalChecked()
-          ->ToObject(Nan::GetCurrentContext()).ToLocalChecked();
-        if (header.IsEmpty()) {
-          continue;
-        }
-
-        v8::Local<v8::Array> props = header->GetOwnPropertyNames(
-          Nan::GetCurrentContext()).ToLocalChecked();
-
-        // TODO: Other properties in the list of properties should not be
-        // ignored, but they are. This is a bug, need to handle it either in JS
-        // or here.
-        Nan::MaybeLocal<v8::String> v8Key =
-            Nan::To<v8::String>(Nan::Get(props, 0).ToLocalChecked());
-
-        // The key must be a string.
-        if (v8Key.IsEmpty()) {
-          Nan::ThrowError("Header key must be a string");
-        }
-        Nan::Utf8String uKey(v8Key.ToLocalChecked());
-        std::string key(*uKey);
-
-        // Valid types for the header are string or buffer.
-        // Other types will throw an error.
-        v8::Local<v8::Value> v8Value =
-            Nan::Get(header, v8Key.ToLocalChecked()).ToLocalChecked();
-
-        if (node::Buffer::HasInstance(v8Value)) {
-          const char* value = node::Buffer::Data(v8Value);
-          const size_t value_len = node::Buffer::Length(v8Value);
-          headers.push_back(RdKafka::Headers::Header(key, value, value_len));
-        } else if (v8Value->IsString()) {
-          Nan::Utf8String uValue(v8Value);
-          std::string value(*uValue);
-          headers.push_back(
-              RdKafka::Headers::Header(key, value.c_str(), value.size()));
-        } else {
-          Nan::ThrowError("Header value must be a string or buffer");
-        }
-      }
-    }
+    headers = Conversion::Message::FromV8HeaderArray(
+      v8::Local<v8::Array>::Cast(info[6]));
   }
 
   Producer* producer = ObjectWrap::Unwrap<Producer>(info.This());
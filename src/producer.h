@@ -79,6 +79,7 @@ class Producer : public Connection {
 
   void ActivateDispatchers();
   void DeactivateDispatchers();
+  void Teardown();
 
   void ConfigureCallback(const std::string& string_key,
                          const v8::Local<v8::Function>& cb, bool add) override;
@@ -93,7 +94,6 @@ class Producer : public Connection {
     int timeout_ms);
 
  protected:
-  static Nan::Persistent<v8::Function> constructor;
   static void New(const Nan::FunctionCallbackInfo<v8::Value>&);
 
   Producer(Conf*, Conf*);
@@ -12,6 +12,7 @@
 
 #include "src/common.h"
 #include "src/connection.h"
+#include "src/per-isolate-data.h"
 #include "src/topic.h"
 
 namespace NodeKafka {
@@ -74,8 +75,6 @@ Baton offset_store (int32_t partition, int64_t offset) {
 
 */
 
-Nan::Persistent<v8::Function> Topic::constructor;
-
 void Topic::Init(v8::Local<v8::Object> exports) {
   Nan::HandleScope scope;
 
@@ -86,8 +85,9 @@ void Topic::Init(v8::Local<v8::Object> exports) {
   Nan::SetPrototypeMethod(tpl, "name", NodeGetName);
 
   // connect. disconnect. resume. pause. get meta data
-  constructor.Reset((tpl->GetFunction(Nan::GetCurrentContext()))
-    .ToLocalChecked());
+  PerIsolateData* data = PerIsolateData::For(v8::Isolate::GetCurrent());
+  data->topic_constructor.Reset(
+    (tpl->GetFunction(Nan::GetCurrentContext())).ToLocalChecked());
 
   Nan::Set(exports, Nan::New("Topic").ToLocalChecked(),
     tpl->GetFunction(Nan::GetCurrentContext()).ToLocalChecked());
@@ -147,7 +147,8 @@ v8::Local<v8::Object> Topic::NewInstance(v8::Local<v8::Value> arg) {
   const unsigned argc = 1;
 
   v8::Local<v8::Value> argv[argc] = { arg };
-  v8::Local<v8::Function> cons = Nan::New<v8::Function>(constructor);
+  v8::Local<v8::Function> cons = Nan::New<v8::Function>(
+    PerIsolateData::For(v8::Isolate::GetCurrent())->topic_constructor);
   v8::Local<v8::Object> instance =
     Nan::NewInstance(cons, argc, argv).ToLocalChecked();
 
@@ -27,7 +27,6 @@ class Topic : public Nan::ObjectWrap {
   Baton toRDKafkaTopic(Connection *handle);
 
  protected:
-  static Nan::Persistent<v8::Function> constructor;
   static void New(const Nan::FunctionCallbackInfo<v8::Value>& info);
 
   static NAN_METHOD(NodeGetMetadata);
@@ -9,6 +9,7 @@
  */
 #include "src/workers.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -809,12 +810,16 @@ KafkaConsumerConsumeNum::KafkaConsumerConsumeNum(Nan::Callback *callback,
                                      KafkaConsumer* consumer,
                                      const uint32_t & num_messages,
                                      const int & timeout_ms,
-                                     bool timeout_only_for_first_message) :
+                                     bool timeout_only_for_first_message,
+                                     bool kafkajs_format,
+                                     Conversion::Message::WireFormatMode wire_format_mode) :  // NOLINT
   ErrorAwareWorker(callback),
   m_consumer(consumer),
   m_num_messages(num_messages),
   m_timeout_ms(timeout_ms),
-  m_timeout_only_for_first_message(timeout_only_for_first_message) {}
+  m_timeout_only_for_first_message(timeout_only_for_first_message),
+  m_kafkajs_format(kafkajs_format),
+  m_wire_format_mode(wire_format_mode) {}
 
 KafkaConsumerConsumeNum::~KafkaConsumerConsumeNum() {}
 
@@ -842,6 +847,10 @@ void KafkaConsumerConsumeNum::Execute() {
           // is set to true. In this case, consumer is also interested in EOF
           // messages, so we return an EOF message
           m_messages.push_back(message);
+          if (m_wire_format_mode != Conversion::Message::WIRE_FORMAT_NONE) {
+            m_wire_formats.push_back(Conversion::Message::ParseWireFormat(
+              message, Conversion::Message::WIRE_FORMAT_NONE));
+          }
           eof_event_count += 1;
           break;
         case RdKafka::ERR__TIMED_OUT:
@@ -852,6 +861,11 @@ void KafkaConsumerConsumeNum::Execute() {
           break;
         case RdKafka::ERR_NO_ERROR:
           m_messages.push_back(b.data<RdKafka::Message*>());
+          if (m_wire_format_mode != Conversion::Message::WIRE_FORMAT_NONE) {
+            // Parse here rather than on the event loop thread
+            m_wire_formats.push_back(Conversion::Message::ParseWireFormat(
+              message, m_wire_format_mode));
+          }
 
           // This allows getting ready messages, while not waiting for new ones.
           // This is useful when we want to get the as many messages as possible
@@ -892,15 +906,23 @@ void KafkaConsumerConsumeNum::HandleOKCallback() {
   if (m_messages.size() > 0) {
     int returnArrayIndex = -1;
     int eofEventsArrayIndex = -1;
-    for (std::vector<RdKafka::Message*>::iterator it = m_messages.begin();
-        it != m_messages.end(); ++it) {
-      RdKafka::Message* message = *it;
+    for (std::size_t i = 0; i < m_messages.size(); i++) {
+      RdKafka::Message* message = m_messages[i];
 
       switch (message->err()) {
         case RdKafka::ERR_NO_ERROR:
           ++returnArrayIndex;
-          Nan::Set(returnArray, returnArrayIndex,
-                   Conversion::Message::ToV8Object(message));
+          if (m_kafkajs_format) {
+            Nan::Set(returnArray, returnArrayIndex,
+                     Conversion::Message::ToKafkaJSV8Object(message));
+          } else if (!m_wire_formats.empty()) {
+            Nan::Set(returnArray, returnArrayIndex,
+                     Conversion::Message::ToV8Object(message,
+                                                     m_wire_formats[i]));
+          } else {
+            Nan::Set(returnArray, returnArrayIndex,
+                     Conversion::Message::ToV8Object(message));
+          }
           break;
         case RdKafka::ERR__PARTITION_EOF:
           ++eofEventsArrayIndex;
@@ -1062,6 +1084,194 @@ void KafkaConsumerCommitted::HandleErrorCallback() {
   callback->Call(argc, argv);
 }
 
+/**
+ * @brief KafkaConsumer resolve start offsets worker.
+ *
+ * The offset to start each partition from is its committed offset, or else
+ * the offset for the fallback timestamp if one was given, or else the
+ * fallback offset. The callback receives the partitions with the resolved
+ * `offset`, its `source` ("committed", "timestamp" or "fallback"), the
+ * watermarks if requested and the time spent in each phase.
+ */
+KafkaConsumerResolveOffsets::KafkaConsumerResolveOffsets(
+    Nan::Callback *callback, KafkaConsumer* consumer,
+    std::vector<RdKafka::TopicPartition*> & toppars, bool use_timestamp,
+    int64_t timestamp, int64_t fallback_offset, bool watermarks,
+    const int & timeout_ms) :
+  ErrorAwareWorker(callback),
+  m_consumer(consumer),
+  m_committed(toppars),
+  m_use_timestamp(use_timestamp),
+  m_fallback_offset(fallback_offset),
+  m_watermarks(watermarks),
+  m_timeout_ms(timeout_ms),
+  m_committed_ms(0),
+  m_timestamp_ms(0),
+  m_watermarks_ms(0),
+  m_total_ms(0) {
+  // ListOffsets with the special timestamps -2 and -1 returns the low and
+  // high watermarks of all partitions in one request.
+  for (size_t i = 0; i < toppars.size(); i++) {
+    const std::string &topic = toppars[i]->topic();
+    int32_t partition = toppars[i]->partition();
+    if (use_timestamp) {
+      m_by_timestamp.push_back(
+        RdKafka::TopicPartition::create(topic, partition, timestamp));
+    }
+    if (watermarks) {
+      m_low.push_back(RdKafka::TopicPartition::create(topic, partition,
+        RdKafka::Topic::OFFSET_BEGINNING));
+      m_high.push_back(RdKafka::TopicPartition::create(topic, partition,
+        RdKafka::Topic::OFFSET_END));
+    }
+  }
+}
+
+KafkaConsumerResolveOffsets::~KafkaConsumerResolveOffsets() {
+  RdKafka::TopicPartition::destroy(m_committed);
+  RdKafka::TopicPartition::destroy(m_by_timestamp);
+  RdKafka::TopicPartition::destroy(m_low);
+  RdKafka::TopicPartition::destroy(m_high);
+}
+
+void KafkaConsumerResolveOffsets::RunPhase(void *arg) {
+  Phase *phase = static_cast<Phase*>(arg);
+  KafkaConsumerResolveOffsets *worker = phase->worker;
+
+  uint64_t start = uv_hrtime();
+  Baton b = phase->committed ?
+    worker->m_consumer->Committed(*phase->toppars, worker->m_timeout_ms) :
+    worker->m_consumer->OffsetsForTimes(*phase->toppars, worker->m_timeout_ms);
+  phase->err = b.err();
+  phase->elapsed_ms = (uv_hrtime() - start) / 1e6;
+}
+
+void KafkaConsumerResolveOffsets::Execute() {
+  uint64_t start = uv_hrtime();
+
+  std::vector<Phase> phases;
+  phases.push_back(Phase{this, &m_committed, true, RdKafka::ERR_NO_ERROR, 0});
+  if (m_use_timestamp) {
+    phases.push_back(
+      Phase{this, &m_by_timestamp, false, RdKafka::ERR_NO_ERROR, 0});
+  }
+  if (m_watermarks) {
+    phases.push_back(Phase{this, &m_low, false, RdKafka::ERR_NO_ERROR, 0});
+    phases.push_back(Phase{this, &m_high, false, RdKafka::ERR_NO_ERROR, 0});
+  }
+
+  // The first phase runs on this thread, the others on threads of their own.
+  std::vector<uv_thread_t> threads(phases.size() - 1);
+  std::vector<bool> started(threads.size(), false);
+  for (size_t i = 1; i < phases.size(); i++) {
+    started[i - 1] =
+      uv_thread_create(&threads[i - 1], RunPhase, &phases[i]) == 0;
+    if (!started[i - 1]) {
+      RunPhase(&phases[i]);
+    }
+  }
+  RunPhase(&phases[0]);
+  for (size_t i = 0; i < threads.size(); i++) {
+    if (started[i]) {
+      uv_thread_join(&threads[i]);
+    }
+  }
+
+  m_total_ms = (uv_hrtime() - start) / 1e6;
+  m_committed_ms = phases[0].elapsed_ms;
+  if (m_use_timestamp) {
+    m_timestamp_ms = phases[1].elapsed_ms;
+  }
+  if (m_watermarks) {
+    size_t low = m_use_timestamp ? 2 : 1;
+    m_watermarks_ms = std::max(phases[low].elapsed_ms,
+                               phases[low + 1].elapsed_ms);
+  }
+
+  for (size_t i = 0; i < phases.size(); i++) {
+    if (phases[i].err != RdKafka::ERR_NO_ERROR) {
+      SetErrorBaton(Baton(phases[i].err));
+      return;
+    }
+  }
+}
+
+void KafkaConsumerResolveOffsets::HandleOKCallback() {
+  Nan::HandleScope scope;
+
+  v8::Local<v8::Array> partitions = Nan::New<v8::Array>();
+  for (size_t i = 0; i < m_committed.size(); i++) {
+    RdKafka::TopicPartition *committed = m_committed[i];
+    v8::Local<v8::Object> obj = Nan::New<v8::Object>();
+
+    Nan::Set(obj, Nan::New("topic").ToLocalChecked(),
+      Nan::New<v8::String>(committed->topic()).ToLocalChecked());
+    Nan::Set(obj, Nan::New("partition").ToLocalChecked(),
+      Nan::New<v8::Number>(committed->partition()));
+
+    int64_t offset = m_fallback_offset;
+    const char *source = "fallback";
+    bool has_committed = false;
+    if (committed->err() != RdKafka::ERR_NO_ERROR) {
+      Nan::Set(obj, Nan::New("error").ToLocalChecked(),
+        RdKafkaError(committed->err()));
+    } else if (committed->offset() >= 0) {
+      offset = committed->offset();
+      source = "committed";
+      has_committed = true;
+    }
+
+    if (!has_committed && m_use_timestamp &&
+        m_by_timestamp[i]->err() == RdKafka::ERR_NO_ERROR &&
+        m_by_timestamp[i]->offset() >= 0) {
+      offset = m_by_timestamp[i]->offset();
+      source = "timestamp";
+    }
+
+    Nan::Set(obj, Nan::New("offset").ToLocalChecked(),
+      Nan::New<v8::Number>(offset));
+    Nan::Set(obj, Nan::New("source").ToLocalChecked(),
+      Nan::New(source).ToLocalChecked());
+
+    if (m_watermarks) {
+      if (m_low[i]->err() == RdKafka::ERR_NO_ERROR) {
+        Nan::Set(obj, Nan::New("lowOffset").ToLocalChecked(),
+          Nan::New<v8::Number>(m_low[i]->offset()));
+      }
+      if (m_high[i]->err() == RdKafka::ERR_NO_ERROR) {
+        Nan::Set(obj, Nan::New("highOffset").ToLocalChecked(),
+          Nan::New<v8::Number>(m_high[i]->offset()));
+      }
+    }
+
+    Nan::Set(partitions, i, obj);
+  }
+
+  v8::Local<v8::Object> timings = Nan::New<v8::Object>();
+  Nan::Set(timings, Nan::New("committedMs").ToLocalChecked(),
+    Nan::New<v8::Number>(m_committed_ms));
+  Nan::Set(timings, Nan::New("timestampMs").ToLocalChecked(),
+    Nan::New<v8::Number>(m_timestamp_ms));
+  Nan::Set(timings, Nan::New("watermarksMs").ToLocalChecked(),
+    Nan::New<v8::Number>(m_watermarks_ms));
+  Nan::Set(timings, Nan::New("totalMs").ToLocalChecked(),
+    Nan::New<v8::Number>(m_total_ms));
+
+  const unsigned int argc = 3;
+  v8::Local<v8::Value> argv[argc] = { Nan::Null(), partitions, timings };
+
+  callback->Call(argc, argv);
+}
+
+void KafkaConsumerResolveOffsets::HandleErrorCallback() {
+  Nan::HandleScope scope;
+
+  const unsigned int argc = 1;
+  v8::Local<v8::Value> argv[argc] = { GetErrorObject() };
+
+  callback->Call(argc, argv);
+}
+
 /**
  * @brief KafkaConsumer commit offsets with a callback function.
  * 
@@ -1176,6 +1386,55 @@ void KafkaConsumerSeek::HandleErrorCallback() {
   callback->Call(argc, argv);
 }
 
+/**
+ * @brief KafkaConsumer seek several partitions in one call.
+ *
+ * The callback receives the partitions, each with an `error` property if
+ * seeking it failed.
+ *
+ * @see RdKafka::KafkaConsumer::seek
+ */
+KafkaConsumerSeekPartitions::KafkaConsumerSeekPartitions(
+    Nan::Callback *callback, KafkaConsumer* consumer,
+    rd_kafka_topic_partition_list_t *partitions, const int & timeout_ms) :
+  ErrorAwareWorker(callback),
+  m_consumer(consumer),
+  m_partitions(partitions),
+  m_timeout_ms(timeout_ms) {}
+
+KafkaConsumerSeekPartitions::~KafkaConsumerSeekPartitions() {
+  rd_kafka_topic_partition_list_destroy(m_partitions);
+}
+
+void KafkaConsumerSeekPartitions::Execute() {
+  Baton b = m_consumer->SeekPartitions(m_partitions, m_timeout_ms);
+  if (b.err() != RdKafka::ERR_NO_ERROR) {
+    SetErrorBaton(b);
+  }
+}
+
+void KafkaConsumerSeekPartitions::HandleOKCallback() {
+  Nan::HandleScope scope;
+
+  const unsigned int argc = 2;
+  v8::Local<v8::Value> argv[argc];
+
+  argv[0] = Nan::Null();
+  argv[1] = Conversion::TopicPartition::ToTopicPartitionV8Array(m_partitions,
+                                                                true);
+
+  callback->Call(argc, argv);
+}
+
+void KafkaConsumerSeekPartitions::HandleErrorCallback() {
+  Nan::HandleScope scope;
+
+  const unsigned int argc = 1;
+  v8::Local<v8::Value> argv[argc] = { GetErrorObject() };
+
+  callback->Call(argc, argv);
+}
+
 /**
  * @brief createTopic
  *
@@ -79,7 +79,7 @@ class MessageWorker : public ErrorAwareWorker {
       : ErrorAwareWorker(callback_), m_asyncdata() {
     m_async = new uv_async_t;
     uv_async_init(
-      uv_default_loop(),
+      Nan::GetCurrentEventLoop(),
       m_async,
       m_async_message);
     m_async->data = this;
@@ -424,6 +424,53 @@ class KafkaConsumerCommitted : public ErrorAwareWorker {
   const int m_timeout_ms;
 };
 
+/**
+ * @brief Resolve the offsets to start consuming partitions from.
+ *
+ * Committed offsets, offsets for a fallback timestamp and the low and high
+ * watermarks of all partitions are each fetched with one request, and the
+ * requests are run concurrently.
+ */
+class KafkaConsumerResolveOffsets : public ErrorAwareWorker {
+ public:
+  KafkaConsumerResolveOffsets(Nan::Callback*, NodeKafka::KafkaConsumer*,
+    std::vector<RdKafka::TopicPartition*> &, bool use_timestamp,
+    int64_t timestamp, int64_t fallback_offset, bool watermarks,
+    const int &);
+  ~KafkaConsumerResolveOffsets();
+
+  void Execute();
+  void HandleOKCallback();
+  void HandleErrorCallback();
+
+  // A single request of the resolution, run on its own thread.
+  struct Phase {
+    KafkaConsumerResolveOffsets *worker;
+    std::vector<RdKafka::TopicPartition*> *toppars;
+    bool committed;
+    RdKafka::ErrorCode err;
+    double elapsed_ms;
+  };
+
+ private:
+  static void RunPhase(void *);
+
+  NodeKafka::KafkaConsumer * m_consumer;
+  std::vector<RdKafka::TopicPartition*> m_committed;
+  std::vector<RdKafka::TopicPartition*> m_by_timestamp;
+  std::vector<RdKafka::TopicPartition*> m_low;
+  std::vector<RdKafka::TopicPartition*> m_high;
+  const bool m_use_timestamp;
+  const int64_t m_fallback_offset;
+  const bool m_watermarks;
+  const int m_timeout_ms;
+
+  double m_committed_ms;
+  double m_timestamp_ms;
+  double m_watermarks_ms;
+  double m_total_ms;
+};
+
 class KafkaConsumerCommitCb : public ErrorAwareWorker {
  public:
   KafkaConsumerCommitCb(Nan::Callback*,
@@ -439,6 +486,21 @@ class KafkaConsumerCommitCb : public ErrorAwareWorker {
   std::optional<std::vector<RdKafka::TopicPartition*>> m_topic_partitions;
 };
 
+class KafkaConsumerSeekPartitions : public ErrorAwareWorker {
+ public:
+  KafkaConsumerSeekPartitions(Nan::Callback*, NodeKafka::KafkaConsumer*,
+    rd_kafka_topic_partition_list_t *, const int &);
+  ~KafkaConsumerSeekPartitions();
+
+  void Execute();
+  void HandleOKCallback();
+  void HandleErrorCallback();
+ private:
+  NodeKafka::KafkaConsumer * m_consumer;
+  rd_kafka_topic_partition_list_t * m_partitions;
+  const int m_timeout_ms;
+};
+
 class KafkaConsumerSeek : public ErrorAwareWorker {
  public:
   KafkaConsumerSeek(Nan::Callback*, NodeKafka::KafkaConsumer*,
@@ -457,7 +519,8 @@ class KafkaConsumerSeek : public ErrorAwareWorker {
 class KafkaConsumerConsumeNum : public ErrorAwareWorker {
  public:
   KafkaConsumerConsumeNum(Nan::Callback*, NodeKafka::KafkaConsumer*,
-    const uint32_t &, const int &, bool);
+    const uint32_t &, const int &, bool, bool,
+    NodeKafka::Conversion::Message::WireFormatMode);
   ~KafkaConsumerConsumeNum();
 
   void Execute();
@@ -468,7 +531,13 @@ class KafkaConsumerConsumeNum : public ErrorAwareWorker {
   const uint32_t m_num_messages;
   const int m_timeout_ms;
   const bool m_timeout_only_for_first_message;
+  // Whether to convert messages to the KafkaJS batch message shape
+  const bool m_kafkajs_format;
+  // Which parts of the Confluent wire format header to parse
+  const NodeKafka::Conversion::Message::WireFormatMode m_wire_format_mode;
   std::vector<RdKafka::Message*> m_messages;
+  // Parsed headers, one per message in m_messages if parsing is enabled
+  std::vector<NodeKafka::Conversion::Message::WireFormat> m_wire_formats;
 };
 
 /**
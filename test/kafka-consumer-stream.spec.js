@@ -294,5 +294,154 @@ module.exports = {
       });
 
     },
+
+    'pauses the assigned partitions while the buffer is full': function(next) {
+      var numConsumed = 0;
+      var consume = fakeClient.consume;
+      fakeClient.consume = function(size, cb) {
+        numConsumed++;
+        consume.call(this, size, cb);
+      };
+      var paused = [];
+      var resumed = [];
+      fakeClient._client = {
+        pause: function(partitions) {
+          paused.push(partitions);
+          return partitions;
+        },
+        resume: function(partitions) {
+          resumed.push(partitions);
+          return partitions;
+        }
+      };
+      fakeClient._errorWrap = function(result) {
+        return result;
+      };
+      fakeClient.assignments = function() {
+        return [{ topic: 'topic', partition: 0 }, { topic: 'topic', partition: 1 }];
+      };
+      // Paused by the user, so the stream neither pauses nor resumes it
+      fakeClient._pausedPartitions = new Set(['topic|1']);
+
+      var stream = new KafkaConsumerStream(fakeClient, {
+        topics: 'topic',
+        highWaterMarkBytes: 8
+      });
+      stream.on('error', function(err) {
+        t.fail(err);
+      });
+      stream.once('readable', function() {
+        // Two messages of 4 bytes fill the buffer behind the ones the
+        // stream holds, and nothing more is consumed
+        setTimeout(function() {
+          t.equal(stream._bufferedBytes, 8);
+          t.deepStrictEqual(paused, [[{ topic: 'topic', partition: 0 }]]);
+          t.deepStrictEqual(resumed, []);
+          var numFull = numConsumed;
+          setTimeout(function() {
+            t.equal(numConsumed, numFull);
+            t.notEqual(stream.read(), null);
+          }, 20);
+          setTimeout(function() {
+            t.ok(numConsumed > numFull);
+            t.deepStrictEqual(resumed[0], [{ topic: 'topic', partition: 0 }]);
+            stream.destroy();
+            t.equal(stream._bufferedMessages, 0);
+            t.equal(stream._bufferedBytes, 0);
+            next();
+          }, 40);
+        }, 20);
+      });
+    },
+
+    'pauses the partitions assigned while the buffer is full': function(next) {
+      var paused = [];
+      var resumed = [];
+      fakeClient._client = {
+        pause: function(partitions) {
+          paused.push(partitions);
+          return partitions;
+        },
+        resume: function(partitions) {
+          resumed.push(partitions);
+          return partitions;
+        }
+      };
+      fakeClient._errorWrap = function(result) {
+        return result;
+      };
+      var assignments = [{ topic: 'topic', partition: 0 }];
+      fakeClient.assignments = function() {
+        return assignments;
+      };
+
+      var stream = new KafkaConsumerStream(fakeClient, {
+        topics: 'topic',
+        highWaterMarkBytes: 8
+      });
+      stream.on('error', function(err) {
+        t.fail(err);
+      });
+      stream.once('readable', function() {
+        setTimeout(function() {
+          t.deepStrictEqual(paused, [[{ topic: 'topic', partition: 0 }]]);
+
+          // Partition 0 moves to another consumer and partition 1 comes in
+          assignments = [{ topic: 'topic', partition: 1 }];
+          fakeClient.emit('rebalance');
+          setImmediate(function() {
+            t.deepStrictEqual(paused[1], [{ topic: 'topic', partition: 1 }]);
+            t.deepStrictEqual(Array.from(stream._pausedPartitions.keys()), ['topic|1']);
+
+            // Only the partition still assigned is resumed
+            while (stream.read() !== null) {
+              // drain the stream
+            }
+            setTimeout(function() {
+              t.deepStrictEqual(resumed[0], [{ topic: 'topic', partition: 1 }]);
+              stream.destroy();
+              next();
+            }, 20);
+          });
+        }, 20);
+      });
+    },
+
+    'fetches again when the consumer reports new messages': function(next) {
+      var queueNonEmpty;
+      var numConsumed = 0;
+      fakeClient._client = {
+        configureCallbacks: function(add, callbacks) {
+          queueNonEmpty = add ? callbacks.event.queue_non_empty_cb : null;
+        }
+      };
+      fakeClient.consume = function(size, cb) {
+        numConsumed++;
+        setImmediate(function() {
+          cb(null, numConsumed === 1 ? [] : [{
+            value: Buffer.from('test'),
+            offset: 1
+          }]);
+        });
+      };
+
+      var stream = new KafkaConsumerStream(fakeClient, {
+        topics: 'topic',
+        waitInterval: 60000
+      });
+      stream.on('error', function(err) {
+        t.fail(err);
+      });
+      stream.once('readable', function() {
+        t.equal(stream.read().value.toString(), 'test');
+        stream.destroy();
+        t.equal(queueNonEmpty, null);
+        next();
+      });
+      setTimeout(function() {
+        t.equal(numConsumed, 1);
+        queueNonEmpty();
+      }, 20);
+    },
   }
 };
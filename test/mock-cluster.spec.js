@@ -0,0 +1,64 @@
+/*
+ * confluent-kafka-javascript - Node.js wrapper  for RdKafka C/C++ library
+ *
+ * Copyright (c) 2024 Confluent, Inc.
+ *
+ * This software may be modified and distributed under the terms
+ * of the MIT license.  See the LICENSE.txt file for details.
+ */
+
+var MockCluster = require('../lib/mock-cluster');
+var t = require('assert');
+
+var calls;
+var cluster;
+
+function fakeClient() {
+  var native = {};
+  ['mockBootstrapServers', 'mockBrokerSetRtt', 'mockBrokerSetUp',
+    'mockPartitionSetLeader', 'mockPushRequestErrors',
+    'mockClearRequestErrors', 'mockTopicCreate'].forEach(function(name) {
+    native[name] = function() {
+      calls.push([name].concat(Array.prototype.slice.call(arguments)));
+      return 'localhost:1234';
+    };
+  });
+  return { getClient: function() { return native; } };
+}
+
+module.exports = {
+  'MockCluster': {
+    'beforeEach': function() {
+      calls = [];
+      cluster = new MockCluster(fakeClient());
+    },
+    'returns the bootstrap servers of the native client': function() {
+      t.equal(cluster.bootstrapServers(), 'localhost:1234');
+    },
+    'maps broker state changes to mockBrokerSetUp': function() {
+      cluster.setBrokerDown(2).setBrokerUp(2);
+      t.deepStrictEqual(calls, [
+        ['mockBrokerSetUp', 2, false],
+        ['mockBrokerSetUp', 2, true],
+      ]);
+    },
+    'resolves API key names': function() {
+      cluster.pushRequestErrors('Produce', [1, 2]);
+      cluster.clearRequestErrors(MockCluster.ApiKeys.Fetch);
+      t.deepStrictEqual(calls, [
+        ['mockPushRequestErrors', 0, [1, 2]],
+        ['mockClearRequestErrors', 1],
+      ]);
+    },
+    'rejects unknown API key names': function() {
+      t.throws(function() {
+        cluster.pushRequestErrors('NotAnApi', [1]);
+      }, TypeError);
+      t.equal(calls.length, 0);
+    },
+    'defaults the replication factor of created topics to 1': function() {
+      cluster.createTopic('topic', 3);
+      t.deepStrictEqual(calls, [['mockTopicCreate', 'topic', 3, 1]]);
+    },
+  },
+};
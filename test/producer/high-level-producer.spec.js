@@ -491,6 +491,44 @@ module.exports = {
           next();
         });
       },
+
+      'calls the delivery callback and reuses its message id': function(next) {
+        var opaques = [];
+        client._oldProduce = function(topic, partition, v, k, timestamp, opaque) {
+          opaques.push(opaque);
+        };
+
+        client.produce('tawpic', 0, 'a', 'key', null, function(err, offset) {
+          t.ifError(err);
+          t.equal(offset, 5);
+          // 'c' was produced before this callback, so 'b' comes third and
+          // takes the id 'a' released
+          client.produce('tawpic', 0, 'b', 'key', null, function() {});
+          t.equal(opaques[2].__message_id, opaques[0].__message_id);
+          next();
+        });
+        client.produce('tawpic', 0, 'c', 'key', null, function() {});
+        t.notEqual(opaques[1].__message_id, opaques[0].__message_id);
+
+        client.emit('delivery-report', null, { opaque: opaques[0], offset: 5 });
+        // A second report for the same message is ignored
+        client.emit('delivery-report', null, { opaque: opaques[0], offset: 6 });
+      },
+
+      'passes null offsets and errors to delivery callbacks': function(next) {
+        var opaque;
+        client._oldProduce = function(topic, partition, v, k, timestamp, o) {
+          opaque = o;
+        };
+
+        var error = new Error('delivery failed');
+        client.produce('tawpic', 0, 'a', 'key', null, function(err, offset) {
+          t.equal(err, error);
+          t.equal(offset, null);
+          next();
+        });
+        client.emit('delivery-report', error, { opaque: opaque, offset: -1 });
+      },
     }
   },
 };
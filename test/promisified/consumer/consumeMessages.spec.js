@@ -180,6 +180,12 @@ describe.each(cases)('Consumer - partitionsConsumedConcurrently = %s -', (partit
                 }),
             })
         );
+
+        const { batch } = messagesConsumed[0];
+        expect(batch.firstOffset()).toEqual('0');
+        expect(batch.lastOffset()).toEqual('0');
+        /* The high watermark comes from the fetch response of the batch. */
+        expect(batch.highWatermark).toEqual('1');
     });
 
     it.each([[true], [false]])('consumes messages using eachBatch - isAutoResolve: %s', async (isAutoResolve) => {
@@ -9,6 +9,7 @@ const {
     waitForMessages,
     sleep,
 } = require('../testhelpers');
+const { PartitionAssigners } = require('../../../lib').KafkaJS;
 
 /* All required combinations of [autoCommit, partitionsConsumedConcurrently] */
 const cases = [
@@ -229,6 +230,97 @@ describe.each(cases)('Consumer message cache - isAutoCommit = %s - partitionsCon
         await consumer2.disconnect();
     }, 60000);
 
+    it('drops messages of revoked partitions on incremental rebalance', async () => {
+        /* Same as above, but with the cooperative protocol the partitions which are not
+         * revoked stay assigned, so only the cached messages of the revoked ones must go. */
+        let groupId = `consumer-group-id-${secureRandom()}`;
+        const partitionAssigners = [PartitionAssigners.cooperativeSticky];
+        consumer = createConsumer({
+            groupId,
+            maxWaitTimeInMs: 100,
+            fromBeginning: true,
+            autoCommit: isAutoCommit,
+            partitionAssigners,
+        });
+
+        const consumer2 = createConsumer({
+            groupId,
+            maxWaitTimeInMs: 100,
+            fromBeginning: true,
+            autoCommit: isAutoCommit,
+            partitionAssigners,
+            clientId: "consumer2",
+        });
+
+        await consumer.connect();
+        await producer.connect();
+        await consumer.subscribe({ topic: topicName });
+
+        const messagesConsumed = [];
+        const messagesConsumedConsumer2 = [];
+        let consumer2ConsumeRunning = false;
+
+        consumer.run({
+            partitionsConsumedConcurrently,
+            eachMessage: async event => {
+                messagesConsumed.push({ ...event, consumer: 1 });
+                if (!isAutoCommit)
+                    await consumer.commitOffsets([
+                        { topic: event.topic, partition: event.partition, offset: Number(event.message.offset) + 1 },
+                    ]);
+
+                if (messagesConsumed.length > 1024 && !consumer2ConsumeRunning) {
+                    await sleep(10);
+                }
+            }
+        });
+
+        let i = 0;
+        const multiplier = 9;
+        const messages = Array(1024 * multiplier)
+            .fill()
+            .map(() => {
+                const value = secureRandom();
+                return { value: `value-${value}`, partition: (i++) % 3 };
+            });
+
+        await producer.send({ topic: topicName, messages });
+        await waitForMessages(messagesConsumed, { number: 1024 });
+
+        await consumer2.connect();
+        await consumer2.subscribe({ topic: topicName });
+        consumer2.run({
+            eachMessage: async event => {
+                messagesConsumed.push({ ...event, consumer: 2 });
+                messagesConsumedConsumer2.push(event);
+            }
+        });
+
+        await waitFor(() => consumer2.assignment().length > 0, () => null);
+        consumer2ConsumeRunning = true;
+
+        await waitForMessages(messagesConsumed, { number: 1024 * multiplier });
+
+        /* A message buffered for a revoked partition would be delivered by the first
+         * consumer and fetched again by the second, so there would be extra messages. */
+        await sleep(1000);
+        expect(messagesConsumed.length).toEqual(1024 * multiplier);
+        expect(messagesConsumedConsumer2.length).toBeGreaterThan(0);
+
+        /* Once the second consumer has delivered a message of a partition, the first
+         * one delivers nothing more from it. */
+        const revoked = new Set(messagesConsumedConsumer2.map(event => event.partition));
+        for (const partition of revoked) {
+            const firstByConsumer2 = messagesConsumed.findIndex(
+                event => event.consumer === 2 && event.partition === partition);
+            const lateByConsumer1 = messagesConsumed.slice(firstByConsumer2).filter(
+                event => event.consumer === 1 && event.partition === partition);
+            expect(lateByConsumer1).toEqual([]);
+        }
+
+        await consumer2.disconnect();
+    }, 60000);
+
     it('does not hold up polling for non-message events', async () => {
         /* Even if the cache is full of messages, we should still be polling for
          * non-message events like rebalances, etc. Internally, this is to make sure that
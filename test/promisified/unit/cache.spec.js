@@ -80,6 +80,26 @@ describe('MessageCache', () => {
         expect(receivedMessages).toEqual(expect.arrayContaining(msgs.slice(0, 3)));
     });
 
+    it('keeps messages of partitions which are not stale', () => {
+        const msgs = messages.slice(0, 90);
+        cache.addMessages(msgs);
+
+        /* As in an incremental rebalance revoking only partition 1. */
+        cache.markStale([{topic: 'topic', partition: 1}]);
+        expect(cache.size).toBe(60);
+
+        const receivedMessages = [];
+        let ppc = null, next = null;
+        while ((next = cache.next(ppc)) !== null) {
+            [next, ppc] = next;
+            receivedMessages.push(next);
+        }
+
+        expect(receivedMessages.length).toBe(60);
+        expect(receivedMessages.every(msg => msg.partition !== 1)).toBeTruthy();
+        expect(cache.size).toBe(0);
+    });
+
     it('caches messages and retrieves 2-at-a-time', () => {
         const msgs = messages.slice(0, 90).filter(msg => msg.partition !== 3);
         cache.addMessages(msgs);
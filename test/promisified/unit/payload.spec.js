@@ -0,0 +1,92 @@
+const { createEachMessagePayload } = require('../../../lib/kafkajs/_consumer_payload');
+
+describe('createEachMessagePayload', () => {
+    const pause = () => {};
+    const message = {
+        topic: 'topic',
+        partition: 2,
+        key: 'key',
+        value: Buffer.from('value'),
+        offset: 42,
+        timestamp: 1700000000000,
+        size: 5,
+        leaderEpoch: 3,
+        headers: [{ a: Buffer.from('1') }, { b: Buffer.from('2') }, { a: Buffer.from('3') }],
+    };
+
+    it('has the KafkaJS payload shape', () => {
+        const payload = createEachMessagePayload(message, pause);
+
+        expect(payload).toEqual(expect.objectContaining({
+            topic: 'topic',
+            partition: 2,
+            pause,
+            message: expect.objectContaining({
+                key: Buffer.from('key'),
+                value: Buffer.from('value'),
+                timestamp: '1700000000000',
+                attributes: 0,
+                offset: '42',
+                size: 5,
+                leaderEpoch: 3,
+                headers: { a: [Buffer.from('1'), Buffer.from('3')], b: Buffer.from('2') },
+            }),
+        }));
+        expect(typeof payload.heartbeat).toBe('function');
+    });
+
+    it('converts lazy fields once', () => {
+        const { message: converted } = createEachMessagePayload(message, pause);
+        expect(converted.offset).toBe(converted.offset);
+        expect(converted.headers).toBe(converted.headers);
+    });
+
+    it('handles missing timestamp and headers', () => {
+        const { message: converted } = createEachMessagePayload(
+            { ...message, timestamp: undefined, headers: undefined }, pause);
+        expect(converted.timestamp).toBe('');
+        expect(converted.headers).toBeUndefined();
+    });
+
+    it('allows overwriting lazy fields', () => {
+        const { message: converted } = createEachMessagePayload(message, pause);
+        converted.offset = '7';
+        converted.headers = { c: 'd' };
+        expect(converted.offset).toBe('7');
+        expect(converted.headers).toEqual({ c: 'd' });
+    });
+
+    it('serializes to a plain message', () => {
+        const { message: converted } = createEachMessagePayload(message, pause);
+        const json = JSON.parse(JSON.stringify(converted));
+        expect(json.offset).toBe('42');
+        expect(json.timestamp).toBe('1700000000000');
+        expect(Object.keys(json.headers)).toEqual(['a', 'b']);
+        expect(Object.keys(json)).toEqual(
+            ['key', 'value', 'timestamp', 'attributes', 'offset', 'size', 'leaderEpoch', 'headers']);
+    });
+
+    it('copies all fields through toJSON', () => {
+        const { message: converted } = createEachMessagePayload(message, pause);
+
+        // The lazy fields are on the prototype, spreading only copies the others
+        expect({ ...converted }.offset).toBeUndefined();
+
+        const copy = { ...converted.toJSON(), value: 'decoded' };
+        expect(copy.offset).toBe('42');
+        expect(copy.timestamp).toBe('1700000000000');
+        expect(copy.headers).toEqual({ a: [Buffer.from('1'), Buffer.from('3')], b: Buffer.from('2') });
+        expect(copy.value).toBe('decoded');
+
+        const keys = [];
+        for (const key in converted) {
+            keys.push(key);
+        }
+        expect(keys.sort()).toEqual(Object.keys(copy).sort());
+    });
+
+    it('shares heartbeat between payloads', () => {
+        expect(createEachMessagePayload(message, pause).heartbeat)
+            .toBe(createEachMessagePayload(message, pause).heartbeat);
+    });
+});
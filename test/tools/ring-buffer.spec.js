@@ -0,0 +1,45 @@
+var t = require('assert');
+var RingBuffer = require('../../lib/tools/ring-buffer');
+
+module.exports = {
+  'RingBuffer': {
+    'is an object': function() {
+      t.equal(typeof(RingBuffer), 'function');
+    },
+    'should return items in the order they were pushed': function() {
+      var buffer = new RingBuffer();
+      buffer.push(1);
+      buffer.push(2);
+      t.equal(buffer.length, 2);
+      t.equal(buffer.shift(), 1);
+      t.equal(buffer.shift(), 2);
+      t.equal(buffer.length, 0);
+      t.equal(buffer.shift(), undefined);
+    },
+    'should keep the order when growing past the end': function() {
+      var buffer = new RingBuffer();
+      var next = 0;
+      var expected = 0;
+      // Move the head forward so that growing has to unwrap the items
+      for (var i = 0; i < 10; i++) {
+        buffer.push(next++);
+        t.equal(buffer.shift(), expected++);
+      }
+      for (i = 0; i < 100; i++) {
+        buffer.push(next++);
+      }
+      t.equal(buffer.length, 100);
+      while (buffer.length > 0) {
+        t.equal(buffer.shift(), expected++);
+      }
+      t.equal(expected, next);
+    },
+    'should be empty after clear': function() {
+      var buffer = new RingBuffer();
+      buffer.push('a');
+      buffer.clear();
+      t.equal(buffer.length, 0);
+      t.equal(buffer.shift(), undefined);
+    },
+  },
+};
@@ -85,6 +85,27 @@ export interface TopicPartitionOffsetAndMetadata extends TopicPartitionOffset {
 
 export type TopicPartitionTime = TopicPartitionOffset;
 
+export interface ResolveOffsetsOptions {
+    timestamp?: number;
+    fallback?: 'earliest' | 'latest' | 'stored' | number;
+    watermarks?: boolean;
+    assign?: boolean;
+    timeout?: number;
+}
+
+export interface ResolvedTopicPartitionOffset extends TopicPartitionOffset {
+    source: 'committed' | 'timestamp' | 'fallback';
+    lowOffset?: number;
+    highOffset?: number;
+}
+
+export interface ResolveOffsetsTimings {
+    committedMs: number;
+    timestampMs: number;
+    watermarksMs: number;
+    totalMs: number;
+}
+
 export type EofEvent = TopicPartitionOffset;
 
 export type Assignment = TopicPartition | TopicPartitionOffset;
@@ -113,6 +134,8 @@ export interface Message extends TopicPartitionOffset {
     timestamp?: number;
     headers?: MessageHeader[];
     opaque?: any;
+    schemaId?: number;
+    messageIndexes?: number[];
 }
 
 export interface ReadStreamOptions extends ReadableOptions {
@@ -121,6 +144,7 @@ export interface ReadStreamOptions extends ReadableOptions {
     fetchSize?: number;
     objectMode?: boolean;
     highWaterMark?: number;
+    highWaterMarkBytes?: number;
     autoClose?: boolean;
     streamAsBatch?: boolean;
     connectOptions?: any;
@@ -205,6 +229,8 @@ export abstract class Client<Events extends string> extends EventEmitter {
 
     setSaslCredentials(username: string, password: string): void;
 
+    getMockCluster(): MockCluster;
+
     on<E extends Events>(event: E, listener: EventListener<E>): this;
     once<E extends Events>(event: E, listener: EventListener<E>): this;
 }
@@ -228,10 +254,20 @@ export class KafkaConsumer extends Client<KafkaConsumerEvents> {
     committed(toppars: TopicPartition[], timeout: number, cb: (err: LibrdKafkaError, topicPartitions: TopicPartitionOffsetAndMetadata[]) => void): this;
     committed(timeout: number, cb: (err: LibrdKafkaError, topicPartitions: TopicPartitionOffsetAndMetadata[]) => void): this;
 
+    resolveOffsets(toppars: TopicPartition[], options: ResolveOffsetsOptions, cb: (err: LibrdKafkaError, topicPartitions: ResolvedTopicPartitionOffset[], timings: ResolveOffsetsTimings) => void): this;
+
     consume(number: number, cb?: (err: LibrdKafkaError, messages: Message[]) => void): void;
     consume(cb: (err: LibrdKafkaError, messages: Message[]) => void): void;
     consume(): void;
 
+    startCapture(path: string): this;
+
+    stopCapture(): this;
+
+    startReplay(path: string, options?: { speed?: number, loop?: boolean }): this;
+
+    stopReplay(): this;
+
     getWatermarkOffsets(topic: string, partition: number): WatermarkOffsets;
 
     offsetsStore(topicPartitions: TopicPartitionOffsetAndMetadata[]): any;
@@ -244,10 +280,15 @@ export class KafkaConsumer extends Client<KafkaConsumerEvents> {
 
     seek(toppar: TopicPartitionOffset, timeout: number | null, cb: (err: LibrdKafkaError) => void): this;
 
+    // timeout is at least 10 ms, lower values are raised to 10 ms
+    seekPartitions(toppars: TopicPartitionOffset[], timeout: number | null, cb: (err: LibrdKafkaError, topicPartitions: TopicPartitionOffset[]) => void): this;
+
     setDefaultConsumeTimeout(timeoutMs: number): void;
 
     setDefaultConsumeLoopTimeoutDelay(timeoutMs: number): void;
 
+    setWireFormatParsing(format: 'none' | 'schemaId' | 'protobuf'): void;
+
     subscribe(topics: SubscribeTopicList): this;
 
     subscription(): string[];
@@ -497,6 +538,26 @@ export interface IAdminClient {
     disconnect(): void;
 }
 
+export class MockCluster {
+    static ApiKeys: { [name: string]: number };
+
+    bootstrapServers(): string;
+
+    setBrokerRtt(brokerId: number, rttMs: number): this;
+
+    setBrokerDown(brokerId: number): this;
+
+    setBrokerUp(brokerId: number): this;
+
+    setPartitionLeader(topic: string, partition: number, brokerId: number): this;
+
+    pushRequestErrors(apiKey: number | string, errors: number[]): this;
+
+    clearRequestErrors(apiKey: number | string): this;
+
+    createTopic(topic: string, numPartitions: number, replicationFactor?: number): this;
+}
+
 export type EventHandlers = {
     [event_key: string]: (...args: any[]) => void;
 };
@@ -516,6 +577,7 @@ export type RdKafka = {
   createWriteStream: typeof Producer.createWriteStream,
   CODES: typeof errors.CODES,
   Topic: (name: string) => string,
+  MockCluster: typeof MockCluster,
   features: typeof features,
   librdkafkaVersion: typeof librdkafkaVersion,
 }